@@ -131,7 +131,8 @@ void APP_Initialize(void) {
 
 void APP_Tasks(void) {
 
-
+    //HSM MB Command Queue (queued commands sent as the HSM becomes idle)
+    HSM_Tasks_Secure(); //Secure API
 
     switch (appData.state) {
 
@@ -63,6 +63,7 @@ extern void HSM_INIT_Secure(void);
 extern void HSM_Boot_Firmware_Secure(void);
 extern bool  HSM_Wait_Secure(void);
 extern void HSM_command_Secure(void);
+extern void HSM_Tasks_Secure(void);
 
 
 
@@ -20,8 +20,10 @@
 /* ************************************************************************** */
 
 #include <stdlib.h>
+#include <string.h>
 #include "hsm_app.h"
 #include "aes_test.h"
+#include "hsm_key.h"
 
 /* ************************************************************************** */
 /* ************************************************************************** */
@@ -96,6 +98,108 @@ uint8_t expEncrAesEcbG1T2Msg[MSGG1T2LENBYTES] ={
 
 static uint8_t ALIGN4 encrAesMsg[sizeof (msgAes128)] = {0x00};
 
+//------------------------------------
+// AES CBC Test NIST SP 800-38A F.2.1/F.2.2 (CBC-AES128)
+static uint8_t ALIGN4 keyAesCbc[16] ={
+    0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6,
+    0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c,
+};
+
+static uint8_t ALIGN4 ivAesCbc[16] ={
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+    0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+};
+
+static uint8_t ALIGN4 msgAesCbc[64] ={
+    0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96,
+    0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a,
+    0xae, 0x2d, 0x8a, 0x57, 0x1e, 0x03, 0xac, 0x9c,
+    0x9e, 0xb7, 0x6f, 0xac, 0x45, 0xaf, 0x8e, 0x51,
+    0x30, 0xc8, 0x1c, 0x46, 0xa3, 0x5c, 0xe4, 0x11,
+    0xe5, 0xfb, 0xc1, 0x19, 0x1a, 0x0a, 0x52, 0xef,
+    0xf6, 0x9f, 0x24, 0x45, 0xdf, 0x4f, 0x9b, 0x17,
+    0xad, 0x2b, 0x41, 0x7b, 0xe6, 0x6c, 0x37, 0x10,
+};
+
+static uint8_t ALIGN4 expEncrAesCbcMsg[64] ={
+    0x76, 0x49, 0xab, 0xac, 0x81, 0x19, 0xb2, 0x46,
+    0xce, 0xe9, 0x8e, 0x9b, 0x12, 0xe9, 0x19, 0x7d,
+    0x50, 0x86, 0xcb, 0x9b, 0x50, 0x72, 0x19, 0xee,
+    0x95, 0xdb, 0x11, 0x3a, 0x91, 0x76, 0x78, 0xb2,
+    0x73, 0xbe, 0xd6, 0xb8, 0xe3, 0xc1, 0x74, 0x3b,
+    0x71, 0x16, 0xe6, 0x9e, 0x22, 0x22, 0x95, 0x16,
+    0x3f, 0xf1, 0xca, 0xa1, 0x68, 0x1f, 0xac, 0x09,
+    0x12, 0x0e, 0xca, 0x30, 0x75, 0x86, 0xe1, 0xa7,
+};
+
+static uint8_t ALIGN4 cbcAesMsg[sizeof (msgAesCbc)] = {0x00};
+
+//------------------------------------
+// AES CTR Test NIST SP 800-38A F.5.1/F.5.2 (CTR-AES128)
+// --Key and plain text of the CBC test
+static uint8_t ALIGN4 ivAesCtr[16] ={
+    0xf0, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7,
+    0xf8, 0xf9, 0xfa, 0xfb, 0xfc, 0xfd, 0xfe, 0xff,
+};
+
+static uint8_t ALIGN4 expEncrAesCtrMsg[64] ={
+    0x87, 0x4d, 0x61, 0x91, 0xb6, 0x20, 0xe3, 0x26,
+    0x1b, 0xef, 0x68, 0x64, 0x99, 0x0d, 0xb6, 0xce,
+    0x98, 0x06, 0xf6, 0x6b, 0x79, 0x70, 0xfd, 0xff,
+    0x86, 0x17, 0x18, 0x7b, 0xb9, 0xff, 0xfd, 0xff,
+    0x5a, 0xe4, 0xdf, 0x3e, 0xdb, 0xd5, 0xd3, 0x5e,
+    0x5b, 0x4f, 0x09, 0x02, 0x0d, 0xb0, 0x3e, 0xab,
+    0x1e, 0x03, 0x1d, 0xda, 0x2f, 0xbe, 0x03, 0xd1,
+    0x79, 0x21, 0x70, 0xa0, 0xf3, 0x00, 0x9c, 0xee,
+};
+
+static uint8_t ALIGN4 ctrAesMsg[sizeof (msgAesCbc)] = {0x00};
+
+//------------------------------------
+// AES ECB Batch Test (NIST SP 800-38A F.1.1, key and message of the CBC test)
+static uint8_t ALIGN4 expEncrAesEcbMsg[64] ={
+    0x3a, 0xd7, 0x7b, 0xb4, 0x0d, 0x7a, 0x36, 0x60,
+    0xa8, 0x9e, 0xca, 0xf3, 0x24, 0x66, 0xef, 0x97,
+    0xf5, 0xd3, 0xd5, 0x85, 0x03, 0xb9, 0x69, 0x9d,
+    0xe7, 0x85, 0x89, 0x5a, 0x96, 0xfd, 0xba, 0xaf,
+    0x43, 0xb1, 0xcd, 0x7f, 0x59, 0x8e, 0xce, 0x23,
+    0x88, 0x1b, 0x00, 0xe3, 0xed, 0x03, 0x06, 0x88,
+    0x7b, 0x0c, 0x78, 0x5e, 0x27, 0xe8, 0xad, 0x3f,
+    0x82, 0x23, 0x20, 0x71, 0x04, 0x72, 0x5d, 0xd4,
+};
+
+static uint8_t ALIGN4 batchAesMsg[sizeof (msgAesCbc)] = {0x00};
+
+//------------------------------------
+// AES CBC PKCS#7 Test (first 20 bytes of the CBC test message, in place)
+#define PADAESMSGBYTES  20
+static uint8_t ALIGN4 expEncrAesPadMsg[32] ={
+    0x76, 0x49, 0xab, 0xac, 0x81, 0x19, 0xb2, 0x46,
+    0xce, 0xe9, 0x8e, 0x9b, 0x12, 0xe9, 0x19, 0x7d,
+    0x2e, 0x01, 0x3f, 0x89, 0x04, 0x72, 0xd8, 0x22,
+    0x17, 0xb1, 0x7f, 0x45, 0xf6, 0xe7, 0xf5, 0x39,
+};
+
+static uint8_t ALIGN4 padAesMsg[sizeof (expEncrAesPadMsg)] = {0x00};
+
+//------------------------------------
+// AES Chunked Test (CBC/CTR test message repeated, > 2 HSM_AES_CHUNK_BYTES
+// commands of the default 16 KB).  The first 64 cipher text bytes are the
+// NIST SP 800-38A F.2.1/F.5.1 ones, the last block checks the chaining and
+// the counter over all the chunks (OpenSSL aes-128-cbc/aes-128-ctr).
+#define CHUNKAESMSGBYTES  (2 * 16 * 1024 + sizeof (msgAesCbc))
+static uint8_t ALIGN4 expLastAesCbcChunkMsg[16] ={
+    0x47, 0xeb, 0x46, 0xb1, 0x38, 0xd0, 0x36, 0x9c,
+    0x0d, 0x2e, 0x21, 0xbd, 0x79, 0x73, 0x69, 0x79,
+};
+
+static uint8_t ALIGN4 expLastAesCtrChunkMsg[16] ={
+    0xcb, 0x58, 0x26, 0x8f, 0x87, 0x37, 0x04, 0xd7,
+    0x8f, 0x62, 0x2c, 0x8d, 0x72, 0x63, 0x25, 0x46,
+};
+
+static uint8_t ALIGN4 chunkAesMsg[CHUNKAESMSGBYTES] = {0x00};
+
 //static uint8_t ALIGN4 decrAes128Msg[sizeof(msgAes128)] = { 0x00 };
 
 
@@ -402,6 +506,434 @@ bool TestHsmCmdAes128Ecb(int8_t vsSlotNum) {
 
 } //End HsmCmdHashBlockSha256() 
 
+//******************************************************************************
+// AES CBC Encrypt/Decrypt Command Test (NIST SP 800-38A F.2.1/F.2.2)
+//--Streamed key.  One shot encrypt, then the decrypt fed in two pieces 
+//  (chaining value carried between the calls).
+//--Returns true on FAIL
+//******************************************************************************
+
+bool TestHsmCmdAes128Cbc(void) {
+    RSP_DATA * rsp;
+    HsmAesCbcCtx cbc;
+    int numDataWords = sizeof (msgAesCbc) / 4;
+    bool ret_val = false;
+
+    SYS_PRINT("\r\n---------------------------------------------\r\n");
+    SYS_PRINT("\r\n**HSM AES128 CBC Encryption/Decryption TEST**\r\n");
+
+    //Encrypt (one shot)
+    rsp = HsmCmdAesCbcEncryptDecrypt(0, true, 
+            (uint32_t *) keyAesCbc, CMD_AES_KEY_128, (uint32_t *) ivAesCbc,
+            (uint32_t *) msgAesCbc, (uint32_t *) cbcAesMsg, numDataWords);
+    if (rsp->rspChksPassed != true) {
+        SYS_PRINT("AES CBC FAIL: Encrypt RC: %s\r\n", 
+                CmdResultCodeStr(rsp->resultCode));
+        return true;
+    }
+    if (memcmp(cbcAesMsg, expEncrAesCbcMsg, sizeof (cbcAesMsg)) != 0) {
+        SYS_MESSAGE("AES CBC FAIL: !!!Encrypted MSG ERROR!!!\r\n");
+        ret_val = true;
+    } else {
+        SYS_MESSAGE("AES CBC Pass: Encrypt VALID\r\n");
+    }
+
+    //Decrypt in place (2 pieces)
+    HsmCmdAesCbcInit(&cbc, &gHsmCmdCtx.rspData, 0, false, 
+            (uint32_t *) keyAesCbc, CMD_AES_KEY_128, (uint32_t *) ivAesCbc);
+    rsp = HsmCmdAesCbcUpdateCtx(&gHsmCmdCtx, &cbc, 
+            (uint32_t *) cbcAesMsg, (uint32_t *) cbcAesMsg, numDataWords / 2);
+    if (rsp->rspChksPassed == true) {
+        rsp = HsmCmdAesCbcUpdateCtx(&gHsmCmdCtx, &cbc, 
+                (uint32_t *) &cbcAesMsg[sizeof (cbcAesMsg) / 2], 
+                (uint32_t *) &cbcAesMsg[sizeof (cbcAesMsg) / 2], 
+                numDataWords / 2);
+    }
+    if (rsp->rspChksPassed != true) {
+        SYS_PRINT("AES CBC FAIL: Decrypt RC: %s\r\n", 
+                CmdResultCodeStr(rsp->resultCode));
+        ret_val = true;
+    } else if (memcmp(cbcAesMsg, msgAesCbc, sizeof (cbcAesMsg)) != 0) {
+        SYS_MESSAGE("AES CBC FAIL: !!!Decrypted MSG ERROR!!!\r\n");
+        ret_val = true;
+    } else {
+        SYS_MESSAGE("AES CBC Pass: Decrypt VALID\r\n");
+    }
+
+    SYS_MESSAGE("HSM: CMD_AES CBC Encrypt/Decrypt Complete\r\n");
+
+    return ret_val;
+
+} //End TestHsmCmdAes128Cbc()
+
+
+//******************************************************************************
+// AES CTR Encrypt/Decrypt Command Test (NIST SP 800-38A F.5.1/F.5.2)
+//--Streamed key.  One shot encrypt, then the decrypt in place out of order
+//  at byte offsets that are not on an AES block (HsmCmdAesCtrSeek()).
+//--Returns true on FAIL
+//******************************************************************************
+
+bool TestHsmCmdAes128Ctr(void) {
+    RSP_DATA * rsp;
+    HsmAesCtrCtx ctr;
+    //Decrypt pieces (offset, size):  [37, 64) [5, 37) [0, 5)
+    uint32_t pieceOffset[] = {37, 5, 0};
+    uint32_t pieceBytes[] = {27, 32, 5};
+    bool ret_val = false;
+    int i;
+
+    SYS_PRINT("\r\n---------------------------------------------\r\n");
+    SYS_PRINT("\r\n**HSM AES128 CTR Encryption/Decryption TEST**\r\n");
+
+    //Encrypt (one shot)
+    rsp = HsmCmdAesCtrEncryptDecrypt(0, 
+            (uint32_t *) keyAesCbc, CMD_AES_KEY_128, (uint32_t *) ivAesCtr, 0,
+            msgAesCbc, ctrAesMsg, sizeof (msgAesCbc));
+    if (rsp->rspChksPassed != true) {
+        SYS_PRINT("AES CTR FAIL: Encrypt RC: %s\r\n", 
+                CmdResultCodeStr(rsp->resultCode));
+        return true;
+    }
+    if (memcmp(ctrAesMsg, expEncrAesCtrMsg, sizeof (ctrAesMsg)) != 0) {
+        SYS_MESSAGE("AES CTR FAIL: !!!Encrypted MSG ERROR!!!\r\n");
+        ret_val = true;
+    } else {
+        SYS_MESSAGE("AES CTR Pass: Encrypt VALID\r\n");
+    }
+
+    //Decrypt in place (random access)
+    rsp = HsmCmdAesCtrInit(&ctr, &gHsmCmdCtx.rspData, 0,
+            (uint32_t *) keyAesCbc, CMD_AES_KEY_128, (uint32_t *) ivAesCtr);
+    for (i = 0; i < 3 && !rsp->invArgs; i++) {
+        HsmCmdAesCtrSeek(&ctr, pieceOffset[i]);
+        rsp = HsmCmdAesCtrUpdateCtx(&gHsmCmdCtx, &ctr, 
+                &ctrAesMsg[pieceOffset[i]], &ctrAesMsg[pieceOffset[i]],
+                pieceBytes[i]);
+        if (rsp->rspChksPassed != true) break;
+    }
+    if (rsp->rspChksPassed != true) {
+        SYS_PRINT("AES CTR FAIL: Decrypt RC: %s\r\n", 
+                CmdResultCodeStr(rsp->resultCode));
+        ret_val = true;
+    } else if (memcmp(ctrAesMsg, msgAesCbc, sizeof (ctrAesMsg)) != 0) {
+        SYS_MESSAGE("AES CTR FAIL: !!!Decrypted MSG ERROR!!!\r\n");
+        ret_val = true;
+    } else {
+        SYS_MESSAGE("AES CTR Pass: Decrypt VALID\r\n");
+    }
+
+    SYS_MESSAGE("HSM: CMD_AES CTR Encrypt/Decrypt Complete\r\n");
+
+    return ret_val;
+
+} //End TestHsmCmdAes128Ctr()
+
+
+//******************************************************************************
+// AES ECB Batch Command Test (NIST SP 800-38A F.1.1)
+//--Streamed key.  4 jobs in one batch, one with a bad length (not sent).
+//--Returns true on FAIL
+//******************************************************************************
+
+bool TestHsmCmdAes128EcbBatch(void) {
+    HsmAesJob jobs[4] = {
+        {&msgAesCbc[0],  &batchAesMsg[0],  16, false, E_NULL},
+        {&msgAesCbc[16], &batchAesMsg[16], 32, false, E_NULL},
+        {&msgAesCbc[48], &batchAesMsg[48], 5,  false, E_NULL}, //Bad length
+        {&msgAesCbc[48], &batchAesMsg[48], 16, false, E_NULL},
+    };
+    bool ret_val = false;
+    int i;
+
+    SYS_PRINT("\r\n---------------------------------------------\r\n");
+    SYS_PRINT("\r\n**HSM AES128 ECB Batch Encryption TEST**\r\n");
+
+    HsmCmdAesEcbBatch(0, true, (uint32_t *) keyAesCbc, CMD_AES_KEY_128, 
+            jobs, 4);
+
+    for (i = 0; i < 4; i++) {
+        if ((i == 2 && jobs[i].resultCode != E_INVPARAM) ||
+            (i != 2 && jobs[i].passed != true)) {
+            SYS_PRINT("AES Batch FAIL: Job %d RC: %s\r\n", i,
+                    CmdResultCodeStr(jobs[i].resultCode));
+            ret_val = true;
+        }
+    }
+    if (memcmp(batchAesMsg, expEncrAesEcbMsg, sizeof (batchAesMsg)) != 0) {
+        SYS_MESSAGE("AES Batch FAIL: !!!Encrypted MSG ERROR!!!\r\n");
+        ret_val = true;
+    } else if (!ret_val) {
+        SYS_MESSAGE("AES Batch Pass: Encrypt VALID\r\n");
+    }
+
+    SYS_MESSAGE("HSM: CMD_AES ECB Batch Complete\r\n");
+
+    return ret_val;
+
+} //End TestHsmCmdAes128EcbBatch()
+
+
+//******************************************************************************
+// AES CBC Interleaved Streams Test (NIST SP 800-38A F.2.1)
+//--2 streams of the same message with one HsmAesCbcCtx, the chaining state
+//  of each saved/restored (HsmCmdAesCbcSave()/HsmCmdAesCbcRestore()) between
+//  the 2 halves.
+//--Returns true on FAIL
+//******************************************************************************
+
+bool TestHsmCmdAes128CbcInterleave(void) {
+    RSP_DATA * rsp;
+    HsmAesCbcCtx cbc;
+    HsmAesCtxState state[2];
+    uint8_t * out[2] = {cbcAesMsg, ctrAesMsg};
+    uint32_t half = sizeof (msgAesCbc) / 2;
+    bool ret_val = false;
+    int i;
+    int n;
+
+    SYS_PRINT("\r\n---------------------------------------------\r\n");
+    SYS_PRINT("\r\n**HSM AES128 CBC Interleaved Streams TEST**\r\n");
+
+    rsp = HsmCmdAesCbcInit(&cbc, &gHsmCmdCtx.rspData, 0, true, 
+            (uint32_t *) keyAesCbc, CMD_AES_KEY_128, (uint32_t *) ivAesCbc);
+    HsmCmdAesCbcSave(&cbc, &state[0]);
+    HsmCmdAesCbcSave(&cbc, &state[1]);
+
+    //Stream 0 half 0, stream 1 half 0, stream 0 half 1, stream 1 half 1
+    for (n = 0; n < 4 && !rsp->invArgs; n++) {
+        i = n % 2;
+        HsmCmdAesCbcRestore(&cbc, &state[i]);
+        rsp = HsmCmdAesCbcUpdateCtx(&gHsmCmdCtx, &cbc, 
+                (uint32_t *) &msgAesCbc[(n / 2) * half], 
+                (uint32_t *) &out[i][(n / 2) * half], half / 4);
+        if (rsp->rspChksPassed != true) break;
+        HsmCmdAesCbcSave(&cbc, &state[i]);
+    }
+    if (rsp->rspChksPassed != true) {
+        SYS_PRINT("AES CBC FAIL: Interleave RC: %s\r\n", 
+                CmdResultCodeStr(rsp->resultCode));
+        ret_val = true;
+    } else if (memcmp(out[0], expEncrAesCbcMsg, sizeof (msgAesCbc)) != 0 ||
+               memcmp(out[1], expEncrAesCbcMsg, sizeof (msgAesCbc)) != 0) {
+        SYS_MESSAGE("AES CBC FAIL: !!!Interleaved MSG ERROR!!!\r\n");
+        ret_val = true;
+    } else {
+        SYS_MESSAGE("AES CBC Pass: Interleaved streams VALID\r\n");
+    }
+
+    SYS_MESSAGE("HSM: CMD_AES CBC Interleaved Streams Complete\r\n");
+
+    return ret_val;
+
+} //End TestHsmCmdAes128CbcInterleave()
+
+
+//******************************************************************************
+// AES ECB Key Promotion Test (NIST SP 800-38A F.1.1)
+//--The key pointer is loaded into a VM_STORAGE slot on its 
+//  HSM_KEY_PROMOTE_USES'th use, then the slot key encrypts like the pointer
+//  key.  The slot is empty after HsmKeyForget().
+//--Returns true on FAIL
+//******************************************************************************
+
+bool TestHsmCmdAes128EcbKeySlot(void) {
+    RSP_DATA * rsp;
+    VSMetaData vsMetaData;
+    uint32_t slotSizeBytes;
+    bool ret_val = false;
+    int slot = -1;
+    int i;
+
+    SYS_PRINT("\r\n---------------------------------------------\r\n");
+    SYS_PRINT("\r\n**HSM AES128 ECB Key Promotion TEST**\r\n");
+
+    //Loaded on the last use only
+    for (i = 1; i <= HSM_KEY_PROMOTE_USES; i++) {
+        slot = HsmKeySlot(&gHsmCmdCtx, (uint32_t *) keyAesCbc,
+                CMD_AES_KEY_128, VSS_SK_AES_ECB);
+        if ((i < HSM_KEY_PROMOTE_USES) != (slot < 0)) break;
+    }
+    if (i <= HSM_KEY_PROMOTE_USES || slot < HSM_KEY_SLOT_FIRST ||
+        slot >= HSM_KEY_SLOT_FIRST + HSM_KEY_SLOTS) {
+        SYS_PRINT("AES Key FAIL: Key Slot %d (use %d)\r\n", slot, i);
+        return true;
+    }
+
+    rsp = HsmCmdAesEcbEncryptDecrypt(slot, true, NULL, CMD_AES_KEY_128,
+            (uint32_t *) msgAesCbc, (uint32_t *) batchAesMsg,
+            sizeof (msgAesCbc) / BYTES_PER_WORD);
+    if (rsp->rspChksPassed != true) {
+        SYS_PRINT("AES Key FAIL: Slot %d RC: %s\r\n", slot,
+                CmdResultCodeStr(rsp->resultCode));
+        ret_val = true;
+    } else if (memcmp(batchAesMsg, expEncrAesEcbMsg, sizeof (batchAesMsg)) != 0) {
+        SYS_MESSAGE("AES Key FAIL: !!!Encrypted MSG ERROR!!!\r\n");
+        ret_val = true;
+    } else {
+        SYS_PRINT("AES Key Pass: Slot %d Encrypt VALID\r\n", slot);
+    }
+
+    HsmKeyForget(&gHsmCmdCtx, (uint32_t *) keyAesCbc);
+    if (HsmCmdVsmGetSlotInfoCachedCtx(&gHsmCmdCtx, slot, &vsMetaData,
+            &slotSizeBytes) != E_VSEMPTY) {
+        SYS_PRINT("AES Key FAIL: Slot %d not deleted\r\n", slot);
+        ret_val = true;
+    }
+
+    SYS_MESSAGE("HSM: CMD_AES ECB Key Promotion Complete\r\n");
+
+    return ret_val;
+
+} //End TestHsmCmdAes128EcbKeySlot()
+
+
+//******************************************************************************
+// AES CBC PKCS#7 Padding Test (byte length, in place)
+//--20 bytes are encrypted to 2 blocks and decrypted back to 20 bytes in the 
+//  same buffer.  A corrupted pad byte fails the decrypt with E_INVINPUT.
+//--Returns true on FAIL
+//******************************************************************************
+
+bool TestHsmCmdAes128CbcPad(void) {
+    RSP_DATA * rsp;
+    uint32_t numOutBytes;
+    bool ret_val = false;
+
+    SYS_PRINT("\r\n---------------------------------------------\r\n");
+    SYS_PRINT("\r\n**HSM AES128 CBC PKCS#7 Padding TEST**\r\n");
+
+    memcpy(padAesMsg, msgAesCbc, PADAESMSGBYTES);
+    rsp = HsmCmdAesPadEncryptDecrypt(CMD_AES_CBC, 0, true, 
+            (uint32_t *) keyAesCbc, CMD_AES_KEY_128, (uint32_t *) ivAesCbc,
+            HSM_AES_PAD_PKCS7, padAesMsg, padAesMsg, PADAESMSGBYTES,
+            sizeof (padAesMsg), &numOutBytes);
+    if (rsp->rspChksPassed != true || numOutBytes != sizeof (padAesMsg) ||
+        memcmp(padAesMsg, expEncrAesPadMsg, sizeof (padAesMsg)) != 0) {
+        SYS_PRINT("AES Pad FAIL: Encrypt (%d bytes) RC: %s\r\n",
+                (int) numOutBytes, CmdResultCodeStr(rsp->resultCode));
+        ret_val = true;
+    }
+
+    rsp = HsmCmdAesPadEncryptDecrypt(CMD_AES_CBC, 0, false, 
+            (uint32_t *) keyAesCbc, CMD_AES_KEY_128, (uint32_t *) ivAesCbc,
+            HSM_AES_PAD_PKCS7, padAesMsg, padAesMsg, sizeof (padAesMsg),
+            sizeof (padAesMsg), &numOutBytes);
+    if (rsp->rspChksPassed != true || numOutBytes != PADAESMSGBYTES ||
+        memcmp(padAesMsg, msgAesCbc, PADAESMSGBYTES) != 0) {
+        SYS_PRINT("AES Pad FAIL: Decrypt (%d bytes) RC: %s\r\n",
+                (int) numOutBytes, CmdResultCodeStr(rsp->resultCode));
+        ret_val = true;
+    }
+
+    //Last cipher text byte changed:  the pad bytes are not 0x0c
+    memcpy(padAesMsg, expEncrAesPadMsg, sizeof (padAesMsg));
+    padAesMsg[sizeof (padAesMsg) - 1] ^= 0x01;
+    rsp = HsmCmdAesPadEncryptDecrypt(CMD_AES_CBC, 0, false, 
+            (uint32_t *) keyAesCbc, CMD_AES_KEY_128, (uint32_t *) ivAesCbc,
+            HSM_AES_PAD_PKCS7, padAesMsg, padAesMsg, sizeof (padAesMsg),
+            sizeof (padAesMsg), &numOutBytes);
+    if (rsp->resultCode != E_INVINPUT || numOutBytes != 0) {
+        SYS_PRINT("AES Pad FAIL: Bad padding RC: %s\r\n",
+                CmdResultCodeStr(rsp->resultCode));
+        ret_val = true;
+    }
+
+    if (ret_val == false) {
+        SYS_MESSAGE("AES Pad Pass: PKCS#7 Encrypt/Decrypt VALID\r\n");
+    }
+
+    SYS_MESSAGE("HSM: CMD_AES CBC Padding Complete\r\n");
+
+    return ret_val;
+
+} //End TestHsmCmdAes128CbcPad()
+
+
+//******************************************************************************
+// AES Chunked Data Test (CBC and CTR over 3 HSM_AES_CHUNK_BYTES commands)
+//--Streamed key.  The CBC/CTR test message repeated to CHUNKAESMSGBYTES, 
+//  encrypted in place and checked (first 64 bytes NIST SP 800-38A, last
+//  block), then decrypted in place back to the message.
+//--Returns true on FAIL
+//******************************************************************************
+
+bool TestHsmCmdAes128Chunks(void) {
+    RSP_DATA * rsp;
+    char * modeStr[2] = {"CBC", "CTR"};
+    uint8_t * expFirst[2] = {expEncrAesCbcMsg, expEncrAesCtrMsg};
+    uint8_t * expLast[2] = {expLastAesCbcChunkMsg, expLastAesCtrChunkMsg};
+    uint32_t numDataWords = CHUNKAESMSGBYTES / 4;
+    uint32_t offset;
+    bool ret_val = false;
+    bool encrypt;
+    int mode;
+
+    SYS_PRINT("\r\n---------------------------------------------\r\n");
+    SYS_PRINT("\r\n**HSM AES128 CBC/CTR Chunked Data (%d bytes) TEST**\r\n",
+            (int) CHUNKAESMSGBYTES);
+
+    for (mode = 0; mode < 2; mode++) {
+        for (offset = 0; offset < CHUNKAESMSGBYTES; 
+             offset += sizeof (msgAesCbc)) {
+            memcpy(&chunkAesMsg[offset], msgAesCbc, sizeof (msgAesCbc));
+        }
+
+        //Encrypt, then decrypt in place
+        for (encrypt = true; ; encrypt = false) {
+            if (mode == 0) {
+                rsp = HsmCmdAesCbcEncryptDecrypt(0, encrypt, 
+                        (uint32_t *) keyAesCbc, CMD_AES_KEY_128, 
+                        (uint32_t *) ivAesCbc, (uint32_t *) chunkAesMsg, 
+                        (uint32_t *) chunkAesMsg, numDataWords);
+            } else {
+                rsp = HsmCmdAesCtrEncryptDecrypt(0, 
+                        (uint32_t *) keyAesCbc, CMD_AES_KEY_128, 
+                        (uint32_t *) ivAesCtr, 0, 
+                        chunkAesMsg, chunkAesMsg, CHUNKAESMSGBYTES);
+            }
+            if (rsp->rspChksPassed != true) {
+                SYS_PRINT("AES %s FAIL: %s RC: %s\r\n", modeStr[mode],
+                        encrypt ? "Encrypt" : "Decrypt",
+                        CmdResultCodeStr(rsp->resultCode));
+                ret_val = true;
+                break;
+            }
+            if (!encrypt) break;
+
+            if (memcmp(chunkAesMsg, expFirst[mode], sizeof (msgAesCbc)) != 0 ||
+                memcmp(&chunkAesMsg[CHUNKAESMSGBYTES - AES_BLOCK_BYTES], 
+                       expLast[mode], AES_BLOCK_BYTES) != 0) {
+                SYS_PRINT("AES %s FAIL: !!!Encrypted chunks ERROR!!!\r\n",
+                        modeStr[mode]);
+                ret_val = true;
+            }
+        }
+        if (ret_val) continue;
+
+        for (offset = 0; offset < CHUNKAESMSGBYTES; 
+             offset += sizeof (msgAesCbc)) {
+            if (memcmp(&chunkAesMsg[offset], msgAesCbc, 
+                       sizeof (msgAesCbc)) != 0) {
+                SYS_PRINT("AES %s FAIL: !!!Decrypted chunks ERROR (%d)!!!\r\n",
+                        modeStr[mode], (int) offset);
+                ret_val = true;
+                break;
+            }
+        }
+        if (offset == CHUNKAESMSGBYTES) {
+            SYS_PRINT("AES %s Pass: Chunked Encrypt/Decrypt VALID\r\n",
+                    modeStr[mode]);
+        }
+    }
+
+    SYS_MESSAGE("HSM: CMD_AES Chunked Data Complete\r\n");
+
+    return ret_val;
+
+} //End TestHsmCmdAes128Chunks()
+
+
 /* *****************************************************************************
  End of File
  */
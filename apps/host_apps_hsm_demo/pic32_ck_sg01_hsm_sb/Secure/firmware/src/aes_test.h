@@ -54,6 +54,13 @@ extern "C" {
 
 bool TestHsmCmdAes128Ecb(int8_t vsSlotNum); 
 bool TestHsmCmdAesEcbG1T1(int8_t vsSlotNum); 
+bool TestHsmCmdAes128Cbc(void); 
+bool TestHsmCmdAes128Ctr(void); 
+bool TestHsmCmdAes128EcbBatch(void); 
+bool TestHsmCmdAes128CbcInterleave(void); 
+bool TestHsmCmdAes128EcbKeySlot(void);
+bool TestHsmCmdAes128CbcPad(void);
+bool TestHsmCmdAes128Chunks(void);
 
 /* Provide C++ Compatibility */
 #ifdef __cplusplus
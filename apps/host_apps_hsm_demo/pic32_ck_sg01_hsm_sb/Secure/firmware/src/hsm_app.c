@@ -71,6 +71,15 @@ SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
 #include "kitprotocol_parser/kitprotocol_parser_info.h"
 #include "kitprotocol_parser/kit_hal_interface.h"
 #include "boot.h"
+#include "hsm_queue.h"
+#include "hsm_stats.h"
+#include "hsm_trace.h"
+#include "hsm_timeout.h"
+#include "hsm_sg.h"
+#include "peripheral/cmcc/plib_cmcc.h"
+#include "hsm_dma.h"
+#include "vsm.h"
+#include "hsm_key.h"
 #include "hsm_test_suite.h"
 #define HID_REPORT_PACKET_SIZE_BYTES 64
 
@@ -138,6 +147,32 @@ void HSM_INIT() {
     NVIC_SetPriority(HSM_RXINT_IRQn, 0x1);
     NVIC_EnableIRQ(HSM_RXINT_IRQn);
 
+    //HSM MB Command Queue (interrupt mode commands)
+    HsmCmdQueueInit();
+
+    //HSM MB Command Latency Statistics (DWT CYCCNT)
+    HsmStatsInit();
+
+    //HSM MB Command Timeouts (group defaults until calibrated)
+    HsmTimeoutInit();
+
+    //HSM MB Command Binary Trace (replaces the MB path console output)
+    HsmTraceInit();
+
+    //HSM SG Descriptor Pool (fragmented buffer chains)
+    HsmSGPoolInit();
+
+    //VSM Slot Metadata Cache (HSM slots read again after the HSM reset)
+    HsmCmdVsmSlotCacheInit();
+
+    //AES Key Promotion (promoted VM_STORAGE key slots lost on HSM reset)
+    HsmKeyInit();
+
+    //Data cache (the HSM DMA buffers are kept coherent by hsm_dma.c)
+#if HSM_DMA_DCACHE_ENABLE
+    CMCC_EnableDCache();
+#endif
+
     //Clear COM Receive Data Buffer
     //--Set to 0 so the parsing can detect the EOS
     //--This happens at the end of every HSM command 
@@ -266,6 +301,12 @@ bool HSM_Wait() {
         bootFailed = false;
 #endif //SECURE_BOOT
 
+#if HSM_VSM_SLOT_CACHE_REFRESH
+        //VSM Slot Metadata Cache 
+        SYS_PRINT("VSM Slot Cache: %d slots in use\r\n",
+                HsmCmdVsmSlotCacheRefresh(&gHsmCmdCtx));
+#endif
+
 
 
         SYS_MESSAGE("\r\nRunning HSM MB Command Test Suite\r\n");
@@ -279,6 +320,17 @@ bool HSM_Wait() {
 
 } //End case APP_STATE_IDLE:
 
+/*****************************************************************/
+/***************HSM Tasks (application loop)**********************/
+
+/**********************************************************************/
+
+//HSM MB Command Queue dispatcher:  the next queued command is sent when the
+//HSM is no longer BUSY after the RXINT of the previous one
+void HSM_Tasks() {
+    HsmCmdQueueTasks();
+} //End HSM_Tasks()
+
 void HSM_command() {
     int __attribute__((unused)) retVal = 0;
     int __attribute__((unused)) numDataBytes = 0;
@@ -298,6 +350,18 @@ void HSM_command() {
 
     hsm_test_suite(VSSLOT, AESSLOT);
 
+    //HSM MB command latency, timeouts and trace of the test suite
+#if HSM_STATS_ENABLE
+    SYS_MESSAGE("\r\n");
+    HsmStatsPrint();
+    SYS_PRINT("HSM CMD Timeouts calibrated: %d\r\n", HsmTimeoutCalibrate());
+    HsmTimeoutPrint();
+#endif //HSM_STATS_ENABLE
+#if HSM_TRACE_ENABLE
+    SYS_MESSAGE("\r\nHSM MB Trace (hsm_trace_decode):\r\n");
+    HsmTracePrint();
+#endif //HSM_TRACE_ENABLE
+
     SYS_MESSAGE("\r\n");
     hsmStatus = HSM_REGS->HSM_STATUS;
     GetHsmStatus(&busy, &ecode, &sbs, &lcs, &ps);
@@ -71,6 +71,7 @@ void HSM_INIT(void);
 void HSM_Boot_Firmware(void);
 bool HSM_Wait(void);
 void HSM_command(void);
+void HSM_Tasks(void);
 
 
 
@@ -23,10 +23,12 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include "pic32ck2051sg01144.h"
 #include "core_cm33.h"
 #include "user.h"
 #include "aes.h"
+#include "hsm_key.h"
 
 #ifndef min
 #define min(a, b) (((a) < (b)) ? (a) : (b))
@@ -69,12 +71,324 @@ int aesKeyLength[3] ={
     256,
 };
 
+//Chaining between the chunks of a request (HsmCmdAesChunks())
+typedef enum
+{
+    HSM_AES_CHAIN_NONE   = 0,  //Independent chunks (ECB)
+    HSM_AES_CHAIN_CTX    = 1,  //HSM AES context (param2.useCtx)
+    HSM_AES_CHAIN_IV_OUT = 2,  //IV = last output block (CBC encrypt)
+    HSM_AES_CHAIN_IV_IN  = 3,  //IV = last input block (CBC decrypt)
+    HSM_AES_CHAIN_CTR    = 4,  //IV = counter block + chunk offset (CTR)
+} HsmAesChain;
+
+//Batch command in the HSM (HsmCmdAesEcbBatchCtx())
+typedef struct
+{
+    HsmCmdCtx *  ctx;      //Batch request
+    HsmAesJob *  jobs;     //Jobs of the command
+    int          numJobs;
+} HsmAesBatchCmd;
+
 /* ************************************************************************** */
 /* ************************************************************************** */
 // Section: Local Functions                                                   */
 /* ************************************************************************** */
 /* ************************************************************************** */
 
+//******************************************************************************
+// AES CTR counter block of a block of the key stream
+// --ctrBlock = ctr0 + numBlocks (128 bit big endian counter)
+//******************************************************************************
+static void HsmAesCtrBlock(uint8_t * ctrBlock, const void * ctr0, 
+                           uint32_t numBlocks)
+{
+    uint32_t sum;
+    int      i;
+
+    memcpy(ctrBlock, ctr0, AES_BLOCK_BYTES);
+    for (i = AES_BLOCK_BYTES - 1; i >= 0 && numBlocks != 0; i--)
+    {
+        sum          = ctrBlock[i] + (numBlocks & 0xFF);
+        ctrBlock[i]  = (uint8_t) sum;
+        numBlocks    = (numBlocks >> 8) + (sum >> 8);
+    }
+} //End HsmAesCtrBlock()
+
+
+//******************************************************************************
+// AES command header, MB header and expected response of a request (ctx)
+// --Either a slot # or a key pointer (NULL key --> key of vsSlotNum).
+// --chkSlot:  The slot key is checked with a CMD_VSM_GET_SLOT_INFO command 
+//   (waits for the HSM MB), else the HSM checks it with the command.
+// --The request is not valid if rsp->invArgs or rsp->invSlot are set.
+//******************************************************************************
+static RSP_DATA * HsmCmdAesHdrPrep(HsmCmdCtx *        ctx,
+                                   CmdAesCommandTypes cmdType,
+                                   CmdAesMode         mode,
+                                   int                vsSlotNum,
+                                   uint32_t *         key,
+                                   CmdAesKeySize      keySize,
+                                   bool               chkSlot)
+{
+    CmdAesEcbCommandHeader aesCmdHeader;
+    VSMetaData             vsMetaData;
+    uint32_t               slotInfoBytes;
+    RSP_DATA *             rsp = &ctx->rspData;
+
+    HsmCmdCtxInit(ctx);
+
+    if (keySize != CMD_AES_KEY_128 && keySize != CMD_AES_KEY_192 &&
+        keySize != CMD_AES_KEY_256)
+    {
+        rsp->invArgs = true;
+        return rsp;
+    }
+
+    //AES Command Header
+    aesCmdHeader.v = 0;
+    aesCmdHeader.s.cmdGroup = CMD_AES;
+    aesCmdHeader.s.cmdType  = cmdType;
+    aesCmdHeader.s.aesMode  = mode;
+    aesCmdHeader.s.keySize  = keySize;
+
+    //TODO: Implement Cmd Auth
+    aesCmdHeader.s.authInc = 0;
+    //PrintAesCmd(&aesCmdHeader);
+
+    //Either a slot # is provided or a key pointer is provided.
+    if (vsSlotNum > MINSLOTNUM && vsSlotNum < MAXSLOTNUM && key == NULL) 
+    {
+        aesCmdHeader.s.slotParamInc = 1;
+    } 
+    else if (key != NULL) 
+    {
+        aesCmdHeader.s.slotParamInc = 0;
+    } 
+    else 
+    {
+        rsp->invArgs = true;
+        rsp->invSlot = true;
+        return rsp;
+    }
+
+    //TODO: APL > 0 (AUTH Included)
+    if (aesCmdHeader.s.slotParamInc == 1 && chkSlot) 
+    {
+        int result;
+        HsmCmdCtx slotCtx; //Slot info command (ctx is being built)
+
+        //Slot metadata cache (slot info command only if not cached)
+        result = HsmCmdVsmGetSlotInfoCachedCtx(&slotCtx, vsSlotNum, 
+                                               &vsMetaData, &slotInfoBytes);
+        if ((result != 0) ||
+                (vsMetaData.vsHeader.s.vsSlotNum != vsSlotNum) ||
+                (vsMetaData.vsHeader.s.vsSlotType != VSS_SYMMETRICALKEY) ||
+                (vsMetaData.vsHeader.s.vsStorageInfo.s.apl != 0) ||
+                ((vsMetaData.vsHeader.s.vsStorageInfo.s.storageType != NVM_UNENCRYPTED) &&
+                (vsMetaData.vsHeader.s.vsStorageInfo.s.storageType != VM_STORAGE))) 
+        {
+            //TODO:  Check the slot size
+            rsp->invSlot = true; //Invalid Slot
+            return rsp;
+        }
+    }
+
+    //AES Command 
+    //--No TA/No Slot/No Auth
+    ctx->req.mbHeader  = 0x00200018; //5 Words (No Auth)
+    ctx->req.cmdHeader = aesCmdHeader.v;
+
+    //Expected Response 
+    ctx->req.expMbHeader   = 0x0020000c;
+    ctx->req.expResultCode = S_OK;
+    ctx->req.expStatus     = 0x00000320;
+    ctx->req.expIntFlag    = 0x00000000;
+    ctx->req.expData       = 0x00000000; //TODO: Remove this from API and add to Test
+
+    return rsp;
+} //End HsmCmdAesHdrPrep()
+
+
+//******************************************************************************
+// AES chunk command completion (HsmCmdBankFlush()/HsmCmdBankPrepare())
+// --Accumulate the chunk response checks in the request context: the result 
+//   code is the one of the first failed chunk (or of the last chunk).
+//******************************************************************************
+static void HsmCmdAesChunkDone(HsmCmdCtx * chunkCtx, void * context)
+{
+    HsmCmdCtx * ctx = (HsmCmdCtx *) context;
+
+    if (ctx->rspData.testFailCnt == 0) 
+    {
+        ctx->rsp                = chunkCtx->rsp;
+        ctx->rspData.resultCode = chunkCtx->rspData.resultCode;
+    }
+    ctx->rspData.testFailCnt += chunkCtx->rspData.testFailCnt;
+} //End HsmCmdAesChunkDone()
+
+
+//******************************************************************************
+// Run a prepared AES request over its data in HSM_AES_CHUNK_BYTES commands
+// --ctx:  Request of the whole data (HsmCmdAes*Prep()).  The leading IN 
+//         descriptors (key) are sent with every chunk, the data descriptor
+//         and the size (param1) are set per chunk.
+// --chain:  How the chunks after the first continue from the previous one
+//           (HsmAesChain).  For the IV chaining the last leading IN 
+//           descriptor is the IV.  The decrypt IV is copied before the 
+//           previous chunk is sent, so in place (dataIn == dataOut) works.
+//           The CTR chunks do not depend on each other (counter computed 
+//           from the chunk offset).
+// --Chunk i+1 is built while the HSM runs chunk i.  The commands are sent
+//   in order, so the HSM context chains from chunk to chunk.
+// --ctx->rspData has the accumulated checks, ctx->rsp the response of the 
+//   first failed (or last) chunk.
+//******************************************************************************
+static RSP_DATA * HsmCmdAesChunks(HsmCmdCtx * ctx, 
+                                  uint8_t *   dataIn,
+                                  uint8_t *   dataOut,
+                                  uint32_t    numBytes,
+                                  HsmAesChain chain)
+{
+    HsmCmdBank          bank;
+    HsmCmdCtx *         chunkCtx;
+    CmdAesEcbParameter2 param2;
+    uint32_t ALIGN4     nextIv[AES_BLOCK_BYTES / BYTES_PER_WORD];
+    uint32_t            offset;
+    uint32_t            chunk;
+    uint32_t            maxChunk = HSM_AES_CHUNK_BYTES;
+    int                 numLead = 0;
+    int                 i;
+
+    //Leading IN descriptors (before the data descriptor)
+    while (numLead < HSM_CMD_CTX_SG_DESC - 1 && 
+           ctx->dmaIn[numLead].next.s.stop == 0) 
+    {
+        numLead++;
+    }
+
+    ClearRspData(&ctx->rspData);
+    ctx->rspData.resultCode = S_OK;
+    HsmCmdBankInit(&bank);
+
+    for (offset = 0; offset < numBytes; offset += chunk)
+    {
+        chunk    = min(numBytes - offset, maxChunk);
+        chunkCtx = HsmCmdBankPrepare(&bank);
+
+        HsmCmdCtxInit(chunkCtx);
+        chunkCtx->req = ctx->req;
+        chunkCtx->req.cmdInputs[0]   = (uint32_t) (&(chunkCtx->dmaIn[0]));
+        chunkCtx->req.cmdInputs[1]   = (uint32_t) (&(chunkCtx->dmaOut[0]));
+        chunkCtx->req.cmdInputs[2]   = chunk;
+        chunkCtx->req.expNumDataBytes = chunk;
+        if (chain == HSM_AES_CHAIN_CTX && offset > 0)
+        {
+            param2.v = chunkCtx->req.cmdInputs[3];
+            param2.s.useCtx       = 1;
+            param2.s.resetCtxToIv = 0;
+            chunkCtx->req.cmdInputs[3] = param2.v;
+        }
+
+        for (i = 0; i < numLead; i++)
+        {
+            HsmCmdCtxSetSG(&chunkCtx->dmaIn[i], ctx->dmaIn[i].data.addr,
+                           ctx->dmaIn[i].flagsLength.s.length,
+                           &chunkCtx->dmaIn[i + 1]);
+        }
+
+        //IV of the chunk from the previous chunk
+        if (numLead > 0 && offset > 0)
+        {
+            if (chain == HSM_AES_CHAIN_IV_OUT)
+            {
+                //Written by the previous chunk before this one is sent
+                chunkCtx->dmaIn[numLead - 1].data.addr = 
+                    dataOut + offset - AES_BLOCK_BYTES;
+            }
+            else if (chain == HSM_AES_CHAIN_IV_IN)
+            {
+                memcpy(chunkCtx->cmdData, nextIv, AES_BLOCK_BYTES);
+                chunkCtx->dmaIn[numLead - 1].data.addr = chunkCtx->cmdData;
+            }
+            else if (chain == HSM_AES_CHAIN_CTR)
+            {
+                HsmAesCtrBlock((uint8_t *) chunkCtx->cmdData, 
+                               ctx->dmaIn[numLead - 1].data.addr,
+                               offset / AES_BLOCK_BYTES);
+                chunkCtx->dmaIn[numLead - 1].data.addr = chunkCtx->cmdData;
+            }
+        }
+        if (chain == HSM_AES_CHAIN_IV_IN)
+        {
+            memcpy(nextIv, dataIn + offset + chunk - AES_BLOCK_BYTES, 
+                   AES_BLOCK_BYTES);
+        }
+        HsmCmdCtxSetSG(&chunkCtx->dmaIn[numLead], dataIn + offset, chunk, NULL);
+        HsmCmdCtxSetSG(&chunkCtx->dmaOut[0], dataOut + offset, chunk, NULL);
+
+        //Not sent (HSM stayed BUSY):  completed with HSMBUSYERR
+        if (!HsmCmdBankSubmit(&bank, chunkCtx, HsmCmdAesChunkDone, ctx)) break;
+    }
+
+    HsmCmdBankFlush(&bank);
+
+    ctx->rspData.rspChksPassed = (ctx->rspData.testFailCnt == 0);
+    return &ctx->rspData;
+} //End HsmCmdAesChunks()
+
+
+//******************************************************************************
+// AES CTR key stream block (ctr->ks)
+// --CMD_AES_ECB encryption of the counter block, kept for the next partial
+//   block of the same block #.
+//******************************************************************************
+static bool HsmCmdAesCtrKeyStream(HsmCmdCtx * ctx, 
+                                  HsmAesCtrCtx * ctr, 
+                                  uint32_t block)
+{
+    RSP_DATA * rsp;
+
+    if (ctr->ksValid && ctr->ksBlock == block) return true;
+    ctr->ksValid = false;
+
+    rsp = HsmCmdAesModePrep(ctx, CMD_AES_ECB, ctr->vsSlotNum, true, 
+            ctr->key, ctr->keySize, NULL, false,
+            (uint8_t *) ctx->cmdData, (uint8_t *) ctr->ks, AES_BLOCK_BYTES);
+    if (rsp->invArgs || rsp->invSlot) return false;
+    HsmAesCtrBlock((uint8_t *) ctx->cmdData, ctr->ctr, block);
+
+    HsmCmdCtxExec(ctx);
+    HsmCmdCtxRspChkr(ctx, true);
+    if (!rsp->rspChksPassed) return false;
+
+    ctr->ksBlock = block;
+    ctr->ksValid = true;
+    return true;
+} //End HsmCmdAesCtrKeyStream()
+
+
+//******************************************************************************
+// AES batch command completion (HsmCmdBankFlush()/HsmCmdBankPrepare())
+// --Job status from the command, the SG chains back to the pool.
+//******************************************************************************
+static void HsmCmdAesBatchDone(HsmCmdCtx * cmdCtx, void * context)
+{
+    HsmAesBatchCmd * cmd = (HsmAesBatchCmd *) context;
+    int              i;
+
+    HsmSGChainFree((CmdSGDescriptor *) cmdCtx->req.cmdInputs[0]);
+    HsmSGChainFree((CmdSGDescriptor *) cmdCtx->req.cmdInputs[1]);
+
+    for (i = 0; i < cmd->numJobs; i++)
+    {
+        if (cmd->jobs[i].resultCode == E_INVPARAM) continue;
+        cmd->jobs[i].passed     = cmdCtx->rspData.rspChksPassed;
+        cmd->jobs[i].resultCode = cmdCtx->rspData.resultCode;
+    }
+
+    HsmCmdAesChunkDone(cmdCtx, cmd->ctx);
+} //End HsmCmdAesBatchDone()
+
 /* ************************************************************************** */
 /* ************************************************************************** */
 // Section: Interface Functions                                               */
@@ -98,6 +412,160 @@ void PrintAesCmd(CmdAesEcbCommandHeader * aesEcbCmdHeader) {
 }
 
 
+//******************************************************************************
+//  AES Encrypt/Decrypt Request (CMD_AES_ENCRYPT/CMD_AES_DECRYPT)
+//  NULL key --> use key give by vsSlotNum
+//  --Build the command request in ctx only (not sent, see HsmCmdBankSubmit()).
+//    The request is not valid if rsp->invArgs or rsp->invSlot are set.
+//  --IN SG:  [key] [iv] data.  The key only when given (not a slot key), the
+//    iv (AES_BLOCK_BYTES) only when given.  With neither iv nor useCtx the
+//    HSM starts from the IV stored with the key (resetCtxToIv).
+//  --useCtx:  Continue the HSM AES context (chained modes, slot key)
+//  --A slot key is checked with a CMD_VSM_GET_SLOT_INFO command, which waits 
+//    for the HSM MB.
+//******************************************************************************
+
+RSP_DATA * HsmCmdAesModePrep(
+        HsmCmdCtx * ctx,
+        CmdAesMode mode,
+        int vsSlotNum, //Encryption/Decryption Key
+        bool encrypt, //not decrypt
+        uint32_t * key,
+        CmdAesKeySize keySize,
+        uint32_t * iv,
+        bool useCtx,
+        uint8_t * dataIn,
+        uint8_t * dataOut,
+        uint32_t numDataBytes) {
+    CmdAesEcbParameter1 param1;
+    CmdAesEcbParameter2 param2;
+    RSP_DATA * rsp;
+    uint32_t keyBytes;
+    int numIn = 0;
+
+    rsp = HsmCmdAesHdrPrep(ctx, encrypt ? CMD_AES_ENCRYPT : CMD_AES_DECRYPT,
+            mode, vsSlotNum, key, keySize, true);
+    if (rsp->invArgs || rsp->invSlot) return rsp;
+
+    //keySize checked (HsmCmdAesHdrPrep())
+    keyBytes = aesKeyLength[keySize] / 8;
+
+    //AES Encrypt/Decrypt Parameter1
+    param1.dataSize = numDataBytes;
+
+    param2.v = 0;
+    param2.s.resetCtxToIv = (iv == NULL && !useCtx) ? 1 : 0; //IV stored with Key
+    param2.s.slotIndex = vsSlotNum;
+    param2.s.useCtx = useCtx ? 1 : 0; //Use Context stored (NA for ECB)
+
+    ctx->req.cmdInputs[2] = param1.dataSize;
+    ctx->req.cmdInputs[3] = param2.v;
+
+    //Input SG ([key] [iv] msg)
+    //--Same for Encrypt/Decrypt
+    if (key != NULL) {
+        HsmCmdCtxSetSG(&ctx->dmaIn[numIn], key, keyBytes, 
+                       &ctx->dmaIn[numIn + 1]);
+        numIn++;
+    }
+    if (iv != NULL) {
+        HsmCmdCtxSetSG(&ctx->dmaIn[numIn], iv, AES_BLOCK_BYTES, 
+                       &ctx->dmaIn[numIn + 1]);
+        numIn++;
+    }
+    HsmCmdCtxSetSG(&ctx->dmaIn[numIn], dataIn, numDataBytes, NULL);
+    //SYS_MESSAGE("AES INPUT DATA SG:\r\n");
+    //PrintSG(ctx->dmaIn[0], true);
+
+    //Output (Encrypted/Decrypted Msg)
+    HsmCmdCtxSetSG(&ctx->dmaOut[0], dataOut, numDataBytes, NULL);
+    ctx->req.expNumDataBytes = numDataBytes;
+
+    //Data cache: HsmDmaCmdPrepare()/HsmDmaCmdComplete() (hsm_dma.c)
+
+    return rsp;
+
+} //End HsmCmdAesModePrep()
+
+
+//******************************************************************************
+//  AES ECB Encrypt/Decrypt Mode: CMD_AES_ECB (Electronic Code Book)
+//  NULL key --> use key give by vsSlotNum
+//  --Build the command request in ctx only (not sent, see HsmCmdBankSubmit()).
+//    The request is not valid if rsp->invArgs or rsp->invSlot are set.
+//******************************************************************************
+
+RSP_DATA * HsmCmdAesEcbEncryptDecryptPrep(
+        HsmCmdCtx * ctx,
+        int vsSlotNum, //Encryption/Decryption Key
+        bool encrypt, //not decrypt
+        uint32_t * key,
+        CmdAesKeySize keySize,
+        uint32_t * aesInputDataPtr,
+        uint32_t * aesOutputDataPtr,
+        uint32_t numDataWords) {
+    return HsmCmdAesModePrep(ctx, CMD_AES_ECB, vsSlotNum, encrypt, 
+            key, keySize, NULL, false,
+            (uint8_t *) aesInputDataPtr, (uint8_t *) aesOutputDataPtr,
+            numDataWords*BYTES_PER_WORD);
+} //End HsmCmdAesEcbEncryptDecryptPrep()
+
+
+//******************************************************************************
+//  AES ECB Encrypt/Decrypt Mode: CMD_AES_ECB (Electronic Code Book)
+//  NULL key --> use key give by vsSlotNum
+//  --Command context variant (ctx->rspData has the response check results)
+//  --Data larger than HSM_AES_CHUNK_BYTES is sent in pipelined chunks
+//  --HSM_KEY_PROMOTE:  A key pointer used again is replaced by its VM_STORAGE
+//    slot (HsmKeySlot())
+//******************************************************************************
+
+RSP_DATA * HsmCmdAesEcbEncryptDecryptCtx(
+        HsmCmdCtx * ctx,
+        int vsSlotNum, //Encryption/Decryption Key
+        bool encrypt, //not decrypt
+        uint32_t * key,
+        CmdAesKeySize keySize,
+        uint32_t * aesInputDataPtr,
+        uint32_t * aesOutputDataPtr,
+        uint32_t numDataWords) {
+    RSP_DATA * rsp;
+
+#if HSM_KEY_PROMOTE
+    //Key used again:  key in a VM_STORAGE slot (hsm_key.c), not sent
+    if (key != NULL) {
+        int keySlot = HsmKeySlot(ctx, key, keySize, VSS_SK_AES_ECB);
+
+        if (keySlot > 0) {
+            vsSlotNum = keySlot;
+            key = NULL;
+        }
+    }
+#endif
+
+    rsp = HsmCmdAesEcbEncryptDecryptPrep(ctx, vsSlotNum, encrypt, key, keySize,
+            aesInputDataPtr, aesOutputDataPtr, numDataWords);
+    if (rsp->invArgs || rsp->invSlot) return rsp;
+
+    //Larger data:  HSM_AES_CHUNK_BYTES commands (ECB blocks are independent)
+    if (numDataWords*BYTES_PER_WORD > HSM_AES_CHUNK_BYTES) {
+        return HsmCmdAesChunks(ctx, (uint8_t *) aesInputDataPtr,
+                (uint8_t *) aesOutputDataPtr, 
+                numDataWords*BYTES_PER_WORD, HSM_AES_CHAIN_NONE);
+    }
+
+    //Send HSM Command to HSM MB
+    //PrintAesCmd((CmdAesEcbCommandHeader *)(&ctx->req.cmdHeader));
+    HsmCmdCtxExec(ctx);
+
+    //Check the response/result
+    HsmCmdCtxRspChkr(ctx, true);
+
+    return rsp;
+
+} //End HsmCmdAesEcbEncryptDecryptCtx()
+
+
 //******************************************************************************
 //  AES ECB Encrypt/Decrypt Mode: CMD_AES_ECB (Electronic Code Book)
 //  NULL key --> use key give by vsSlotNum
@@ -111,220 +579,732 @@ RSP_DATA * HsmCmdAesEcbEncryptDecrypt(
         uint32_t * aesInputDataPtr,
         uint32_t * aesOutputDataPtr,
         uint32_t numDataWords) {
-    uint32_t __attribute__((unused)) keySizeBit;
-    VSMetaData vsMetaData;
-    CmdAesEcbCommandHeader aesEcbCmdHeader;
-    CmdAesEcbParameter1 param1;
-    CmdAesEcbParameter2 param2;
-    static RSP_DATA * rsp = &gRspData;
-    uint32_t slotInfoBytes;
+    HsmCmdAesEcbEncryptDecryptCtx(&gHsmCmdCtx, vsSlotNum, encrypt, 
+                                  key, keySize, 
+                                  aesInputDataPtr, aesOutputDataPtr, 
+                                  numDataWords);
+    return HsmCmdCtxPublish(&gHsmCmdCtx);
+} //End HsmCmdAesEcbEncryptDecrypt()
+
 
-    ClearRsp();
+//******************************************************************************
+//  AES Encrypt/Decrypt Request: CMD_AES_ECB (queued)
+//  NULL key --> use key give by vsSlotNum
+//  --Prepared in a command queue entry and sent by the queue dispatcher 
+//    (interrupt mode), callback(ctx, context) on completion (hsm_queue.h).
+//  --The slot key is checked when the request is prepared (polled slot info
+//    command):  do not call from a queue callback.
+//  --Returns false if the queue is full (nothing queued)
+//******************************************************************************
 
-    if (keySize == CMD_AES_KEY_128) keySizeBit = 128;
-    else if (keySize == CMD_AES_KEY_192) keySizeBit = 192;
-    else if (keySize == CMD_AES_KEY_256) keySizeBit = 256;
-    else {
+bool HsmCmdAesEcbEncryptDecryptQueue(
+        int vsSlotNum, //Encryption/Decryption Key
+        bool encrypt, //not decrypt
+        uint32_t * key,
+        CmdAesKeySize keySize,
+        uint32_t * aesInputDataPtr,
+        uint32_t * aesOutputDataPtr,
+        uint32_t numDataWords,
+        HsmCmdQueueCallback callback,
+        void * context) {
+    HsmCmdQueueEntry * entry;
+
+    entry = HsmCmdQueueAlloc();
+    if (entry == NULL) return false;
+
+    HsmCmdAesEcbEncryptDecryptPrep(&entry->ctx, vsSlotNum, encrypt, 
+            key, keySize, aesInputDataPtr, aesOutputDataPtr, numDataWords);
+    HsmCmdQueueSubmit(entry, callback, context);
+
+    return true;
+} //End HsmCmdAesEcbEncryptDecryptQueue()
+
+
+
+//******************************************************************************
+//  AES CBC Encrypt/Decrypt Mode: CMD_AES_CBC (Cipher Block Chaining)
+//  --Start a CBC stream (HsmCmdAesCbcUpdateCtx() for the data)
+//  --iv:  Initial vector (copied), NULL --> IV stored with the slot key.
+//    A key given by pointer needs the iv.
+//  --After the first data the chaining value is kept here (last cipher text
+//    block) and sent with the next data:  CBC streams do not use the HSM 
+//    AES context, so they can be interleaved (HsmCmdAesCbcSave()).
+//******************************************************************************
+
+RSP_DATA * HsmCmdAesCbcInit(
+        HsmAesCbcCtx * cbc,
+        RSP_DATA * rsp,
+        int vsSlotNum, //Encryption/Decryption Key
+        bool encrypt, //not decrypt
+        uint32_t * key,
+        CmdAesKeySize keySize,
+        uint32_t * iv) {
+    ClearRspData(rsp);
+
+    if (key != NULL && iv == NULL) {
         rsp->invArgs = true;
         return rsp;
     }
 
-    //AES ECB Encrypt/Decrypt Header
-    aesEcbCmdHeader.v = 0;
-    aesEcbCmdHeader.s.cmdGroup = CMD_AES;
-    aesEcbCmdHeader.s.aesMode = CMD_AES_ECB;
-    aesEcbCmdHeader.s.keySize = keySize;
+    memset(cbc, 0, sizeof(HsmAesCbcCtx));
+    cbc->vsSlotNum = vsSlotNum;
+    cbc->encrypt = encrypt;
+    cbc->key = key;
+    cbc->keySize = keySize;
+    cbc->hostIv = (iv != NULL);
+    if (iv != NULL) memcpy(cbc->iv, iv, AES_BLOCK_BYTES);
 
-    //TODO: Implement Cmd Auth
-    aesEcbCmdHeader.s.authInc = 0;
-    aesEcbCmdHeader.s.aesMode = CMD_AES_ECB;
-    if (encrypt) aesEcbCmdHeader.s.cmdType = CMD_AES_ENCRYPT;
-    else aesEcbCmdHeader.s.cmdType = CMD_AES_DECRYPT;
-    //PrintAesCmd(&aesEcbCmdHeader);
+    return rsp;
 
-    //Either a slot # is provided or a key pointer is provided.
-    if (vsSlotNum > MINSLOTNUM && vsSlotNum < MAXSLOTNUM && key == NULL) {
-        aesEcbCmdHeader.s.slotParamInc = 1;
-    } else if (key != NULL) {
-        aesEcbCmdHeader.s.slotParamInc = 0;
+} //End HsmCmdAesCbcInit()
+
+
+//******************************************************************************
+//  AES CBC Encrypt/Decrypt Mode: CMD_AES_CBC (Cipher Block Chaining)
+//  --Next data of the CBC stream (numDataWords multiple of 4, AES blocks)
+//  --Continues the chaining from the previous call, data larger than 
+//    HSM_AES_CHUNK_BYTES is sent in pipelined chunks.
+//  --In place (aesInputDataPtr == aesOutputDataPtr) is supported.
+//  --The stream is not advanced when the command fails.
+//******************************************************************************
+
+RSP_DATA * HsmCmdAesCbcUpdateCtx(
+        HsmCmdCtx * ctx,
+        HsmAesCbcCtx * cbc,
+        uint32_t * aesInputDataPtr,
+        uint32_t * aesOutputDataPtr,
+        uint32_t numDataWords) {
+    RSP_DATA * rsp;
+    uint32_t numDataBytes = numDataWords*BYTES_PER_WORD;
+    uint32_t ALIGN4 lastIn[AES_BLOCK_BYTES / BYTES_PER_WORD];
+    HsmAesChain chain;
+
+    rsp = HsmCmdAesModePrep(ctx, CMD_AES_CBC, cbc->vsSlotNum, cbc->encrypt,
+            cbc->key, cbc->keySize, 
+            cbc->hostIv ? cbc->iv : NULL, false,
+            (uint8_t *) aesInputDataPtr, (uint8_t *) aesOutputDataPtr,
+            numDataBytes);
+    if (rsp->invArgs || rsp->invSlot) return rsp;
+
+    if (numDataBytes == 0 || (numDataBytes % AES_BLOCK_BYTES) != 0) {
+        rsp->invArgs = true;
+        return rsp;
+    }
+
+    //Decrypt chaining value (before an in place decrypt overwrites it)
+    memcpy(lastIn, (uint8_t *) aesInputDataPtr + numDataBytes - AES_BLOCK_BYTES,
+           AES_BLOCK_BYTES);
+
+    if (numDataBytes > HSM_AES_CHUNK_BYTES) {
+        if (!cbc->hostIv) chain = HSM_AES_CHAIN_CTX;
+        else if (cbc->encrypt) chain = HSM_AES_CHAIN_IV_OUT;
+        else chain = HSM_AES_CHAIN_IV_IN;
+
+        HsmCmdAesChunks(ctx, (uint8_t *) aesInputDataPtr,
+                (uint8_t *) aesOutputDataPtr, numDataBytes, chain);
     } else {
+        HsmCmdCtxExec(ctx);
+        HsmCmdCtxRspChkr(ctx, true);
+    }
+
+    if (!rsp->rspChksPassed) return rsp;
+
+    //Next chaining value (also after the slot IV)
+    cbc->started = true;
+    cbc->hostIv = true;
+    memcpy(cbc->iv, cbc->encrypt ? 
+           (uint8_t *) aesOutputDataPtr + numDataBytes - AES_BLOCK_BYTES :
+           (uint8_t *) lastIn, AES_BLOCK_BYTES);
+
+    return rsp;
+
+} //End HsmCmdAesCbcUpdateCtx()
+
+
+//******************************************************************************
+//  AES CBC Encrypt/Decrypt Mode: CMD_AES_CBC (Cipher Block Chaining)
+//  --Export the chaining state of the stream (not the key)
+//  --One HsmAesCbcCtx (key/direction) can carry many streams, each with its 
+//    saved state: HsmCmdAesCbcRestore() before its next data.
+//******************************************************************************
+
+void HsmCmdAesCbcSave(const HsmAesCbcCtx * cbc, HsmAesCtxState * state) {
+    memset(state, 0, sizeof(HsmAesCtxState));
+    state->mode = CMD_AES_CBC;
+    state->ivValid = cbc->hostIv;
+    memcpy(state->iv, cbc->iv, AES_BLOCK_BYTES);
+} //End HsmCmdAesCbcSave()
+
+
+//******************************************************************************
+//  AES CBC Encrypt/Decrypt Mode: CMD_AES_CBC (Cipher Block Chaining)
+//  --Import a chaining state (HsmCmdAesCbcSave()).  false if not a CBC state.
+//******************************************************************************
+
+bool HsmCmdAesCbcRestore(HsmAesCbcCtx * cbc, const HsmAesCtxState * state) {
+    if (state->mode != CMD_AES_CBC) return false;
+
+    cbc->hostIv = state->ivValid;
+    cbc->started = state->ivValid;
+    memcpy(cbc->iv, state->iv, AES_BLOCK_BYTES);
+    return true;
+} //End HsmCmdAesCbcRestore()
+
+
+//******************************************************************************
+//  AES CBC Encrypt/Decrypt Mode: CMD_AES_CBC (Cipher Block Chaining)
+//  NULL key --> use key give by vsSlotNum
+//  NULL iv  --> use the IV stored with the slot key
+//  --One shot (HsmCmdAesCbcInit()/HsmCmdAesCbcUpdateCtx() for a stream)
+//******************************************************************************
+
+RSP_DATA * HsmCmdAesCbcEncryptDecrypt(
+        int vsSlotNum, //Encryption/Decryption Key
+        bool encrypt, //not decrypt
+        uint32_t * key,
+        CmdAesKeySize keySize,
+        uint32_t * iv,
+        uint32_t * aesInputDataPtr,
+        uint32_t * aesOutputDataPtr,
+        uint32_t numDataWords) {
+    HsmAesCbcCtx cbc;
+
+    HsmCmdAesCbcInit(&cbc, &gHsmCmdCtx.rspData, vsSlotNum, encrypt, 
+                     key, keySize, iv);
+    if (!gHsmCmdCtx.rspData.invArgs) {
+        HsmCmdAesCbcUpdateCtx(&gHsmCmdCtx, &cbc, 
+                              aesInputDataPtr, aesOutputDataPtr, 
+                              numDataWords);
+    }
+    return HsmCmdCtxPublish(&gHsmCmdCtx);
+} //End HsmCmdAesCbcEncryptDecrypt()
+
+
+
+//******************************************************************************
+//  AES ECB/CBC Encrypt/Decrypt with padding (byte length data)
+//  NULL key --> use key give by vsSlotNum
+//  NULL iv  --> (CBC) use the IV stored with the slot key
+//  --Encrypt:  The last partial block is padded (HsmAesPadding), the output
+//    is numDataBytes rounded up to AES blocks (PKCS#7: one more block when 
+//    numDataBytes is a block multiple).  The padded last block is built in
+//    a block buffer here, the caller data is not copied:  the whole blocks
+//    and the last block are one command IN chain (SG pool), or 2 commands
+//    for data larger than HSM_AES_CHUNK_BYTES.
+//  --Decrypt:  numDataBytes is a block multiple.  The PKCS#7 padding is
+//    checked (constant time, E_INVINPUT) and not counted in *numOutBytes.
+//  --In place (dataIn == dataOut, buffer of maxOutBytes) is supported, other
+//    overlaps are invalid.  The output is read back through 
+//    HsmDmaCmdComplete() (hsm_dma.c) like any other command output.
+//******************************************************************************
+
+RSP_DATA * HsmCmdAesPadEncryptDecryptCtx(
+        HsmCmdCtx * ctx,
+        CmdAesMode mode,
+        int vsSlotNum, //Encryption/Decryption Key
+        bool encrypt, //not decrypt
+        uint32_t * key,
+        CmdAesKeySize keySize,
+        uint32_t * iv,
+        HsmAesPadding padding,
+        uint8_t * dataIn,
+        uint8_t * dataOut,
+        uint32_t numDataBytes,
+        uint32_t maxOutBytes,
+        uint32_t * numOutBytes) {
+    RSP_DATA * rsp = &ctx->rspData;
+    HsmAesCbcCtx cbc;
+    HsmSGSegment seg[4];
+    CmdSGDescriptor * sgIn = NULL;
+    uint32_t ALIGN4 lastBlk[AES_BLOCK_BYTES / BYTES_PER_WORD];
+    uint32_t tail = numDataBytes % AES_BLOCK_BYTES;
+    uint32_t whole = numDataBytes - tail;
+    uint32_t padBytes = 0;
+    uint32_t outBytes;
+    uint8_t padLen;
+    uint8_t diff;
+    uint32_t i;
+    int n = 0;
+
+    *numOutBytes = 0;
+    ClearRspData(rsp);
+
+    if (encrypt && (padding == HSM_AES_PAD_PKCS7 ||
+                    (padding == HSM_AES_PAD_ZERO && tail > 0))) {
+        padBytes = AES_BLOCK_BYTES - tail;
+    }
+    outBytes = numDataBytes + padBytes;
+
+    if ((mode != CMD_AES_ECB && mode != CMD_AES_CBC) ||
+            outBytes == 0 || (outBytes % AES_BLOCK_BYTES) != 0 ||
+            outBytes > maxOutBytes ||
+            (dataOut != dataIn && dataOut < dataIn + numDataBytes &&
+             dataIn < dataOut + outBytes)) {
         rsp->invArgs = true;
-        rsp->invSlot = true;
         return rsp;
     }
 
-    //TODO: APL > 0 (AUTH Included)
-    if (aesEcbCmdHeader.s.slotParamInc == 1) {
-        int result;
-        result = HsmCmdVsmGetSlotInfo(vsSlotNum, &vsMetaData, &slotInfoBytes);
-        if ((result != 0) ||
-                (vsMetaData.vsHeader.s.vsSlotNum != vsSlotNum) ||
-                (vsMetaData.vsHeader.s.vsSlotType != VSS_SYMMETRICALKEY) ||
-                (vsMetaData.vsHeader.s.vsStorageInfo.s.apl != 0) ||
-                ((vsMetaData.vsHeader.s.vsStorageInfo.s.storageType != NVM_UNENCRYPTED) &&
-                (vsMetaData.vsHeader.s.vsStorageInfo.s.storageType != VM_STORAGE))) {
-            //TODO:  Check the slot size
-            rsp->invSlot = true; //Invalid Slot
+    if (mode == CMD_AES_CBC) {
+        HsmCmdAesCbcInit(&cbc, rsp, vsSlotNum, encrypt, key, keySize, iv);
+        if (rsp->invArgs) return rsp;
+    }
+
+    if (padBytes == 0) {
+        //Block multiple:  contiguous data
+        if (mode == CMD_AES_CBC) {
+            HsmCmdAesCbcUpdateCtx(ctx, &cbc, (uint32_t *) dataIn,
+                    (uint32_t *) dataOut, outBytes / BYTES_PER_WORD);
+        } else {
+            HsmCmdAesEcbEncryptDecryptCtx(ctx, vsSlotNum, encrypt, key, 
+                    keySize, (uint32_t *) dataIn, (uint32_t *) dataOut,
+                    outBytes / BYTES_PER_WORD);
+        }
+    } else {
+        //Padded last block (before an in place command overwrites the tail)
+        memcpy(lastBlk, dataIn + whole, tail);
+        memset((uint8_t *) lastBlk + tail, 
+               (padding == HSM_AES_PAD_PKCS7) ? padBytes : 0, padBytes);
+
+        //One command:  IN [key] [iv] whole blocks, last block
+        if (whole > 0 && outBytes <= HSM_AES_CHUNK_BYTES) {
+            HsmCmdAesModePrep(ctx, mode, vsSlotNum, true, key, keySize,
+                    (mode == CMD_AES_CBC) ? iv : NULL, false,
+                    dataIn, dataOut, outBytes);
+            if (rsp->invArgs || rsp->invSlot) return rsp;
+
+            if (key != NULL) {
+                seg[n].addr = key;
+                seg[n++].numBytes = aesKeyLength[keySize] / 8;
+            }
+            if (mode == CMD_AES_CBC && iv != NULL) {
+                seg[n].addr = iv;
+                seg[n++].numBytes = AES_BLOCK_BYTES;
+            }
+            seg[n].addr = dataIn;
+            seg[n++].numBytes = whole;
+            seg[n].addr = lastBlk;
+            seg[n++].numBytes = AES_BLOCK_BYTES;
+            sgIn = HsmSGChainAlloc(seg, n);
+        }
+
+        if (sgIn != NULL) {
+            HsmSGCtxSet(ctx, sgIn, NULL);
+            HsmCmdCtxExec(ctx);
+            HsmSGChainFree(sgIn);
+            HsmCmdCtxRspChkr(ctx, true);
+        } else {
+            //2 commands (large data, or no SG pool descriptors)
+            if (mode == CMD_AES_CBC) {
+                if (whole > 0) {
+                    HsmCmdAesCbcUpdateCtx(ctx, &cbc, (uint32_t *) dataIn,
+                            (uint32_t *) dataOut, whole / BYTES_PER_WORD);
+                }
+                if (whole == 0 || rsp->rspChksPassed) {
+                    HsmCmdAesCbcUpdateCtx(ctx, &cbc, lastBlk,
+                            (uint32_t *) (dataOut + whole),
+                            AES_BLOCK_BYTES / BYTES_PER_WORD);
+                }
+            } else {
+                if (whole > 0) {
+                    HsmCmdAesEcbEncryptDecryptCtx(ctx, vsSlotNum, true, key,
+                            keySize, (uint32_t *) dataIn, 
+                            (uint32_t *) dataOut, whole / BYTES_PER_WORD);
+                }
+                if (whole == 0 || rsp->rspChksPassed) {
+                    HsmCmdAesEcbEncryptDecryptCtx(ctx, vsSlotNum, true, key,
+                            keySize, lastBlk, (uint32_t *) (dataOut + whole),
+                            AES_BLOCK_BYTES / BYTES_PER_WORD);
+                }
+            }
+        }
+        memset(lastBlk, 0, sizeof(lastBlk));
+    }
+
+    if (rsp->invArgs || rsp->invSlot || !rsp->rspChksPassed) return rsp;
+
+    //Decrypt:  Check and remove the PKCS#7 padding
+    if (!encrypt && padding == HSM_AES_PAD_PKCS7) {
+        padLen = dataOut[outBytes - 1];
+        diff = (padLen == 0) | (padLen > AES_BLOCK_BYTES);
+        for (i = 1; i <= AES_BLOCK_BYTES; i++) {
+            diff |= (i <= padLen) & (dataOut[outBytes - i] != padLen);
+        }
+        if (diff != 0) {
+            rsp->rspChksPassed = false;
+            rsp->testFailCnt++;
+            rsp->resultCode = E_INVINPUT;
             return rsp;
         }
-    };
-    //PrintAesCmd(&aesEcbCmdHeader);
+        outBytes -= padLen;
+    }
+
+    *numOutBytes = outBytes;
+    return rsp;
 
-    //AES ECB Encrypt/Decrypt Parameter1
-    param1.dataSize = numDataWords*BYTES_PER_WORD;
+} //End HsmCmdAesPadEncryptDecryptCtx()
 
-    param2.v = 0;
-    param2.s.resetCtxToIv = 1; //Reset Context to IV stored with Key
-    param2.s.slotIndex = vsSlotNum;
-    param2.s.useCtx = 0; //Use Context stored input (NA for ECB)
 
+//******************************************************************************
+//  AES ECB/CBC Encrypt/Decrypt with padding (byte length data)
+//  --See HsmCmdAesPadEncryptDecryptCtx()
+//******************************************************************************
+
+RSP_DATA * HsmCmdAesPadEncryptDecrypt(
+        CmdAesMode mode,
+        int vsSlotNum, //Encryption/Decryption Key
+        bool encrypt, //not decrypt
+        uint32_t * key,
+        CmdAesKeySize keySize,
+        uint32_t * iv,
+        HsmAesPadding padding,
+        uint8_t * dataIn,
+        uint8_t * dataOut,
+        uint32_t numDataBytes,
+        uint32_t maxOutBytes,
+        uint32_t * numOutBytes) {
+    HsmCmdAesPadEncryptDecryptCtx(&gHsmCmdCtx, mode, vsSlotNum, encrypt,
+            key, keySize, iv, padding, dataIn, dataOut, numDataBytes, 
+            maxOutBytes, numOutBytes);
+    return HsmCmdCtxPublish(&gHsmCmdCtx);
+} //End HsmCmdAesPadEncryptDecrypt()
 
-    // Make sure the HSM is not busy
-    while (HSM_REGS->HSM_STATUS & HSM_STATUS_BUSY_Msk);
 
-    //Send AES ECB Encrypt/Decrypt Command 
-    //--No TA/No Slot/No Auth
-    gHsmCmdReq.mbHeader = 0x00200018; //5 Words (No Auth)
-    gHsmCmdReq.cmdHeader = aesEcbCmdHeader.v;
-    gHsmCmdReq.cmdInputs[0] = (uint32_t) (&(dmaDescriptorIn[0]));
-    gHsmCmdReq.cmdInputs[1] = (uint32_t) (&(dmaDescriptorOut[0]));
-
-    gHsmCmdReq.cmdInputs[2] = param1.dataSize;
-    gHsmCmdReq.cmdInputs[3] = param2.v;
-
-    if (encrypt == true) {
-        if (aesEcbCmdHeader.s.slotParamInc == 1) {
-            //Input SG (slotParamInc -> msg,  else key)
-            dmaDescriptorIn[0].data.addr = key;
-            dmaDescriptorIn[0].next.s.stop = 0;
-            dmaDescriptorIn[0].next.s.addr = (uint32_t) & dmaDescriptorIn[1];
-            dmaDescriptorIn[0].flagsLength.s.length = (unsigned int) keySizeBit / 8;
-            dmaDescriptorIn[0].flagsLength.s.cstAddr = 0;
-            dmaDescriptorIn[0].flagsLength.s.discard = 0;
-            dmaDescriptorIn[0].flagsLength.s.realign = 1;
-            dmaDescriptorIn[0].flagsLength.s.intEn = 0;
-            //SYS_MESSAGE("VSM INPUT DATA SG:\r\n");
-            //PrintSG(dmaDescriptorIn[0], true);
-
-            //Input SG Msg
-            dmaDescriptorIn[1].data.addr = aesInputDataPtr;
-            dmaDescriptorIn[1].next.s.stop = 1;
-            dmaDescriptorIn[1].next.s.addr = 0;
-            dmaDescriptorIn[1].flagsLength.s.length =
-                    (unsigned int) numDataWords*BYTES_PER_WORD;
-            dmaDescriptorIn[1].flagsLength.s.cstAddr = 0;
-            dmaDescriptorIn[1].flagsLength.s.discard = 0;
-            dmaDescriptorIn[1].flagsLength.s.realign = 1;
-            dmaDescriptorIn[1].flagsLength.s.intEn = 0;
-            //SYS_MESSAGE("VSM INPUT DATA SG:\r\n");
-            //PrintSG(dmaDescriptorIn[0], true);
+
+//******************************************************************************
+//  AES CTR Encrypt/Decrypt Mode: CMD_AES_CTR (Counter)
+//  --Start a CTR stream at key stream offset 0 (HsmCmdAesCtrUpdateCtx() for
+//    the data, HsmCmdAesCtrSeek() to move in the stream)
+//  --iv:  Initial counter block (copied, required), incremented as a 128 bit
+//    big endian number per AES block.  The counter is kept here, so the 
+//    stream can be positioned anywhere.
+//******************************************************************************
+
+RSP_DATA * HsmCmdAesCtrInit(
+        HsmAesCtrCtx * ctr,
+        RSP_DATA * rsp,
+        int vsSlotNum, //Encryption/Decryption Key
+        uint32_t * key,
+        CmdAesKeySize keySize,
+        uint32_t * iv) {
+    ClearRspData(rsp);
+
+    if (iv == NULL) {
+        rsp->invArgs = true;
+        return rsp;
+    }
+
+    memset(ctr, 0, sizeof(HsmAesCtrCtx));
+    ctr->vsSlotNum = vsSlotNum;
+    ctr->key = key;
+    ctr->keySize = keySize;
+    memcpy(ctr->ctr, iv, AES_BLOCK_BYTES);
+
+    return rsp;
+
+} //End HsmCmdAesCtrInit()
+
+
+//******************************************************************************
+//  AES CTR Encrypt/Decrypt Mode: CMD_AES_CTR (Counter)
+//  --Key stream byte offset of the next data (any offset, random access)
+//******************************************************************************
+
+void HsmCmdAesCtrSeek(HsmAesCtrCtx * ctr, uint32_t offset) {
+    ctr->offset = offset;
+} //End HsmCmdAesCtrSeek()
+
+
+//******************************************************************************
+//  AES CTR Encrypt/Decrypt Mode: CMD_AES_CTR (Counter)
+//  --Next data of the CTR stream, any number of bytes (encrypt == decrypt)
+//  --The whole blocks are sent as one CMD_AES_CTR request (pipelined chunks
+//    above HSM_AES_CHUNK_BYTES), the partial blocks at the start and the end
+//    are XORed here with the block key stream (HsmCmdAesCtrKeyStream()).
+//  --In place (dataIn == dataOut) is supported.
+//  --The stream is not advanced when a command fails.
+//******************************************************************************
+
+RSP_DATA * HsmCmdAesCtrUpdateCtx(
+        HsmCmdCtx * ctx,
+        HsmAesCtrCtx * ctr,
+        uint8_t * dataIn,
+        uint8_t * dataOut,
+        uint32_t numDataBytes) {
+    RSP_DATA * rsp = &ctx->rspData;
+    uint32_t ALIGN4 ctrBlock[AES_BLOCK_BYTES / BYTES_PER_WORD];
+    uint32_t offset = ctr->offset;
+    uint32_t done = 0;
+    uint32_t ksOffset;
+    uint32_t n;
+    uint32_t i;
+
+    //No command sent (key stream of the previous call)
+    ClearRspData(rsp);
+    rsp->resultCode = S_OK;
+    rsp->rspChksPassed = true;
+
+    while (done < numDataBytes) {
+        ksOffset = offset % AES_BLOCK_BYTES;
+        n = numDataBytes - done;
+
+        if (ksOffset == 0 && n >= AES_BLOCK_BYTES) {
+            //Whole blocks:  CMD_AES_CTR from the counter of the first one
+            n -= n % AES_BLOCK_BYTES;
+            HsmAesCtrBlock((uint8_t *) ctrBlock, ctr->ctr, 
+                           offset / AES_BLOCK_BYTES);
+
+            rsp = HsmCmdAesModePrep(ctx, CMD_AES_CTR, ctr->vsSlotNum, true,
+                    ctr->key, ctr->keySize, ctrBlock, false,
+                    dataIn + done, dataOut + done, n);
+            if (rsp->invArgs || rsp->invSlot) return rsp;
+
+            if (n > HSM_AES_CHUNK_BYTES) {
+                HsmCmdAesChunks(ctx, dataIn + done, dataOut + done, n,
+                        HSM_AES_CHAIN_CTR);
+            } else {
+                HsmCmdCtxExec(ctx);
+                HsmCmdCtxRspChkr(ctx, true);
+            }
+            if (!rsp->rspChksPassed) return rsp;
         } else {
-            //Input SG Msg
-            dmaDescriptorIn[0].data.addr = aesInputDataPtr;
-            dmaDescriptorIn[0].next.s.stop = 1;
-            dmaDescriptorIn[0].next.s.addr = 0;
-            dmaDescriptorIn[0].flagsLength.s.length =
-                    (unsigned int) numDataWords*BYTES_PER_WORD;
-            dmaDescriptorIn[0].flagsLength.s.cstAddr = 0;
-            dmaDescriptorIn[0].flagsLength.s.discard = 0;
-            dmaDescriptorIn[0].flagsLength.s.realign = 1;
-            dmaDescriptorIn[0].flagsLength.s.intEn = 0;
-            //SYS_MESSAGE("VSM INPUT DATA SG:\r\n");
-            //PrintSG(dmaDescriptorIn[0], true);
+            //Partial block
+            n = min(n, AES_BLOCK_BYTES - ksOffset);
+            if (!HsmCmdAesCtrKeyStream(ctx, ctr, offset / AES_BLOCK_BYTES)) {
+                return rsp;
+            }
+            for (i = 0; i < n; i++) {
+                dataOut[done + i] = dataIn[done + i] ^ 
+                                    ((uint8_t *) ctr->ks)[ksOffset + i];
+            }
         }
 
-        //Output (Encrypted Msg)
-        dmaDescriptorOut[0].data.addr = aesOutputDataPtr;
-        dmaDescriptorOut[0].next.s.stop = 1;
-        dmaDescriptorOut[0].next.s.addr = 0;
-        dmaDescriptorOut[0].flagsLength.s.length =
-                (unsigned int) numDataWords*BYTES_PER_WORD;
-        dmaDescriptorOut[0].flagsLength.s.cstAddr = 0;
-        dmaDescriptorOut[0].flagsLength.s.discard = 0;
-        dmaDescriptorOut[0].flagsLength.s.realign = 1;
-        dmaDescriptorOut[0].flagsLength.s.intEn = 0;
-    } else {
-        //DeCrypt
-        if (aesEcbCmdHeader.s.slotParamInc == 1) {
-            //Input SG (slotParamInc -> msg,  else key)
-            dmaDescriptorIn[0].data.addr = key;
-            dmaDescriptorIn[0].next.s.stop = 0;
-            dmaDescriptorIn[0].next.s.addr =
-                    (uint32_t) & dmaDescriptorIn[1];
-            dmaDescriptorIn[0].flagsLength.s.length =
-                    (unsigned int) keySizeBit / 8;
-            dmaDescriptorIn[0].flagsLength.s.cstAddr = 0;
-            dmaDescriptorIn[0].flagsLength.s.discard = 0;
-            dmaDescriptorIn[0].flagsLength.s.realign = 1;
-            dmaDescriptorIn[0].flagsLength.s.intEn = 0;
-            //SYS_MESSAGE("VSM INPUT DATA SG:\r\n");
-            //PrintSG(dmaDescriptorIn[0], true);
-
-            //Input SG Msg
-            dmaDescriptorIn[1].data.addr = aesInputDataPtr;
-            dmaDescriptorIn[1].next.s.stop = 1;
-            dmaDescriptorIn[1].next.s.addr = 0;
-            dmaDescriptorIn[1].flagsLength.s.length =
-                    (unsigned int) numDataWords*BYTES_PER_WORD;
-            dmaDescriptorIn[1].flagsLength.s.cstAddr = 0;
-            dmaDescriptorIn[1].flagsLength.s.discard = 0;
-            dmaDescriptorIn[1].flagsLength.s.realign = 1;
-            dmaDescriptorIn[1].flagsLength.s.intEn = 0;
-            //SYS_MESSAGE("VSM INPUT DATA SG:\r\n");
-            //PrintSG(dmaDescriptorIn[0], true);
-        } else {
-            //Input SG Msg
-            dmaDescriptorIn[0].data.addr = aesInputDataPtr;
-            dmaDescriptorIn[0].next.s.stop = 1;
-            dmaDescriptorIn[0].next.s.addr = 0;
-            dmaDescriptorIn[0].flagsLength.s.length =
-                    (unsigned int) numDataWords*BYTES_PER_WORD;
-            dmaDescriptorIn[0].flagsLength.s.cstAddr = 0;
-            dmaDescriptorIn[0].flagsLength.s.discard = 0;
-            dmaDescriptorIn[0].flagsLength.s.realign = 1;
-            dmaDescriptorIn[0].flagsLength.s.intEn = 0;
-            //SYS_MESSAGE("VSM INPUT DATA SG:\r\n");
-            //PrintSG(dmaDescriptorIn[0], true);
+        offset += n;
+        done += n;
+    }
+
+    ctr->offset = offset;
+    return rsp;
+
+} //End HsmCmdAesCtrUpdateCtx()
+
+
+//******************************************************************************
+//  AES CTR Encrypt/Decrypt Mode: CMD_AES_CTR (Counter)
+//  --Export the counter state of the stream (not the key)
+//******************************************************************************
+
+void HsmCmdAesCtrSave(const HsmAesCtrCtx * ctr, HsmAesCtxState * state) {
+    memset(state, 0, sizeof(HsmAesCtxState));
+    state->mode = CMD_AES_CTR;
+    state->ivValid = true;
+    state->offset = ctr->offset;
+    memcpy(state->iv, ctr->ctr, AES_BLOCK_BYTES);
+} //End HsmCmdAesCtrSave()
+
+
+//******************************************************************************
+//  AES CTR Encrypt/Decrypt Mode: CMD_AES_CTR (Counter)
+//  --Import a counter state (HsmCmdAesCtrSave()).  false if not a CTR state.
+//******************************************************************************
+
+bool HsmCmdAesCtrRestore(HsmAesCtrCtx * ctr, const HsmAesCtxState * state) {
+    if (state->mode != CMD_AES_CTR) return false;
+
+    memcpy(ctr->ctr, state->iv, AES_BLOCK_BYTES);
+    ctr->offset = state->offset;
+    ctr->ksValid = false;
+    return true;
+} //End HsmCmdAesCtrRestore()
+
+
+//******************************************************************************
+//  AES CTR Encrypt/Decrypt Mode: CMD_AES_CTR (Counter)
+//  NULL key --> use key give by vsSlotNum
+//  --One shot from the key stream byte offset (HsmCmdAesCtrInit()/
+//    HsmCmdAesCtrUpdateCtx() for a stream)
+//******************************************************************************
+
+RSP_DATA * HsmCmdAesCtrEncryptDecrypt(
+        int vsSlotNum, //Encryption/Decryption Key
+        uint32_t * key,
+        CmdAesKeySize keySize,
+        uint32_t * iv,
+        uint32_t offset,
+        uint8_t * dataIn,
+        uint8_t * dataOut,
+        uint32_t numDataBytes) {
+    HsmAesCtrCtx ctr;
+
+    HsmCmdAesCtrInit(&ctr, &gHsmCmdCtx.rspData, vsSlotNum, 
+                     key, keySize, iv);
+    if (!gHsmCmdCtx.rspData.invArgs) {
+        HsmCmdAesCtrSeek(&ctr, offset);
+        HsmCmdAesCtrUpdateCtx(&gHsmCmdCtx, &ctr, dataIn, dataOut, 
+                              numDataBytes);
+    }
+    return HsmCmdCtxPublish(&gHsmCmdCtx);
+} //End HsmCmdAesCtrEncryptDecrypt()
+
+
+
+//******************************************************************************
+//  AES ECB Encrypt/Decrypt Batch: CMD_AES_ECB
+//  NULL key --> use key give by vsSlotNum
+//  --Independent jobs (in, out, length) with the same key, e.g. small 
+//    records.  Up to HSM_AES_BATCH_JOBS jobs (HSM_AES_CHUNK_BYTES) per 
+//    command (one IN/OUT SG chain of the jobs), the commands are pipelined 
+//    (HsmCmdBank).  The slot key is checked once per batch.
+//  --Per job status: jobs[i].passed/resultCode.  Not sent:  E_INVPARAM
+//    (length not an AES block multiple, SG pool empty) or HSMBUSYERR.
+//    rsp->rspChksPassed if all passed.
+//  --Command context variant (ctx->rspData has the accumulated checks)
+//******************************************************************************
+
+RSP_DATA * HsmCmdAesEcbBatchCtx(
+        HsmCmdCtx * ctx,
+        int vsSlotNum, //Encryption/Decryption Key
+        bool encrypt, //not decrypt
+        uint32_t * key,
+        CmdAesKeySize keySize,
+        HsmAesJob * jobs,
+        int numJobs) {
+    HsmCmdBank bank;
+    HsmAesBatchCmd batchCmd[HSM_CMD_BANKS];
+    HsmAesBatchCmd * cmd;
+    HsmCmdCtx * cmdCtx;
+    HsmSGSegment segIn[HSM_AES_BATCH_JOBS + 1];
+    HsmSGSegment segOut[HSM_AES_BATCH_JOBS];
+    CmdSGDescriptor * sgIn;
+    CmdSGDescriptor * sgOut;
+    RSP_DATA * rsp;
+    HsmAesJob * job;
+    uint32_t numBytes;
+    CmdResultCodes notSent = E_NULL;
+    int first;
+    int n;
+    int nIn;
+    int nOut;
+    int i;
+
+    //Header and slot check of all the commands
+    rsp = HsmCmdAesModePrep(ctx, CMD_AES_ECB, vsSlotNum, encrypt, 
+            key, keySize, NULL, false, NULL, NULL, 0);
+    if (rsp->invArgs || rsp->invSlot) return rsp;
+
+    for (i = 0; i < numJobs; i++) {
+        jobs[i].passed = false;
+        jobs[i].resultCode = E_NULL;
+    }
+
+    ClearRspData(rsp);
+    rsp->resultCode = S_OK;
+    HsmCmdBankInit(&bank);
+
+    for (first = 0; first < numJobs; first += n) {
+        //Jobs of the command:  IN [key] in..., OUT out...
+        nIn = 0;
+        nOut = 0;
+        numBytes = 0;
+        if (key != NULL) {
+            segIn[nIn].addr = key;
+            segIn[nIn].numBytes = aesKeyLength[keySize] / 8;
+            nIn++;
+        }
+        for (n = 0; first + n < numJobs && n < HSM_AES_BATCH_JOBS; n++) {
+            job = &jobs[first + n];
+            if (numBytes > 0 && 
+                numBytes + job->numDataBytes > HSM_AES_CHUNK_BYTES) break;
+
+            if (job->numDataBytes == 0 || 
+                (job->numDataBytes % AES_BLOCK_BYTES) != 0) {
+                job->resultCode = E_INVPARAM;
+                rsp->testFailCnt++;
+                continue;
+            }
+            segIn[nIn].addr = job->dataIn;
+            segIn[nIn].numBytes = job->numDataBytes;
+            nIn++;
+            segOut[nOut].addr = job->dataOut;
+            segOut[nOut].numBytes = job->numDataBytes;
+            nOut++;
+            numBytes += job->numDataBytes;
+        }
+        if (numBytes == 0) continue;
+
+        //SG chains (the collected commands give their descriptors back)
+        sgIn = HsmSGChainAlloc(segIn, nIn);
+        sgOut = HsmSGChainAlloc(segOut, nOut);
+        if (sgIn == NULL || sgOut == NULL) {
+            HsmSGChainFree(sgIn);
+            HsmSGChainFree(sgOut);
+            HsmCmdBankFlush(&bank);
+            sgIn = HsmSGChainAlloc(segIn, nIn);
+            sgOut = HsmSGChainAlloc(segOut, nOut);
+        }
+        if (sgIn == NULL || sgOut == NULL) {
+            HsmSGChainFree(sgIn);
+            HsmSGChainFree(sgOut);
+            rsp->invArgs = true;
+            notSent = E_INVPARAM;
+            break;
         }
 
-        //Output (Encrypted Msg)
-        dmaDescriptorOut[0].data.addr = aesOutputDataPtr;
-        dmaDescriptorOut[0].next.s.stop = 1;
-        dmaDescriptorOut[0].next.s.addr = 0;
-        dmaDescriptorOut[0].flagsLength.s.length =
-                (unsigned int) numDataWords*BYTES_PER_WORD;
-        dmaDescriptorOut[0].flagsLength.s.cstAddr = 0;
-        dmaDescriptorOut[0].flagsLength.s.discard = 0;
-        dmaDescriptorOut[0].flagsLength.s.realign = 1;
-        dmaDescriptorOut[0].flagsLength.s.intEn = 0;
+        cmdCtx = HsmCmdBankPrepare(&bank);
+        cmd = &batchCmd[HsmCmdBankIndex(&bank, cmdCtx)];
+        cmd->ctx = ctx;
+        cmd->jobs = &jobs[first];
+        cmd->numJobs = n;
 
+        HsmCmdCtxInit(cmdCtx);
+        cmdCtx->req = ctx->req;
+        cmdCtx->req.cmdInputs[0] = (uint32_t) sgIn;
+        cmdCtx->req.cmdInputs[1] = (uint32_t) sgOut;
+        cmdCtx->req.cmdInputs[2] = numBytes;
+        cmdCtx->req.expNumDataBytes = numBytes;
+
+        //Not sent (HSM stayed BUSY):  completed with HSMBUSYERR
+        if (!HsmCmdBankSubmit(&bank, cmdCtx, HsmCmdAesBatchDone, cmd)) {
+            notSent = (CmdResultCodes) HSMBUSYERR;
+            break;
+        }
     }
 
-    //Expected Response 
-    gHsmCmdReq.expMbHeader = 0x0020000c;
-    gHsmCmdReq.expResultCode = S_OK;
-    gHsmCmdReq.expStatus = 0x00000320;
-    gHsmCmdReq.expIntFlag = 0x00000000;
-    gHsmCmdReq.expData = 0x00000000; //TODO: Remove this from API and add to Test
-    gHsmCmdReq.expNumDataBytes =
-            (unsigned int) numDataWords*BYTES_PER_WORD;
-
-    //    SCB_CleanDCache_by_Addr((uint32_t *)           dmaDescriptorIn,  sizeof(dmaDescriptorIn));
-    //  SCB_CleanDCache_by_Addr((uint32_t *)           dmaDescriptorOut, sizeof(dmaDescriptorOut));
-    //SCB_CleanInvalidateDCache_by_Addr((uint32_t *) aesInputDataPtr,     numDataWords*sizeof(uint32_t));
-    //SCB_CleanInvalidateDCache_by_Addr((uint32_t *) aesOutputDataPtr,    numDataWords*sizeof(uint32_t));
+    HsmCmdBankFlush(&bank);
 
-    //Send HSM Command to HSM MB
-    //PrintAesCmd((CmdAesEcbCommandHeader *)(&gHsmCmdReq.cmdHeader));
-    HsmMbCmdDriver(&gHsmCmdReq, false);
+    //Jobs of the commands not built or not sent after the break
+    for (i = 0; i < numJobs; i++) {
+        if (jobs[i].resultCode == E_NULL) {
+            jobs[i].resultCode = notSent;
+            rsp->testFailCnt++;
+        }
+    }
 
-    //Check the response/result
-    HsmCmdRspChkr(rsp, true);
+    rsp->rspChksPassed = true;
+    for (i = 0; i < numJobs; i++) {
+        if (!jobs[i].passed) rsp->rspChksPassed = false;
+    }
 
     return rsp;
 
-} //End HsmCmdVsmInputDataUnencrypted()
+} //End HsmCmdAesEcbBatchCtx()
+
 
+//******************************************************************************
+//  AES ECB Encrypt/Decrypt Batch: CMD_AES_ECB
+//  NULL key --> use key give by vsSlotNum
+//******************************************************************************
+
+RSP_DATA * HsmCmdAesEcbBatch(
+        int vsSlotNum, //Encryption/Decryption Key
+        bool encrypt, //not decrypt
+        uint32_t * key,
+        CmdAesKeySize keySize,
+        HsmAesJob * jobs,
+        int numJobs) {
+    HsmCmdAesEcbBatchCtx(&gHsmCmdCtx, vsSlotNum, encrypt, key, keySize,
+                         jobs, numJobs);
+    return HsmCmdCtxPublish(&gHsmCmdCtx);
+} //End HsmCmdAesEcbBatch()
 
 /* *****************************************************************************
  End of File
@@ -31,6 +31,9 @@
 #include "hsm_host\hsm_command.h"
 #include "hsm_host\hsm_command_globals.h"
 #include "vsm.h"
+#include "hsm_bank.h"
+#include "hsm_sg.h"
+#include "hsm_queue.h"
 
 /* Provide C++ Compatibility */
 #ifdef __cplusplus
@@ -44,6 +47,19 @@ extern "C" {
 /* ************************************************************************** */
 /* ************************************************************************** */
 
+//Data per AES command of the larger requests (multiple of the 16 byte AES
+//block).  The chunks are pipelined through HSM_CMD_BANKS command contexts.
+#define AES_BLOCK_BYTES      16
+
+#ifndef HSM_AES_CHUNK_BYTES
+#define HSM_AES_CHUNK_BYTES  (16*1024)
+#endif
+
+//Batch jobs per AES command (HsmCmdAesEcbBatchCtx()).  The 2 commands in 
+//the HSM/being built take up to 2 x (2 x 7 + 1) SG pool descriptors.
+#ifndef HSM_AES_BATCH_JOBS
+#define HSM_AES_BATCH_JOBS   7
+#endif
 
 
 // *****************************************************************************
@@ -150,8 +166,61 @@ typedef struct
     CmdResultCodes      resultCode;
 } CmdAesEcbResponse;
 
+// AES batch job (HsmCmdAesEcbBatchCtx())
+typedef struct
+{
+    uint8_t *       dataIn;
+    uint8_t *       dataOut;
+    uint32_t        numDataBytes; //AES block multiple
+    bool            passed;       //Out: Command response checks passed
+    CmdResultCodes  resultCode;   //Out: Command result (or not sent)
+} HsmAesJob;
+
+// AES ECB/CBC padding of the last block (HsmCmdAesPadEncryptDecryptCtx())
+typedef enum
+{
+    HSM_AES_PAD_NONE  = 0,  //AES block multiple only
+    HSM_AES_PAD_PKCS7 = 1,  //1..16 bytes of the pad length (removed on decrypt)
+    HSM_AES_PAD_ZERO  = 2   //0..15 zero bytes (kept on decrypt)
+} HsmAesPadding;
+
+// AES stream chaining state (HsmCmdAesCbcSave()/HsmCmdAesCtrSave())
+// --Host owned, no key.
+typedef struct
+{
+    CmdAesMode      mode;       //CMD_AES_CBC/CMD_AES_CTR
+    bool            ivValid;    //CBC: iv is the chaining value (else slot IV)
+    uint32_t        offset;     //CTR: key stream byte offset
+    uint32_t ALIGN4 iv[AES_BLOCK_BYTES / BYTES_PER_WORD]; //CBC: chaining 
+                                                          //CTR: initial ctr
+} HsmAesCtxState;
+
+// AES CBC stream (HsmCmdAesCbcInit()/HsmCmdAesCbcUpdateCtx())
+typedef struct
+{
+    int             vsSlotNum;
+    bool            encrypt;
+    uint32_t *      key;        //NULL: slot key
+    CmdAesKeySize   keySize;
+    bool            hostIv;     //Chaining value in iv (else slot IV)
+    bool            started;    //Data sent
+    uint32_t ALIGN4 iv[AES_BLOCK_BYTES / BYTES_PER_WORD];
+} HsmAesCbcCtx;
+
+// AES CTR stream (HsmCmdAesCtrInit()/HsmCmdAesCtrUpdateCtx())
+typedef struct
+{
+    int             vsSlotNum;
+    uint32_t *      key;        //NULL: slot key
+    CmdAesKeySize   keySize;
+    uint32_t        offset;     //Key stream byte offset of the next data
+    bool            ksValid;    //ks is the key stream of block ksBlock
+    uint32_t        ksBlock;
+    uint32_t ALIGN4 ctr[AES_BLOCK_BYTES / BYTES_PER_WORD]; //Initial counter
+    uint32_t ALIGN4 ks[AES_BLOCK_BYTES / BYTES_PER_WORD];  //Partial block
+} HsmAesCtrCtx;
+
 // TODO:  Other AES Cmd Modes
-// cmdAesGcmEcbCommand  
 
 // *****************************************************************************
 // *****************************************************************************
@@ -167,6 +236,148 @@ RSP_DATA * HsmCmdAesEcbEncryptDecrypt(
     uint32_t *       aesInputDataPtr,
     uint32_t *       aesOutputDataPtr,
     uint32_t         numDataWords);
+bool       HsmCmdAesEcbEncryptDecryptQueue( 
+    int              vsSlotNum, //Encryption/Decryption Key
+    bool             encrypt,   //not decrypt
+    uint32_t *       key,       //key
+    CmdAesKeySize    keySize,
+    uint32_t *       aesInputDataPtr,
+    uint32_t *       aesOutputDataPtr,
+    uint32_t         numDataWords,
+    HsmCmdQueueCallback callback,
+    void *           context);
+RSP_DATA * HsmCmdAesEcbEncryptDecryptPrep( 
+    HsmCmdCtx *      ctx,
+    int              vsSlotNum, //Encryption/Decryption Key
+    bool             encrypt,   //not decrypt
+    uint32_t *       key,       //key
+    CmdAesKeySize    keySize,
+    uint32_t *       aesInputDataPtr,
+    uint32_t *       aesOutputDataPtr,
+    uint32_t         numDataWords);
+RSP_DATA * HsmCmdAesEcbEncryptDecryptCtx( 
+    HsmCmdCtx *      ctx,
+    int              vsSlotNum, //Encryption/Decryption Key
+    bool             encrypt,   //not decrypt
+    uint32_t *       key,       //key
+    CmdAesKeySize    keySize,
+    uint32_t *       aesInputDataPtr,
+    uint32_t *       aesOutputDataPtr,
+    uint32_t         numDataWords);
+RSP_DATA * HsmCmdAesModePrep( 
+    HsmCmdCtx *      ctx,
+    CmdAesMode       mode,
+    int              vsSlotNum, //Encryption/Decryption Key
+    bool             encrypt,   //not decrypt
+    uint32_t *       key,       //key
+    CmdAesKeySize    keySize,
+    uint32_t *       iv,        //NULL: none/stored with the key
+    bool             useCtx,    //Continue the HSM AES context
+    uint8_t *        dataIn,
+    uint8_t *        dataOut,
+    uint32_t         numDataBytes);
+RSP_DATA * HsmCmdAesPadEncryptDecrypt( 
+    CmdAesMode       mode,      //CMD_AES_ECB/CMD_AES_CBC
+    int              vsSlotNum, //Encryption/Decryption Key
+    bool             encrypt,   //not decrypt
+    uint32_t *       key,       //key
+    CmdAesKeySize    keySize,
+    uint32_t *       iv,        //CBC, NULL: IV stored with the slot key
+    HsmAesPadding    padding,
+    uint8_t *        dataIn,
+    uint8_t *        dataOut,   //Can be dataIn
+    uint32_t         numDataBytes,
+    uint32_t         maxOutBytes,
+    uint32_t *       numOutBytes);
+RSP_DATA * HsmCmdAesPadEncryptDecryptCtx( 
+    HsmCmdCtx *      ctx,
+    CmdAesMode       mode,      //CMD_AES_ECB/CMD_AES_CBC
+    int              vsSlotNum, //Encryption/Decryption Key
+    bool             encrypt,   //not decrypt
+    uint32_t *       key,       //key
+    CmdAesKeySize    keySize,
+    uint32_t *       iv,        //CBC, NULL: IV stored with the slot key
+    HsmAesPadding    padding,
+    uint8_t *        dataIn,
+    uint8_t *        dataOut,   //Can be dataIn
+    uint32_t         numDataBytes,
+    uint32_t         maxOutBytes,
+    uint32_t *       numOutBytes);
+RSP_DATA * HsmCmdAesCbcEncryptDecrypt( 
+    int              vsSlotNum, //Encryption/Decryption Key
+    bool             encrypt,   //not decrypt
+    uint32_t *       key,       //key
+    CmdAesKeySize    keySize,
+    uint32_t *       iv,        //NULL: IV stored with the slot key
+    uint32_t *       aesInputDataPtr,
+    uint32_t *       aesOutputDataPtr,
+    uint32_t         numDataWords);
+RSP_DATA * HsmCmdAesCbcInit( 
+    HsmAesCbcCtx *   cbc,
+    RSP_DATA *       rsp,
+    int              vsSlotNum, //Encryption/Decryption Key
+    bool             encrypt,   //not decrypt
+    uint32_t *       key,       //key
+    CmdAesKeySize    keySize,
+    uint32_t *       iv);       //NULL: IV stored with the slot key
+RSP_DATA * HsmCmdAesCbcUpdateCtx( 
+    HsmCmdCtx *      ctx,
+    HsmAesCbcCtx *   cbc,
+    uint32_t *       aesInputDataPtr,
+    uint32_t *       aesOutputDataPtr,
+    uint32_t         numDataWords);
+void       HsmCmdAesCbcSave( 
+    const HsmAesCbcCtx * cbc,
+    HsmAesCtxState * state);
+bool       HsmCmdAesCbcRestore( 
+    HsmAesCbcCtx *   cbc,
+    const HsmAesCtxState * state);
+RSP_DATA * HsmCmdAesCtrEncryptDecrypt( 
+    int              vsSlotNum, //Encryption/Decryption Key
+    uint32_t *       key,       //key
+    CmdAesKeySize    keySize,
+    uint32_t *       iv,        //Initial counter block
+    uint32_t         offset,    //Key stream byte offset
+    uint8_t *        dataIn,
+    uint8_t *        dataOut,
+    uint32_t         numDataBytes);
+RSP_DATA * HsmCmdAesCtrInit( 
+    HsmAesCtrCtx *   ctr,
+    RSP_DATA *       rsp,
+    int              vsSlotNum, //Encryption/Decryption Key
+    uint32_t *       key,       //key
+    CmdAesKeySize    keySize,
+    uint32_t *       iv);       //Initial counter block
+void       HsmCmdAesCtrSeek( 
+    HsmAesCtrCtx *   ctr,
+    uint32_t         offset);   //Key stream byte offset
+RSP_DATA * HsmCmdAesCtrUpdateCtx( 
+    HsmCmdCtx *      ctx,
+    HsmAesCtrCtx *   ctr,
+    uint8_t *        dataIn,
+    uint8_t *        dataOut,
+    uint32_t         numDataBytes);
+void       HsmCmdAesCtrSave( 
+    const HsmAesCtrCtx * ctr,
+    HsmAesCtxState * state);
+bool       HsmCmdAesCtrRestore( 
+    HsmAesCtrCtx *   ctr,
+    const HsmAesCtxState * state);
+RSP_DATA * HsmCmdAesEcbBatch( 
+    int              vsSlotNum, //Encryption/Decryption Key
+    bool             encrypt,   //not decrypt
+    uint32_t *       key,       //key
+    CmdAesKeySize    keySize,
+    HsmAesJob *      jobs,
+    int              numJobs);
+RSP_DATA * HsmCmdAesEcbBatchCtx( 
+    HsmCmdCtx *      ctx,
+    int              vsSlotNum, //Encryption/Decryption Key
+    bool             encrypt,   //not decrypt
+    uint32_t *       key,       //key
+    CmdAesKeySize    keySize,
+    HsmAesJob *      jobs,
+    int              numJobs);
 
 extern int aesKeyLength[3];
 
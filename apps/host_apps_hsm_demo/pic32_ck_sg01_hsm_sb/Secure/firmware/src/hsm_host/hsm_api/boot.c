@@ -51,147 +51,100 @@ extern uint32_t dummy32;
 #define SELF_TEST_STATUS 0x00000410
 
 //******************************************************************************
-//CMD_BOOT_SELF_TEST
-//--This command uses the command header defined in the boot commands section 
-//  with no changes.
+// Boot command with no IN/OUT data (CMD_BOOT_SELF_TEST/CMD_BOOT_LOAD_FIRMWARE)
+// --P1: Location of the Boot Image
 //******************************************************************************
 
-RSP_DATA * HsmCmdBootSelfTest()
+static RSP_DATA * HsmCmdBootCtx(HsmCmdCtx * ctx, uint32_t cmdHeader)
  {
-    RSP_DATA * rsp = &gRspData;
+    RSP_DATA * rsp = &ctx->rspData;
 
-    // Reset the response checker global variable
-    rsp->invArgs = false;
-    rsp->rspChksPassed = false;
+    // Reset the response checker
+    HsmCmdCtxInit(ctx);
     rsp->resultCode = S_OK;
-    rsp->testFailCnt = 0;
-
-    // Make sure the HSM is not busy
-    while (HSM_REGS->HSM_STATUS & HSM_STATUS_BUSY_Msk);
-
-    gHsmCmdReq.mbHeader = 0x00f00014; //5 Words
-    gHsmCmdReq.cmdHeader = CMD_BOOT_SELF_TEST;
-    gHsmCmdReq.cmdInputs[0] = 0x00000000; // IN: Unused
-    gHsmCmdReq.cmdInputs[1] = 0x00000000; //OUT: Unused
-    gHsmCmdReq.cmdInputs[2] = HSM_FIRMWARE_INIT_ADDR; // P1: Location of the Boot Image
-    gHsmCmdReq.cmdInputs[3] = 0x00000000; // P2: unused
-
-    //Input SG for Key Block Data
-    dmaDescriptorIn[0].data.addr = &dummy32;
-    dmaDescriptorIn[0].next.s.stop = 1;
-    dmaDescriptorIn[0].next.s.addr = 0;
-    dmaDescriptorIn[0].flagsLength.s.length = 1;
-    dmaDescriptorIn[0].flagsLength.s.cstAddr = 0;
-    dmaDescriptorIn[0].flagsLength.s.discard = 0;
-    dmaDescriptorIn[0].flagsLength.s.realign = 1;
-    dmaDescriptorIn[0].flagsLength.s.intEn = 0;
-    //SYS_MESSAGE("VSM INPUT DATA SG:\r\n");
-    //PrintSG(dmaDescriptorIn[0], true);
+
+    ctx->req.mbHeader = 0x00f00014; //5 Words
+    ctx->req.cmdHeader = cmdHeader;
+    ctx->req.cmdInputs[0] = 0x00000000; // IN: Unused
+    ctx->req.cmdInputs[1] = 0x00000000; //OUT: Unused
+    ctx->req.cmdInputs[2] = HSM_FIRMWARE_INIT_ADDR; // P1: Location of the Boot Image
+    ctx->req.cmdInputs[3] = 0x00000000; // P2: unused
+
+    //Input (Not Used)
+    HsmCmdCtxSetSG(&ctx->dmaIn[0], &dummy32, 1, NULL);
 
     //Output (Not Used)
-    dmaDescriptorOut[0].data.addr = &dummy32;
-    dmaDescriptorOut[0].next.s.stop = 1;
-    dmaDescriptorOut[0].next.s.addr = 0;
-    dmaDescriptorOut[0].flagsLength.s.length = 1;
-    dmaDescriptorOut[0].flagsLength.s.cstAddr = 0;
-    dmaDescriptorOut[0].flagsLength.s.discard = 0;
-    dmaDescriptorOut[0].flagsLength.s.realign = 1;
-    dmaDescriptorOut[0].flagsLength.s.intEn = 0;
+    HsmCmdCtxSetSG(&ctx->dmaOut[0], &dummy32, 1, NULL);
 
     //Expected Response 
-    gHsmCmdReq.expMbHeader = CMD_BOOT_SELF_TEST_MBHEADER_RX;
-    gHsmCmdReq.expResultCode = S_OK;
-    gHsmCmdReq.expStatus = SELF_TEST_STATUS;
-    gHsmCmdReq.expIntFlag = 0x00000000;
-    gHsmCmdReq.expData = 0x00000000;
-    gHsmCmdReq.expNumDataBytes = 0;
-
-    //SCB_CleanDCache_by_Addr((uint32_t *)           dmaDescriptorIn,  sizeof(dmaDescriptorIn));
-    //SCB_CleanDCache_by_Addr((uint32_t *)           dmaDescriptorOut, sizeof(dmaDescriptorOut));
-    //SCB_CleanInvalidateDCache_by_Addr((uint32_t *) dummy32,          sizeof(uint32_t));
-    //SCB_CleanInvalidateDCache_by_Addr((uint32_t *) vsmInputDataPtr,  numSlotWords*sizeof(uint32_t));
-
-    //SYS_PRINT("HSM: Sending CMD_VSM_INPUT_DATA Command\r\n");
-    HsmMbCmdDriver(&gHsmCmdReq, false);
-
-    HsmCmdRspChkr(rsp, true);
+    ctx->req.expMbHeader = CMD_BOOT_SELF_TEST_MBHEADER_RX;
+    ctx->req.expResultCode = S_OK;
+    ctx->req.expStatus = SELF_TEST_STATUS;
+    ctx->req.expIntFlag = 0x00000000;
+    ctx->req.expData = 0x00000000;
+    ctx->req.expNumDataBytes = 0;
+
+    //Data cache: HsmDmaCmdPrepare()/HsmDmaCmdComplete() (hsm_dma.c)
+
+    HsmCmdCtxExec(ctx);
+
+    HsmCmdCtxRspChkr(ctx, true);
     //if (rsp.resultCode != E_INVFORMAT && rsp.resultCode != E_SAFEMODE)
 
     return rsp;
 
-} //End HsmCmdBootSelfTest()
+} //End HsmCmdBootCtx()
 
 
 //******************************************************************************
-// Send CMD_BOOT_SELF_TEST command to load the HSM firmware
+//CMD_BOOT_SELF_TEST
 //--This command uses the command header defined in the boot commands section 
 //  with no changes.
+//--Command context variant (ctx->rspData has the response check results)
 //******************************************************************************
 
-RSP_DATA * HsmCmdBootLoadFirmware()
+RSP_DATA * HsmCmdBootSelfTestCtx(HsmCmdCtx * ctx)
  {
-    RSP_DATA * rsp = &gRspData;
+    return HsmCmdBootCtx(ctx, CMD_BOOT_SELF_TEST);
+} //End HsmCmdBootSelfTestCtx()
 
-    // Reset the response checker global variable
-    rsp->invArgs = false;
-    rsp->rspChksPassed = false;
-    rsp->resultCode = S_OK;
-    rsp->testFailCnt = 0;
-
-    // Make sure the HSM is not busy
-    while (HSM_REGS->HSM_STATUS & HSM_STATUS_BUSY_Msk);
-
-    gHsmCmdReq.mbHeader = 0x00f00014; //0x00f00014;//0x00d00014(unprotect=0)mailbox pay attention to protect bits//  MB: 5 Words
-    gHsmCmdReq.cmdHeader = 0x00000100; //0x04000100;(HSM will be conducted with trusted memory) // 0x00000100// CMD: Boot load firmware
-    gHsmCmdReq.cmdInputs[0] = 0x00000000; //  IN: Unused
-    gHsmCmdReq.cmdInputs[1] = 0x00000000; // OUT: Unused
-    gHsmCmdReq.cmdInputs[2] = HSM_FIRMWARE_INIT_ADDR; //  P1: Location of the Boot Image
-    gHsmCmdReq.cmdInputs[3] = 0x00000000; //  P2: unused
-
-    //Input SG for Key Block Data
-    dmaDescriptorIn[0].data.addr = &dummy32;
-    dmaDescriptorIn[0].next.s.stop = 1;
-    dmaDescriptorIn[0].next.s.addr = 0;
-    dmaDescriptorIn[0].flagsLength.s.length = 1;
-    dmaDescriptorIn[0].flagsLength.s.cstAddr = 0;
-    dmaDescriptorIn[0].flagsLength.s.discard = 0;
-    dmaDescriptorIn[0].flagsLength.s.realign = 1;
-    dmaDescriptorIn[0].flagsLength.s.intEn = 0;
-    //SYS_MESSAGE("VSM INPUT DATA SG:\r\n");
-    //PrintSG(dmaDescriptorIn[0], true);
 
-    //Output (Not Used)
-    dmaDescriptorOut[0].data.addr = &dummy32;
-    dmaDescriptorOut[0].next.s.stop = 1;
-    dmaDescriptorOut[0].next.s.addr = 0;
-    dmaDescriptorOut[0].flagsLength.s.length = 1;
-    dmaDescriptorOut[0].flagsLength.s.cstAddr = 0;
-    dmaDescriptorOut[0].flagsLength.s.discard = 0;
-    dmaDescriptorOut[0].flagsLength.s.realign = 1;
-    dmaDescriptorOut[0].flagsLength.s.intEn = 0;
+//******************************************************************************
+//CMD_BOOT_SELF_TEST
+//--This command uses the command header defined in the boot commands section 
+//  with no changes.
+//******************************************************************************
 
-    //Expected Response 
-    gHsmCmdReq.expMbHeader = CMD_BOOT_SELF_TEST_MBHEADER_RX;
-    gHsmCmdReq.expResultCode = S_OK;
-    gHsmCmdReq.expStatus = SELF_TEST_STATUS;
-    gHsmCmdReq.expIntFlag = 0x00000000;
-    gHsmCmdReq.expData = 0x00000000;
-    gHsmCmdReq.expNumDataBytes = 0;
-
-    //SCB_CleanDCache_by_Addr((uint32_t *)           dmaDescriptorIn,  sizeof(dmaDescriptorIn));
-    //SCB_CleanDCache_by_Addr((uint32_t *)           dmaDescriptorOut, sizeof(dmaDescriptorOut));
-    //SCB_CleanInvalidateDCache_by_Addr((uint32_t *) dummy32,          sizeof(uint32_t));
-    //SCB_CleanInvalidateDCache_by_Addr((uint32_t *) vsmInputDataPtr,  numSlotWords*sizeof(uint32_t));
-
-    //SYS_PRINT("HSM: Sending CMD_VSM_INPUT_DATA Command\r\n");
-    HsmMbCmdDriver(&gHsmCmdReq, false);
-
-    HsmCmdRspChkr(rsp, true);
-    //if (rsp.resultCode != E_INVFORMAT && rsp.resultCode != E_SAFEMODE)
+RSP_DATA * HsmCmdBootSelfTest()
+ {
+    HsmCmdBootSelfTestCtx(&gHsmCmdCtx);
+    return HsmCmdCtxPublish(&gHsmCmdCtx);
+} //End HsmCmdBootSelfTest()
 
-    return rsp;
 
-} //End HsmCmdBootSelfTest()
+//******************************************************************************
+// Send CMD_BOOT_LOAD_FIRMWARE command to load the HSM firmware
+//--Command context variant (ctx->rspData has the response check results)
+//******************************************************************************
+
+RSP_DATA * HsmCmdBootLoadFirmwareCtx(HsmCmdCtx * ctx)
+ {
+    //0x04000100;(HSM will be conducted with trusted memory) 
+    return HsmCmdBootCtx(ctx, 0x00000100); // CMD: Boot load firmware
+} //End HsmCmdBootLoadFirmwareCtx()
+
+
+//******************************************************************************
+// Send CMD_BOOT_LOAD_FIRMWARE command to load the HSM firmware
+//--This command uses the command header defined in the boot commands section 
+//  with no changes.
+//******************************************************************************
+
+RSP_DATA * HsmCmdBootLoadFirmware()
+ {
+    HsmCmdBootLoadFirmwareCtx(&gHsmCmdCtx);
+    return HsmCmdCtxPublish(&gHsmCmdCtx);
+} //End HsmCmdBootLoadFirmware()
 
 
 #define BOOT_HASH_INIT_WORDS 2
@@ -210,75 +163,62 @@ int32_t expBootHashResult[BOOT_HASH_INIT_WORDS] = {0x6A09E667, 0xBB67AE85};
 
 //******************************************************************************
 //Firmware Validation Test using SHA256 Hash
+//--Command context variant (ctx->rspData has the response check results)
 //******************************************************************************
 
-RSP_DATA * HsmCmdBootTestHashInit() {
-    RSP_DATA * rsp = &gRspData;
-    //static int numDataBytes = 0;
-
-    rsp = &gRspData;
-
-    rsp->invArgs = false;
+RSP_DATA * HsmCmdBootTestHashInitCtx(HsmCmdCtx * ctx) {
+    RSP_DATA * rsp = &ctx->rspData;
 
-    // Make sure the HSM is not busy
-    while (HSM_REGS->HSM_STATUS & HSM_STATUS_BUSY_Msk);
+    HsmCmdCtxInit(ctx);
 
     //TODO: Pad input data to 32bit boundary
 
     // Send HASH BLOCK command request to HSM MB 
     // -- External Data
     // -- External Result
-    gHsmCmdReq.mbHeader = 0x00f00014; //MB:
-    gHsmCmdReq.cmdHeader = 0x00040105; //CMD: 
-    gHsmCmdReq.cmdInputs[0] = 0x00000000; //IN: Unused 
-    gHsmCmdReq.cmdInputs[1] = (uint32_t) (&(dmaDescriptorOut[0])); //OUT 
-    gHsmCmdReq.cmdInputs[2] = 0x00000000; //P1
-    gHsmCmdReq.cmdInputs[3] = 0x00000000; //P2
-
-    gHsmCmdReq.expMbHeader = CMD_BOOT_SELF_TEST_MBHEADER_RX;
-    gHsmCmdReq.expResultCode = S_OK;
-    gHsmCmdReq.expStatus = 0x00000420;
-    gHsmCmdReq.expIntFlag = 0x00000000;
-    gHsmCmdReq.expData = 0x00000000;
-    gHsmCmdReq.expNumDataBytes = 0;
-    //gHsmCmdReq.expData         = expHashBlockResult;
-    //gHsmCmdReq.expNumDataBytes = BOOT_HASH_INIT_WORDS*BYTES_PER_WORD;
-
-    dmaDescriptorIn[0].data.addr = &dummy32;
-    dmaDescriptorIn[0].next.s.stop = 1;
-    dmaDescriptorIn[0].next.s.addr = 0;
-    dmaDescriptorIn[0].flagsLength.s.length = 1;
-    dmaDescriptorIn[0].flagsLength.s.cstAddr = 0;
-    dmaDescriptorIn[0].flagsLength.s.discard = 0;
-    dmaDescriptorIn[0].flagsLength.s.realign = 1;
-    dmaDescriptorIn[0].flagsLength.s.intEn = 0;
-
-    dmaDescriptorOut[0].data.addr = (uint32_t *) bootHashInitBuffer;
-    dmaDescriptorOut[0].next.s.stop = 1;
-    dmaDescriptorOut[0].next.s.addr = 0;
-    dmaDescriptorOut[0].flagsLength.s.length = HASH_SHA256_RESULT_BYTES; //SHA26 Hash Size
-    dmaDescriptorOut[0].flagsLength.s.cstAddr = 0;
-    dmaDescriptorOut[0].flagsLength.s.discard = 0;
-    dmaDescriptorOut[0].flagsLength.s.realign = 1;
-    dmaDescriptorOut[0].flagsLength.s.intEn = 0;
-
-    //SCB_CleanDCache_by_Addr((uint32_t *) dmaDescriptorIn,  sizeof(dmaDescriptorIn));
-    //    SCB_CleanDCache_by_Addr((uint32_t *) dmaDescriptorOut, sizeof(dmaDescriptorOut));
-    //  SCB_CleanInvalidateDCache_by_Addr(bootHashInitBuffer, sizeof(bootHashInitBuffer));
-    //SCB_CleanInvalidateDCache_by_Addr((uint32_t *) dataIn, numDataInBytes);
-
-    HsmMbCmdDriver(&gHsmCmdReq, false);
+    ctx->req.mbHeader = 0x00f00014; //MB:
+    ctx->req.cmdHeader = 0x00040105; //CMD: 
+    ctx->req.cmdInputs[0] = 0x00000000; //IN: Unused 
+    ctx->req.cmdInputs[2] = 0x00000000; //P1
+    ctx->req.cmdInputs[3] = 0x00000000; //P2
+
+    ctx->req.expMbHeader = CMD_BOOT_SELF_TEST_MBHEADER_RX;
+    ctx->req.expResultCode = S_OK;
+    ctx->req.expStatus = 0x00000420;
+    ctx->req.expIntFlag = 0x00000000;
+    ctx->req.expData = 0x00000000;
+    ctx->req.expNumDataBytes = 0;
+    //ctx->req.expData         = expHashBlockResult;
+    //ctx->req.expNumDataBytes = BOOT_HASH_INIT_WORDS*BYTES_PER_WORD;
+
+    HsmCmdCtxSetSG(&ctx->dmaIn[0], &dummy32, 1, NULL);
+    HsmCmdCtxSetSG(&ctx->dmaOut[0], (uint32_t *) bootHashInitBuffer, 
+                   HASH_SHA256_RESULT_BYTES, NULL); //SHA26 Hash Size
+
+    //Data cache: HsmDmaCmdPrepare()/HsmDmaCmdComplete() (hsm_dma.c)
+
+    HsmCmdCtxExec(ctx);
 
     //Check the command response 
-    HsmCmdRspChkr(rsp, true);
+    HsmCmdCtxRspChkr(ctx, true);
 
     if (rsp->rspChksPassed) {
         SYS_PRINT("BOOT SHA256:\r\n");
-        PrintSG(dmaDescriptorOut[0], true);
+        PrintSG(ctx->dmaOut[0], true);
     }
 
     return rsp;
 
+} //End HsmCmdBootTestHashInitCtx()
+
+
+//******************************************************************************
+//Firmware Validation Test using SHA256 Hash
+//******************************************************************************
+
+RSP_DATA * HsmCmdBootTestHashInit() {
+    HsmCmdBootTestHashInitCtx(&gHsmCmdCtx);
+    return HsmCmdCtxPublish(&gHsmCmdCtx);
 } //End HsmCmdBootTestHashInit()
 
 /* *****************************************************************************
@@ -278,6 +278,11 @@ RSP_DATA * HsmCmdBootSelfTest(void);
 RSP_DATA * HsmCmdBootLoadFirmware(void); 
 RSP_DATA * HsmCmdBootTestHashInit(void);
 
+//Command context variants
+RSP_DATA * HsmCmdBootSelfTestCtx(HsmCmdCtx * ctx);
+RSP_DATA * HsmCmdBootLoadFirmwareCtx(HsmCmdCtx * ctx); 
+RSP_DATA * HsmCmdBootTestHashInitCtx(HsmCmdCtx * ctx);
+
 // *****************************************************************************
 // *****************************************************************************
 // Section: globals/Functions
@@ -6,74 +6,707 @@
 #include "user.h"
 #include "hash.h"
 
+extern uint32_t dummy32;
+
+
+#if HSM_HASH_STREAM_ENABLE
 //******************************************************************************
-//HASH BLOCK Command Cmd - 1
-//--TODO: Interrupt Mode
+// Hash block bytes (0: not a supported hash type)
 //******************************************************************************
+static uint32_t HsmHashBlockBytes(CmdHashTypes hashType)
+{
+    switch (hashType)
+    {
+        case CMD_HASH_MD5:
+        case CMD_HASH_SHA1:
+        case CMD_HASH_SHA224:
+        case CMD_HASH_SHA256:
+            return 64;
+        case CMD_HASH_SHA384:
+        case CMD_HASH_SHA512:
+            return HASH_MAX_BLOCK_BYTES;
+        default:
+            return 0;
+    }
+} //End HsmHashBlockBytes()
 
-RSP_DATA * HsmCmdHashBlockSha256(
+
+//******************************************************************************
+// Hash state bytes (HASH_INIT/HASH_UPDATE OUT, 0: not a supported hash type)
+// --The hash words, e.g. H0..H7 for SHA-256 (see HsmCmdBootTestHashInitCtx())
+//******************************************************************************
+static uint32_t HsmHashStateBytes(CmdHashTypes hashType)
+{
+    switch (hashType)
+    {
+        case CMD_HASH_MD5:
+            return 16;
+        case CMD_HASH_SHA1:
+            return 20;
+        case CMD_HASH_SHA224:
+        case CMD_HASH_SHA256:
+            return 32;
+        case CMD_HASH_SHA384:
+        case CMD_HASH_SHA512:
+            return HASH_MAX_STATE_BYTES;
+        default:
+            return 0;
+    }
+} //End HsmHashStateBytes()
+#endif //HSM_HASH_STREAM_ENABLE
+
+
+//******************************************************************************
+// Hash command header word (CmdHashHashBlockHeader) of a command/hash type
+// --slotParamInc:  param2 has the key slot (CMD_HASH_HMAC)
+//******************************************************************************
+static uint32_t HsmHashCmdHeader(CmdHashCommandTypes cmdType,
+                                 CmdHashTypes        hashType,
+                                 bool                slotParamInc)
+{
+    CmdHashHashBlockHeader cmdHeader;
+    uint32_t               w = 0;
+
+    memset(&cmdHeader, 0, sizeof(cmdHeader));
+    cmdHeader.cmdGroup = CMD_HASH;
+    cmdHeader.cmdType  = cmdType;
+    cmdHeader.hashType = hashType;
+    cmdHeader.slotParamInc = slotParamInc ? 1 : 0;
+    memcpy(&w, &cmdHeader, sizeof(w));
+
+    return w;
+} //End HsmHashCmdHeader()
+
+
+#if HSM_HASH_STREAM_ENABLE
+//******************************************************************************
+// Hash stream command (CMD_HASH_HASH_INIT/UPDATE/FINALIZE)
+// --INIT:      IN SG:  dummy (1 byte),              OUT SG:  hash->state
+// --UPDATE:    IN SG:  hash->state [hash->pend] data, OUT SG:  hash->state
+// --FINALIZE:  IN SG:  hash->state [hash->pend],      OUT SG:  digest
+// --Param1 is the message bytes (pend + data), not the state.
+// --INIT is framed as HsmCmdBootTestHashInitCtx() (MB header, status, IN),
+//   the only hash stream command in the tree.  The UPDATE/FINALIZE state IN
+//   is UNVERIFIED (HSM_HASH_STREAM_ENABLE).
+// --The stream (hash) is advanced when the command passes.  The state OUT
+//   overwrites the state IN, the HSM reads IN before it writes OUT.
+//******************************************************************************
+static RSP_DATA * HsmCmdHashStreamCmd(HsmCmdCtx *         ctx,
+                                      HsmHashCtx *        hash,
+                                      CmdHashCommandTypes cmdType,
+                                      uint8_t *           data,
+                                      uint32_t            numDataBytes,
+                                      uint8_t *           digest)
+{
+    RSP_DATA *        rsp = &ctx->rspData;
+    HsmSGSegment      segIn[3];
+    HsmSGSegment      segOut;
+    CmdSGDescriptor * sgIn;
+    CmdSGDescriptor * sgOut;
+    uint32_t          digestBytes = HsmHashDigestBytes(hash->hashType);
+    uint32_t          stateBytes  = HsmHashStateBytes(hash->hashType);
+
+    HsmCmdCtxInit(ctx);
+
+    ctx->req.mbHeader  = 0x00f00014; //5 Words (P1 only)
+    ctx->req.cmdHeader = HsmHashCmdHeader(cmdType, hash->hashType, false);
+    ctx->req.cmdInputs[2] = hash->pendBytes + numDataBytes;
+    ctx->req.cmdInputs[3] = 0x00000000; // Unused
+
+    ctx->req.expResultCode = S_OK;
+    ctx->req.expStatus     = 0x00000420;
+    ctx->req.expIntFlag    = 0x00000000;
+    ctx->req.expData       = 0x00000000;
+    ctx->req.expMbHeader   = 0x0020000c;
+
+    segIn[0].addr     = hash->state;
+    segIn[0].numBytes = stateBytes;
+    if (cmdType == CMD_HASH_HASH_INIT)
+    {
+        segIn[0].addr     = &dummy32;
+        segIn[0].numBytes = 1;
+    }
+    segIn[1].addr     = hash->pend;
+    segIn[1].numBytes = hash->pendBytes;
+    segIn[2].addr     = data;
+    segIn[2].numBytes = numDataBytes;
+
+    if (cmdType == CMD_HASH_HASH_FINALIZE)
+    {
+        ctx->req.expMbHeader     = 0x00200010; //Hash size word
+        ctx->req.expNumDataBytes = digestBytes;
+        segOut.addr              = digest;
+        segOut.numBytes          = digestBytes;
+    }
+    else
+    {
+        ctx->req.expNumDataBytes = 0; //See HsmCmdBootTestHashInitCtx()
+        segOut.addr              = hash->state;
+        segOut.numBytes          = stateBytes;
+    }
+
+    sgIn  = HsmSGChainAlloc(segIn, 3);
+    sgOut = HsmSGChainAlloc(&segOut, 1);
+    if (sgIn == NULL || sgOut == NULL)
+    {
+        HsmSGChainFree(sgIn);
+        HsmSGChainFree(sgOut);
+        rsp->invArgs = true;
+        return rsp;
+    }
+    HsmSGCtxSet(ctx, sgIn, sgOut);
+
+    HsmCmdCtxExec(ctx);
+    HsmSGChainFree(sgIn);
+    HsmSGChainFree(sgOut);
+
+    HsmCmdCtxRspChkr(ctx, true);
+    if (!rsp->rspChksPassed) return rsp;
+
+    hash->started = (cmdType != CMD_HASH_HASH_FINALIZE);
+    return rsp;
+} //End HsmCmdHashStreamCmd()
+#endif //HSM_HASH_STREAM_ENABLE
+
+
+#if HSM_HASH_HMAC_ENABLE
+//******************************************************************************
+// HMAC command (CMD_HASH_HMAC), one shot
+// --IN SG:  data, OUT SG:  HMAC (mac, HsmHashDigestBytes() bytes)
+// --The slot key is checked first (CMD_VSM_GET_SLOT_INFO, cached).
+//******************************************************************************
+static RSP_DATA * HsmCmdHmacCmd(HsmCmdCtx *  ctx,
+                                int          vsSlotNum,
+                                CmdHashTypes hashType,
+                                uint8_t *    data,
+                                uint32_t     numDataBytes,
+                                uint8_t *    mac)
+{
+    RSP_DATA *            rsp = &ctx->rspData;
+    HsmSGSegment          segIn;
+    HsmSGSegment          segOut;
+    CmdSGDescriptor *     sgIn;
+    CmdSGDescriptor *     sgOut;
+    CmdHashHmacParameter2 param2;
+    VSMetaData            vsMetaData;
+    uint32_t              slotInfoBytes;
+    HsmCmdCtx             slotCtx; //Slot info command (ctx is being built)
+
+    HsmCmdCtxInit(ctx);
+
+    //RAW key slot without APL (no AUTH data with the command)
+    if ((HsmCmdVsmGetSlotInfoCachedCtx(&slotCtx, vsSlotNum,
+                                       &vsMetaData, &slotInfoBytes) != 0) ||
+        (vsMetaData.vsHeader.s.vsSlotNum != vsSlotNum) ||
+        (vsMetaData.vsHeader.s.vsSlotType != VSS_RAW) ||
+        (vsMetaData.vsHeader.s.vsStorageInfo.s.apl != 0) ||
+        ((vsMetaData.vsHeader.s.vsStorageInfo.s.storageType != NVM_UNENCRYPTED) &&
+         (vsMetaData.vsHeader.s.vsStorageInfo.s.storageType != VM_STORAGE)))
+    {
+        rsp->invSlot = true; //Invalid Slot
+        return rsp;
+    }
+
+    ctx->req.mbHeader  = 0x00f00018;
+    ctx->req.cmdHeader = HsmHashCmdHeader(CMD_HASH_HMAC, hashType, true);
+
+    param2.v           = 0;
+    param2.s.lastData  = 1;
+    param2.s.slotIndex = vsSlotNum;
+
+    ctx->req.cmdInputs[2] = numDataBytes;
+    ctx->req.cmdInputs[3] = param2.v;
+
+    segIn.addr      = data;
+    segIn.numBytes  = numDataBytes;
+    segOut.addr     = mac;
+    segOut.numBytes = HsmHashDigestBytes(hashType);
+
+    ctx->req.expMbHeader     = 0x00200010; //Hash size word
+    ctx->req.expResultCode   = S_OK;
+    ctx->req.expStatus       = 0x00000320;
+    ctx->req.expIntFlag      = 0x00000000;
+    ctx->req.expData         = 0x00000000;
+    ctx->req.expNumDataBytes = segOut.numBytes;
+
+    sgIn  = HsmSGChainAlloc(&segIn, 1);
+    sgOut = HsmSGChainAlloc(&segOut, 1);
+    if (sgIn == NULL || sgOut == NULL)
+    {
+        HsmSGChainFree(sgIn);
+        HsmSGChainFree(sgOut);
+        rsp->invArgs = true;
+        return rsp;
+    }
+    HsmSGCtxSet(ctx, sgIn, sgOut);
+
+    HsmCmdCtxExec(ctx);
+    HsmSGChainFree(sgIn);
+    HsmSGChainFree(sgOut);
+
+    HsmCmdCtxRspChkr(ctx, true);
+    return rsp;
+} //End HsmCmdHmacCmd()
+
+
+//******************************************************************************
+// HMAC output (generate) or constant time compare (verify) of the HSM HMAC
+// --rsp->rspChksPassed is false (E_INPUTAUTH) if the mac does not match
+//******************************************************************************
+static RSP_DATA * HsmCmdHmacTag(HsmCmdCtx * ctx,
+                                uint8_t *   hsmMac,
+                                bool        verify,
+                                uint8_t *   mac,
+                                uint32_t    macBytes)
+{
+    RSP_DATA * rsp = &ctx->rspData;
+    uint8_t    diff = 0;
+    uint32_t   i;
+
+    if (!verify)
+    {
+        memcpy(mac, hsmMac, macBytes);
+        return rsp;
+    }
+
+    for (i = 0; i < macBytes; i++) diff |= hsmMac[i] ^ mac[i];
+    if (diff != 0)
+    {
+        rsp->rspChksPassed = false;
+        rsp->testFailCnt++;
+        rsp->resultCode    = E_INPUTAUTH;
+    }
+    return rsp;
+} //End HsmCmdHmacTag()
+#endif //HSM_HASH_HMAC_ENABLE
+
+
+//******************************************************************************
+//HASH BLOCK Command (MD5/SHA1/SHA224/SHA256/SHA384/SHA512)
+//--Build the command request in ctx only (not sent, see HsmCmdBankSubmit())
+//--dataOut has HsmHashDigestBytes(hashType) bytes
+//--Any input size up to HSM_CMD_CTX_SG_DESC * HSM_SG_MAX_LENGTH bytes: the
+//  HSM keeps the hash state over the descriptor chain (rsp->invArgs if 
+//  larger).
+//******************************************************************************
+
+RSP_DATA * HsmCmdHashBlockPrep(
+        HsmCmdCtx * ctx,
+        CmdHashTypes hashType,
         uint8_t * dataIn,
         int numDataInBytes,
         uint8_t * dataOut) {
-    RSP_DATA * rsp = &gRspData;
-    //static int numDataBytes = 0;
+    RSP_DATA * rsp = &ctx->rspData;
+    uint32_t digestBytes = HsmHashDigestBytes(hashType);
 
-    rsp = &gRspData;
+    HsmCmdCtxInit(ctx);
 
-    rsp->invArgs = false;
-
-    // Make sure the HSM is not busy
-    while (HSM_REGS->HSM_STATUS & HSM_STATUS_BUSY_Msk);
+    if (digestBytes == 0) {
+        rsp->invArgs = true;
+        return rsp;
+    }
 
     //TODO: Pad input data to 32bit boundary
 
     // Send HASH BLOCK command request to HSM MB 
     // -- External Data
     // -- External Result
-    gHsmCmdReq.mbHeader = 0x00f00018;
-    gHsmCmdReq.cmdHeader = CMD_HASH_HASH_BLOCK_SHA256_INST,
-            gHsmCmdReq.cmdInputs[0] = (uint32_t) (&(dmaDescriptorIn[0])); // Unused
-    gHsmCmdReq.cmdInputs[1] = (uint32_t) (&(dmaDescriptorOut[0])); // Unused
-    gHsmCmdReq.cmdInputs[2] = numDataInBytes;
-    gHsmCmdReq.cmdInputs[3] = 0x00000000; // Unused
-
-    gHsmCmdReq.expMbHeader = 0x00200010;
-    gHsmCmdReq.expResultCode = S_OK;
-    gHsmCmdReq.expStatus = 0x00000320;
-    gHsmCmdReq.expIntFlag = 0x00000000;
-    gHsmCmdReq.expData = expHashBlockResult;
-    gHsmCmdReq.expNumDataBytes = HASH_SHA256_RESULT_BYTES;
-
-    dmaDescriptorIn[0].data.addr = dataIn;
-    dmaDescriptorIn[0].next.s.stop = 1;
-    dmaDescriptorIn[0].next.s.addr = 0;
-    //dmaDescriptorIn[0].flagsLength.s.length   = numDataBytes;
-    dmaDescriptorIn[0].flagsLength.s.length = numDataInBytes;
-    dmaDescriptorIn[0].flagsLength.s.cstAddr = 0;
-    dmaDescriptorIn[0].flagsLength.s.discard = 0;
-    dmaDescriptorIn[0].flagsLength.s.realign = 1;
-    dmaDescriptorIn[0].flagsLength.s.intEn = 0;
-
-    //dmaDescriptorOut[0].data.addr             = &hashInitBuffer;
-    dmaDescriptorOut[0].data.addr = dataOut;
-    dmaDescriptorOut[0].next.s.stop = 1;
-    dmaDescriptorOut[0].next.s.addr = 0;
-    dmaDescriptorOut[0].flagsLength.s.length = HASH_SHA256_RESULT_BYTES; //SHA26 Hash Size
-    dmaDescriptorOut[0].flagsLength.s.cstAddr = 0;
-    dmaDescriptorOut[0].flagsLength.s.discard = 0;
-    dmaDescriptorOut[0].flagsLength.s.realign = 1;
-    dmaDescriptorOut[0].flagsLength.s.intEn = 0;
-
-    //    SCB_CleanDCache_by_Addr((uint32_t *) dmaDescriptorIn,  sizeof(dmaDescriptorIn));
-    //   SCB_CleanDCache_by_Addr((uint32_t *) dmaDescriptorOut, sizeof(dmaDescriptorOut));
-    //   SCB_CleanInvalidateDCache_by_Addr(dataOut, sizeof(dataOut));
-    //   SCB_CleanInvalidateDCache_by_Addr((uint32_t *) dataIn, numDataInBytes);
-
-    HsmMbCmdDriver(&gHsmCmdReq, false);
+    ctx->req.mbHeader = 0x00f00018;
+    ctx->req.cmdHeader = HsmHashCmdHeader(CMD_HASH_HASH_BLOCK, hashType, false);
+    ctx->req.cmdInputs[2] = numDataInBytes;
+    ctx->req.cmdInputs[3] = 0x00000000; // Unused
+
+    ctx->req.expMbHeader = 0x00200010;
+    ctx->req.expResultCode = S_OK;
+    ctx->req.expStatus = 0x00000320;
+    ctx->req.expIntFlag = 0x00000000;
+    ctx->req.expData = 0x00000000;
+    ctx->req.expNumDataBytes = digestBytes;
+
+    //Input larger than one descriptor is chained (one HASH BLOCK command)
+    if (HsmCmdCtxSetSGData(ctx->dmaIn, HSM_CMD_CTX_SG_DESC, 
+                           dataIn, numDataInBytes) == 0) {
+        rsp->invArgs = true;
+        return rsp;
+    }
+    HsmCmdCtxSetSG(&ctx->dmaOut[0], dataOut, digestBytes, NULL);
+
+    //Data cache: HsmDmaCmdPrepare()/HsmDmaCmdComplete() (hsm_dma.c)
+
+    return rsp;
+
+} //End HsmCmdHashBlockPrep()
+
+
+//******************************************************************************
+//HASH BLOCK Command (any hash type)
+//--Command context variant (ctx->rspData has the response check results)
+//******************************************************************************
+
+RSP_DATA * HsmCmdHashBlockCtx(
+        HsmCmdCtx * ctx,
+        CmdHashTypes hashType,
+        uint8_t * dataIn,
+        int numDataInBytes,
+        uint8_t * dataOut) {
+    RSP_DATA * rsp;
+
+    rsp = HsmCmdHashBlockPrep(ctx, hashType, dataIn, numDataInBytes, dataOut);
+    if (rsp->invArgs) return rsp;
+
+    HsmCmdCtxExec(ctx);
 
     //Check the command response 
-    HsmCmdRspChkr(rsp, true);
+    HsmCmdCtxRspChkr(ctx, true);
 
     return rsp;
 
-} //End HsmCmdHashBlockSha256() 
\ No newline at end of file
+} //End HsmCmdHashBlockCtx()
+
+
+//******************************************************************************
+//HASH BLOCK Command (any hash type)
+//--Polled (interrupt mode:  HsmCmdHashBlockQueue())
+//******************************************************************************
+
+RSP_DATA * HsmCmdHashBlock(
+        CmdHashTypes hashType,
+        uint8_t * dataIn,
+        int numDataInBytes,
+        uint8_t * dataOut) {
+    HsmCmdHashBlockCtx(&gHsmCmdCtx, hashType, dataIn, numDataInBytes, dataOut);
+    return HsmCmdCtxPublish(&gHsmCmdCtx);
+} //End HsmCmdHashBlock()
+
+
+//******************************************************************************
+//HASH BLOCK Command (any hash type, queued)
+//--Prepared in a command queue entry and sent by the queue dispatcher 
+//  (interrupt mode), callback(ctx, context) on completion (hsm_queue.h).
+//--Returns false if the queue is full (nothing queued)
+//******************************************************************************
+
+bool HsmCmdHashBlockQueue(
+        CmdHashTypes hashType,
+        uint8_t * dataIn,
+        int numDataInBytes,
+        uint8_t * dataOut,
+        HsmCmdQueueCallback callback,
+        void * context) {
+    HsmCmdQueueEntry * entry;
+
+    entry = HsmCmdQueueAlloc();
+    if (entry == NULL) return false;
+
+    HsmCmdHashBlockPrep(&entry->ctx, hashType, dataIn, numDataInBytes, dataOut);
+    HsmCmdQueueSubmit(entry, callback, context);
+
+    return true;
+} //End HsmCmdHashBlockQueue()
+
+
+//******************************************************************************
+//HASH BLOCK Command Cmd - 1
+//--Build the command request in ctx only (not sent, see HsmCmdBankSubmit())
+//******************************************************************************
+
+RSP_DATA * HsmCmdHashBlockSha256Prep(
+        HsmCmdCtx * ctx,
+        uint8_t * dataIn,
+        int numDataInBytes,
+        uint8_t * dataOut) {
+    RSP_DATA * rsp;
+
+    rsp = HsmCmdHashBlockPrep(ctx, CMD_HASH_SHA256, 
+                              dataIn, numDataInBytes, dataOut);
+    ctx->req.expData = expHashBlockResult;
+
+    return rsp;
+
+} //End HsmCmdHashBlockSha256Prep()
+
+
+//******************************************************************************
+//HASH BLOCK Command Cmd - 1
+//--Command context variant (ctx->rspData has the response check results)
+//******************************************************************************
+
+RSP_DATA * HsmCmdHashBlockSha256Ctx(
+        HsmCmdCtx * ctx,
+        uint8_t * dataIn,
+        int numDataInBytes,
+        uint8_t * dataOut) {
+    RSP_DATA * rsp;
+
+    rsp = HsmCmdHashBlockSha256Prep(ctx, dataIn, numDataInBytes, dataOut);
+    if (rsp->invArgs) return rsp;
+
+    HsmCmdCtxExec(ctx);
+
+    //Check the command response 
+    HsmCmdCtxRspChkr(ctx, true);
+
+    return rsp;
+
+} //End HsmCmdHashBlockSha256Ctx()
+
+
+//******************************************************************************
+//HASH BLOCK Command Cmd - 1
+//--Hash of the concatenated segments (fragmented input, e.g. header and
+//  payload), no copy to a contiguous input buffer.
+//--rsp->invArgs is set if the SG pool does not have a descriptor per segment.
+//******************************************************************************
+
+RSP_DATA * HsmCmdHashBlockSha256SGCtx(
+        HsmCmdCtx * ctx,
+        const HsmSGSegment * seg,
+        int numSeg,
+        uint8_t * dataOut) {
+    RSP_DATA * rsp;
+    CmdSGDescriptor * sgIn;
+    uint32_t numDataInBytes = 0;
+    int i;
+
+    for (i = 0; i < numSeg; i++) numDataInBytes += seg[i].numBytes;
+
+    rsp = HsmCmdHashBlockSha256Prep(ctx, NULL, numDataInBytes, dataOut);
+    if (rsp->invArgs) return rsp;
+
+    sgIn = HsmSGChainAlloc(seg, numSeg);
+    if (sgIn == NULL) {
+        rsp->invArgs = true;
+        return rsp;
+    }
+    HsmSGCtxSet(ctx, sgIn, NULL);
+
+    HsmCmdCtxExec(ctx);
+    HsmSGChainFree(sgIn);
+
+    //Check the command response
+    HsmCmdCtxRspChkr(ctx, true);
+
+    return rsp;
+
+} //End HsmCmdHashBlockSha256SGCtx()
+
+
+//******************************************************************************
+//HASH BLOCK Command Cmd - 1
+//--TODO: Interrupt Mode
+//******************************************************************************
+
+RSP_DATA * HsmCmdHashBlockSha256(
+        uint8_t * dataIn,
+        int numDataInBytes,
+        uint8_t * dataOut) {
+    HsmCmdHashBlockSha256Ctx(&gHsmCmdCtx, dataIn, numDataInBytes, dataOut);
+    return HsmCmdCtxPublish(&gHsmCmdCtx);
+} //End HsmCmdHashBlockSha256() 
+
+
+//******************************************************************************
+//HASH Digest bytes of a hash type (0: not supported)
+//******************************************************************************
+
+uint32_t HsmHashDigestBytes(CmdHashTypes hashType) {
+    switch (hashType) {
+        case CMD_HASH_MD5:    return HASH_MD5_RESULT_BYTES;
+        case CMD_HASH_SHA1:   return HASH_SHA1_RESULT_BYTES;
+        case CMD_HASH_SHA224: return HASH_SHA224_RESULT_BYTES;
+        case CMD_HASH_SHA256: return HASH_SHA256_RESULT_BYTES;
+        case CMD_HASH_SHA384: return HASH_SHA384_RESULT_BYTES;
+        case CMD_HASH_SHA512: return HASH_SHA512_RESULT_BYTES;
+        default:              return 0;
+    }
+} //End HsmHashDigestBytes()
+
+
+#if HSM_HASH_STREAM_ENABLE
+//******************************************************************************
+//HASH INIT Command (CMD_HASH_HASH_INIT)
+//--Start a hash stream (HsmCmdHashUpdateCtx() for the data, 
+//  HsmCmdHashFinalCtx() for the digest), e.g. for an image or a file 
+//  received in pieces, without a buffer of the whole object.
+//--The intermediate state is exported to hash->state (HsmHashCtx), streams
+//  can be interleaved with each other and with the other hash commands.
+//******************************************************************************
+
+RSP_DATA * HsmCmdHashInitCtx(
+        HsmCmdCtx * ctx,
+        HsmHashCtx * hash,
+        CmdHashTypes hashType) {
+    memset(hash, 0, sizeof(HsmHashCtx));
+    hash->hashType = hashType;
+
+    if (HsmHashBlockBytes(hashType) == 0) {
+        HsmCmdCtxInit(ctx);
+        ctx->rspData.invArgs = true;
+        return &ctx->rspData;
+    }
+
+    return HsmCmdHashStreamCmd(ctx, hash, CMD_HASH_HASH_INIT, NULL, 0, NULL);
+
+} //End HsmCmdHashInitCtx()
+
+
+//******************************************************************************
+//HASH UPDATE Command (CMD_HASH_HASH_UPDATE)
+//--Next data of the hash stream, any number of bytes.  Whole blocks are
+//  sent, the last 1 to block size bytes are held back (hash->pend) for the
+//  HASH_FINALIZE command.
+//--The stream is not advanced when the command fails.
+//******************************************************************************
+
+RSP_DATA * HsmCmdHashUpdateCtx(
+        HsmCmdCtx * ctx,
+        HsmHashCtx * hash,
+        uint8_t * data,
+        uint32_t numDataBytes) {
+    RSP_DATA * rsp = &ctx->rspData;
+    uint32_t blockBytes = HsmHashBlockBytes(hash->hashType);
+    uint32_t numBytes = hash->pendBytes + numDataBytes;
+    uint32_t sendBytes;
+
+    if (!hash->started) {
+        HsmCmdCtxInit(ctx);
+        rsp->invArgs = true;
+        return rsp;
+    }
+
+    if (numBytes <= blockBytes) {
+        //No command sent
+        ClearRspData(rsp);
+        rsp->resultCode = S_OK;
+        rsp->rspChksPassed = true;
+        memcpy((uint8_t *) hash->pend + hash->pendBytes, data, numDataBytes);
+        hash->pendBytes = numBytes;
+        hash->numBytes += numDataBytes;
+        return rsp;
+    }
+
+    //Whole blocks before the last 1 to block size bytes
+    sendBytes = ((numBytes - 1) / blockBytes) * blockBytes;
+    sendBytes -= hash->pendBytes;
+
+    rsp = HsmCmdHashStreamCmd(ctx, hash, CMD_HASH_HASH_UPDATE, 
+                              data, sendBytes, NULL);
+    if (!rsp->rspChksPassed) return rsp;
+
+    hash->pendBytes = numDataBytes - sendBytes;
+    memcpy(hash->pend, data + sendBytes, hash->pendBytes);
+    hash->numBytes += numDataBytes;
+
+    return rsp;
+
+} //End HsmCmdHashUpdateCtx()
+
+
+//******************************************************************************
+//HASH FINALIZE Command (CMD_HASH_HASH_FINALIZE)
+//--Digest of the stream (HsmHashDigestBytes() to digest), the stream ends.
+//******************************************************************************
+
+RSP_DATA * HsmCmdHashFinalCtx(
+        HsmCmdCtx * ctx,
+        HsmHashCtx * hash,
+        uint8_t * digest) {
+    RSP_DATA * rsp;
+
+    if (!hash->started || digest == NULL) {
+        HsmCmdCtxInit(ctx);
+        ctx->rspData.invArgs = true;
+        return &ctx->rspData;
+    }
+
+    rsp = HsmCmdHashStreamCmd(ctx, hash, CMD_HASH_HASH_FINALIZE, 
+                              NULL, 0, digest);
+    if (rsp->rspChksPassed) {
+        memset(hash->state, 0, sizeof(hash->state));
+        memset(hash->pend, 0, sizeof(hash->pend));
+        hash->pendBytes = 0;
+    }
+
+    return rsp;
+
+} //End HsmCmdHashFinalCtx()
+#endif //HSM_HASH_STREAM_ENABLE
+
+
+#if HSM_HASH_HMAC_ENABLE
+//******************************************************************************
+//HMAC Generate/Verify Command (CMD_HASH_HMAC)
+//--One shot, one command.  The key is a RAW slot (unencrypted or VM_STORAGE,
+//  no APL), it is not sent or read by the host.
+//--HMAC of the data (macBytes 10 to the digest size, truncated HMAC)
+//--verify:  mac is compared (constant time), rsp->rspChksPassed is false 
+//  (E_INPUTAUTH) if it does not match.  Else mac is output.
+//--Command context variant (ctx->rspData has the response check results)
+//******************************************************************************
+
+RSP_DATA * HsmCmdHmacCtx(
+        HsmCmdCtx * ctx,
+        int vsSlotNum, //HMAC Key
+        CmdHashTypes hashType,
+        uint8_t * data,
+        uint32_t numDataBytes,
+        uint8_t * mac,
+        uint32_t macBytes,
+        bool verify) {
+    uint32_t ALIGN4 hsmMac[HASH_SHA512_RESULT_BYTES / BYTES_PER_WORD];
+    RSP_DATA * rsp = &ctx->rspData;
+
+    if (hashType < CMD_HASH_SHA1 || hashType > CMD_HASH_SHA512 ||
+        vsSlotNum <= MINSLOTNUM || vsSlotNum >= MAXSLOTNUM ||
+        mac == NULL || macBytes < 10 || macBytes > HsmHashDigestBytes(hashType)) {
+        HsmCmdCtxInit(ctx);
+        rsp->invArgs = true;
+        return rsp;
+    }
+
+    rsp = HsmCmdHmacCmd(ctx, vsSlotNum, hashType, data, numDataBytes,
+                        (uint8_t *) hsmMac);
+    if (rsp->rspChksPassed) {
+        rsp = HsmCmdHmacTag(ctx, (uint8_t *) hsmMac, verify, mac, macBytes);
+    }
+    memset(hsmMac, 0, sizeof(hsmMac));
+
+    return rsp;
+
+} //End HsmCmdHmacCtx()
+
+
+//******************************************************************************
+//HMAC Generate Command (CMD_HASH_HMAC)
+//******************************************************************************
+
+RSP_DATA * HsmCmdHmacGenerate(
+        int vsSlotNum, //HMAC Key
+        CmdHashTypes hashType,
+        uint8_t * data,
+        uint32_t numDataBytes,
+        uint8_t * mac,
+        uint32_t macBytes) {
+    HsmCmdHmacCtx(&gHsmCmdCtx, vsSlotNum, hashType, 
+                  data, numDataBytes, mac, macBytes, false);
+    return HsmCmdCtxPublish(&gHsmCmdCtx);
+} //End HsmCmdHmacGenerate()
+
+
+//******************************************************************************
+//HMAC Verify Command (CMD_HASH_HMAC)
+//--rsp->rspChksPassed is false (E_INPUTAUTH) if the mac does not match
+//******************************************************************************
+
+RSP_DATA * HsmCmdHmacVerify(
+        int vsSlotNum, //HMAC Key
+        CmdHashTypes hashType,
+        uint8_t * data,
+        uint32_t numDataBytes,
+        uint8_t * mac,
+        uint32_t macBytes) {
+    HsmCmdHmacCtx(&gHsmCmdCtx, vsSlotNum, hashType, 
+                  data, numDataBytes, mac, macBytes, true);
+    return HsmCmdCtxPublish(&gHsmCmdCtx);
+} //End HsmCmdHmacVerify()
+#endif //HSM_HASH_HMAC_ENABLE
@@ -18,6 +18,8 @@
 #include "hsm_host/hsm_command.h"
 #include "hsm_host/hsm_command_globals.h"
 #include "vsm.h"
+#include "hsm_sg.h"
+#include "hsm_queue.h"
 
 #ifndef _HASH_H
 #define _HASH_H
@@ -29,6 +31,18 @@ extern "C" {
 
 #define SHA256_NUMBYTES        (256/8)
 
+//Hash commands with an unverified command layout.  The HSM command spec in
+//this tree does not define the CMD_HASH_HMAC param2 (CmdHashHmacParameter2)
+//or where HASH_UPDATE/HASH_FINALIZE read the stream state (HsmHashCtx).
+//Set to 1 only once verified on the HSM (TestHsmCmdHmacSha256Slot(),
+//TestHsmCmdHashSha256Stream()).
+#ifndef HSM_HASH_HMAC_ENABLE
+#define HSM_HASH_HMAC_ENABLE   0
+#endif
+#ifndef HSM_HASH_STREAM_ENABLE
+#define HSM_HASH_STREAM_ENABLE 0
+#endif
+
 typedef enum _CmdHashCommandTypes
 {
     CMD_HASH_HASH_BLOCK    = 0,
@@ -127,12 +141,125 @@ typedef struct
     CmdHashBlockHashResults size;
 } CmdHashBlockHashResponse;
 
+#define HASH_MAX_BLOCK_BYTES   128 //SHA-384/SHA-512 block
+#define HASH_MAX_STATE_BYTES   64  //SHA-384/SHA-512 state (8 64-bit words)
+
+#if HSM_HASH_HMAC_ENABLE
+// CMD_HASH_HMAC (slotParamInc:  key of the VSM slot, never in the host)
+// --Param1: data size, param2 below.
+// --IN SG:  data,  OUT SG: HMAC
+// --UNVERIFIED (HSM_HASH_HMAC_ENABLE):  The fields below are assumed.  Only
+//   the one shot command is used (lastData, no useCtx), there is no HMAC
+//   stream.
+typedef union 
+{
+    struct 
+    {
+        unsigned char  useCtx       :1; //Continue the HMAC (not used)
+        unsigned char               :1;
+        unsigned char  lastData     :1; //Last data, output the HMAC
+        unsigned char               :5;
+        unsigned char  slotIndex;       //HMAC key slot
+        unsigned short              :16;
+    } s;
+    uint32_t v;
+} CmdHashHmacParameter2;
+#endif //HSM_HASH_HMAC_ENABLE
+
+#if HSM_HASH_STREAM_ENABLE
+// Hash stream (HsmCmdHashInitCtx()/HsmCmdHashUpdateCtx()/HsmCmdHashFinalCtx())
+// --The intermediate state (hash words) is exported to the host:  HASH_INIT
+//   and HASH_UPDATE write it to OUT, HASH_UPDATE and HASH_FINALIZE read it
+//   from the start of IN (UNVERIFIED, HSM_HASH_STREAM_ENABLE).  Any number of
+//   streams can be interleaved with each other and with the other hash
+//   commands.
+typedef struct
+{
+    CmdHashTypes    hashType;
+    bool            started;    //HASH_INIT passed (state valid)
+    uint64_t        numBytes;   //Message bytes so far
+    uint32_t ALIGN4 state[HASH_MAX_STATE_BYTES / BYTES_PER_WORD];
+    uint32_t        pendBytes;  //Held back for the last block (1-block size)
+    uint32_t ALIGN4 pend[HASH_MAX_BLOCK_BYTES / BYTES_PER_WORD];
+} HsmHashCtx;
+#endif //HSM_HASH_STREAM_ENABLE
+
 extern uint8_t  ALIGN4   hashInitBuffer[64];
 extern uint8_t  ALIGN4   expHashBlockResult[SHA256_NUMBYTES];
 
 RSP_DATA * HsmCmdHashBlockSha256(uint8_t * dataIn,  
                                  int       numDataInBytes, 
                                  uint8_t * dataOut);
+RSP_DATA * HsmCmdHashBlockSha256Prep(HsmCmdCtx * ctx,
+                                     uint8_t *   dataIn,  
+                                     int         numDataInBytes, 
+                                     uint8_t *   dataOut);
+RSP_DATA * HsmCmdHashBlockSha256Ctx(HsmCmdCtx * ctx,
+                                    uint8_t *   dataIn,  
+                                    int         numDataInBytes, 
+                                    uint8_t *   dataOut);
+RSP_DATA * HsmCmdHashBlockSha256SGCtx(HsmCmdCtx *          ctx,
+                                      const HsmSGSegment * seg,
+                                      int                  numSeg,
+                                      uint8_t *            dataOut);
+
+RSP_DATA * HsmCmdHashBlock(CmdHashTypes hashType,
+                           uint8_t *    dataIn,
+                           int          numDataInBytes,
+                           uint8_t *    dataOut);
+bool       HsmCmdHashBlockQueue(CmdHashTypes        hashType,
+                                uint8_t *           dataIn,
+                                int                 numDataInBytes,
+                                uint8_t *           dataOut,
+                                HsmCmdQueueCallback callback,
+                                void *              context);
+RSP_DATA * HsmCmdHashBlockPrep(HsmCmdCtx *  ctx,
+                               CmdHashTypes hashType,
+                               uint8_t *    dataIn,
+                               int          numDataInBytes,
+                               uint8_t *    dataOut);
+RSP_DATA * HsmCmdHashBlockCtx(HsmCmdCtx *  ctx,
+                              CmdHashTypes hashType,
+                              uint8_t *    dataIn,
+                              int          numDataInBytes,
+                              uint8_t *    dataOut);
+
+uint32_t   HsmHashDigestBytes(CmdHashTypes hashType);
+#if HSM_HASH_STREAM_ENABLE
+RSP_DATA * HsmCmdHashInitCtx(HsmCmdCtx *  ctx,
+                             HsmHashCtx * hash,
+                             CmdHashTypes hashType);
+RSP_DATA * HsmCmdHashUpdateCtx(HsmCmdCtx *  ctx,
+                               HsmHashCtx * hash,
+                               uint8_t *    data,
+                               uint32_t     numDataBytes);
+RSP_DATA * HsmCmdHashFinalCtx(HsmCmdCtx *  ctx,
+                              HsmHashCtx * hash,
+                              uint8_t *    digest);
+#endif //HSM_HASH_STREAM_ENABLE
+
+#if HSM_HASH_HMAC_ENABLE
+RSP_DATA * HsmCmdHmacGenerate(int          vsSlotNum,  //HMAC Key
+                              CmdHashTypes hashType,
+                              uint8_t *    data,
+                              uint32_t     numDataBytes,
+                              uint8_t *    mac,
+                              uint32_t     macBytes);
+RSP_DATA * HsmCmdHmacVerify(int          vsSlotNum,  //HMAC Key
+                            CmdHashTypes hashType,
+                            uint8_t *    data,
+                            uint32_t     numDataBytes,
+                            uint8_t *    mac,
+                            uint32_t     macBytes);
+RSP_DATA * HsmCmdHmacCtx(HsmCmdCtx *  ctx,
+                         int          vsSlotNum,  //HMAC Key
+                         CmdHashTypes hashType,
+                         uint8_t *    data,
+                         uint32_t     numDataBytes,
+                         uint8_t *    mac,
+                         uint32_t     macBytes,
+                         bool         verify);
+#endif //HSM_HASH_HMAC_ENABLE
 
 /* Provide C++ Compatibility */
 #ifdef __cplusplus
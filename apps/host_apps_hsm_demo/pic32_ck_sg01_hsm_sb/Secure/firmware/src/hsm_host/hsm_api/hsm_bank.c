@@ -0,0 +1,191 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Microchip Technology
+
+  @File Name
+    hsm_bank.c
+
+  @Summary
+    HSM Command Context Banks (ping-pong)
+
+  @Description
+    Command contexts used in turn so the next command is built while the HSM
+    executes the current one.
+ */
+/* ************************************************************************** */
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Included Files                                                    */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+#include <stdlib.h>
+#include <string.h>
+#include "pic32ck2051sg01144.h"
+#include "core_cm33.h"
+#include "user.h"
+#include "hsm_sg.h"
+#include "hsm_bank.h"
+
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Local Functions                                                   */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+//******************************************************************************
+// Bank entry command completion (called from HSM_RXINT_Handler())
+//******************************************************************************
+static void HsmCmdBankComplete(HsmCmdResp * cmdRsp, void * context)
+{
+    HsmCmdBankEntry * entry = (HsmCmdBankEntry *) context;
+
+    entry->state = HSM_BANK_DONE;
+} //End HsmCmdBankComplete()
+
+
+//******************************************************************************
+// Collect the bank entry command
+// --Wait for the command to complete, check the response and call the
+//   callback.
+// --An entry prepared but never submitted (PREP) has no response:  the SG
+//   pool chains of its request are freed (HsmSGChainFree() skips the
+//   context descriptors), no callback.
+// --The entry is free on return.
+//******************************************************************************
+static void HsmCmdBankCollect(HsmCmdBankEntry * entry)
+{
+    while (entry->state == HSM_BANK_ACTIVE)
+    {
+        HsmMbCmdWait();
+    }
+
+    if (entry->state == HSM_BANK_DONE)
+    {
+        HsmCmdCtxRspChkr(&entry->ctx, true);
+        if (entry->callback != NULL)
+        {
+            entry->callback(&entry->ctx, entry->context);
+        }
+    }
+    else if (entry->state == HSM_BANK_PREP)
+    {
+        HsmSGChainFree((CmdSGDescriptor *) entry->ctx.req.cmdInputs[0]);
+        HsmSGChainFree((CmdSGDescriptor *) entry->ctx.req.cmdInputs[1]);
+    }
+
+    entry->state = HSM_BANK_FREE;
+} //End HsmCmdBankCollect()
+
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Interface Functions                                               */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+//******************************************************************************
+// Initialize the bank set (all entries free)
+//******************************************************************************
+void HsmCmdBankInit(HsmCmdBank * bank)
+{
+    memset(bank, 0, sizeof(HsmCmdBank));
+} //End HsmCmdBankInit()
+
+
+//******************************************************************************
+// Next command context to prepare (HsmCmd*Prep())
+// --Collects the previous command of that entry first (waits only if it is
+//   still in the HSM, i.e. HSM_CMD_BANKS commands ago).
+// --The context is cleared (HsmCmdCtxInit()), IN/OUT SG on its descriptors.
+//******************************************************************************
+HsmCmdCtx * HsmCmdBankPrepare(HsmCmdBank * bank)
+{
+    HsmCmdBankEntry * entry;
+
+    entry = &bank->entry[bank->next % HSM_CMD_BANKS];
+    bank->next++;
+
+    HsmCmdBankCollect(entry);
+    HsmCmdCtxInit(&entry->ctx);
+    entry->callback = NULL;
+    entry->context  = NULL;
+    entry->state = HSM_BANK_PREP;
+
+    return &entry->ctx;
+} //End HsmCmdBankPrepare()
+
+
+//******************************************************************************
+// Bank entry index of a command context (0..HSM_CMD_BANKS-1, -1: not in the
+// bank), e.g. for caller data kept per entry
+//******************************************************************************
+int HsmCmdBankIndex(HsmCmdBank * bank, HsmCmdCtx * ctx)
+{
+    int i;
+
+    for (i = 0; i < HSM_CMD_BANKS; i++)
+    {
+        if (&bank->entry[i].ctx == ctx) return i;
+    }
+
+    return -1;
+} //End HsmCmdBankIndex()
+
+
+//******************************************************************************
+// Send the prepared command context to the HSM MB (interrupt mode)
+// --Waits only for the previous command to complete.
+// --callback(ctx, context) is called when the command is collected (next
+//   HsmCmdBankPrepare() of the entry or HsmCmdBankFlush()), can be NULL.
+// --Returns false if the command was not sent (HSMBUSYERR, the callback is
+//   still called)
+//******************************************************************************
+bool HsmCmdBankSubmit(HsmCmdBank *       bank,
+                      HsmCmdCtx *        ctx,
+                      HsmCmdBankCallback callback,
+                      void *             context)
+{
+    HsmCmdBankEntry * entry;
+    int               index = HsmCmdBankIndex(bank, ctx);
+
+    if (index < 0) return false;
+    entry = &bank->entry[index];
+    if (entry->state != HSM_BANK_PREP) return false;
+
+    entry->callback = callback;
+    entry->context  = context;
+    entry->state    = HSM_BANK_ACTIVE;
+
+    if (!HsmCmdCtxSubmit(ctx, HsmCmdBankComplete, entry))
+    {
+        entry->state = HSM_BANK_DONE;
+        return false;
+    }
+
+    return true;
+} //End HsmCmdBankSubmit()
+
+
+//******************************************************************************
+// Collect all the submitted commands (in submit order)
+// --Prepared entries not submitted are freed (SG pool chains back)
+//******************************************************************************
+void HsmCmdBankFlush(HsmCmdBank * bank)
+{
+    int i;
+
+    for (i = 0; i < HSM_CMD_BANKS; i++)
+    {
+        HsmCmdBankCollect(&bank->entry[(bank->next + i) % HSM_CMD_BANKS]);
+    }
+} //End HsmCmdBankFlush()
+
+
+/* *****************************************************************************
+ End of File
+ */
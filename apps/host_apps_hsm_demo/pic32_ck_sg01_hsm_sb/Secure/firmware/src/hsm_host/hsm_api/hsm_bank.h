@@ -0,0 +1,119 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Microchip Technology
+
+  @File Name
+    hsm_bank.h
+
+  @Summary
+    HSM Command Context Banks (ping-pong)
+
+  @Description
+    HSM_CMD_BANKS command contexts (request, SG descriptors and response)
+    used in turn, so the next command is built (HsmCmd*Prep()) while the HSM
+    executes the current one:
+
+        HsmCmdBankInit(&bank);
+        for (...)
+        {
+            ctx = HsmCmdBankPrepare(&bank);        //Next free bank
+            HsmCmdAesEcbEncryptDecryptPrep(ctx, ...);
+            HsmCmdBankSubmit(&bank, ctx, cb, cbContext);
+        }
+        HsmCmdBankFlush(&bank);
+
+    Submit sends the command (interrupt mode) as soon as the previous one
+    completes.  The responses are checked and the callbacks called from the
+    caller context (Prepare/Flush), not from the HSM RXINT interrupt.
+ */
+/* ************************************************************************** */
+
+#ifndef _HSM_BANK_H    /* Guard against multiple inclusion */
+#define _HSM_BANK_H
+
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Included Files                                                    */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "hsm_command.h"
+
+/* Provide C++ Compatibility */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Constants                                                         */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+#define HSM_CMD_BANKS     2  //Command contexts per bank set (>= 2)
+
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Data Types
+// *****************************************************************************
+// *****************************************************************************
+
+typedef enum _HsmCmdBankState
+{
+    HSM_BANK_FREE   = 0,  //Response collected
+    HSM_BANK_PREP   = 1,  //Given to the caller (being prepared)
+    HSM_BANK_ACTIVE = 2,  //Sent to the HSM MB, waiting for RXINT
+    HSM_BANK_DONE   = 3,  //Response received, not collected
+} HsmCmdBankState;
+
+// Bank command completion (caller context)
+// --ctx->rsp/ctx->rspData are the command response and check results
+typedef void (*HsmCmdBankCallback)(HsmCmdCtx * ctx, void * context);
+
+typedef struct
+{
+    HsmCmdCtx                ctx;
+    volatile HsmCmdBankState state;
+    HsmCmdBankCallback       callback;
+    void *                   context;
+} HsmCmdBankEntry;
+
+typedef struct
+{
+    HsmCmdBankEntry          entry[HSM_CMD_BANKS];
+    uint32_t                 next;  //Next entry to prepare (free running)
+} HsmCmdBank;
+
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+
+void        HsmCmdBankInit(HsmCmdBank * bank);
+HsmCmdCtx * HsmCmdBankPrepare(HsmCmdBank * bank);
+int         HsmCmdBankIndex(HsmCmdBank * bank, HsmCmdCtx * ctx);
+bool        HsmCmdBankSubmit(HsmCmdBank *       bank,
+                             HsmCmdCtx *        ctx,
+                             HsmCmdBankCallback callback,
+                             void *             context);
+void        HsmCmdBankFlush(HsmCmdBank * bank);
+
+/* Provide C++ Compatibility */
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _HSM_BANK_H */
+
+/* *****************************************************************************
+ End of File
+ */
@@ -9,6 +9,10 @@
 #include "hsm_command_globals.h"
 #include "vsm.h"
 #include "hash.h"
+#include "hsm_stats.h"
+#include "hsm_trace.h"
+#include "hsm_timeout.h"
+#include "hsm_dma.h"
 
 //******************************************************************************
 //******************************************************************************
@@ -49,9 +53,25 @@ char *   cmdRCStr                           = 0;
 uint32_t  __attribute__((unused)) hsmStatus = 0;
 int  hsmCmdLength                           = 0;
 
-int  responseDelay                          = 100000;
 int  temp;
 
+//Interrupt mode (RXINT) command completion 
+static HsmCmdResp * volatile   hsmIntRsp      = &gHsmCmdResp;
+static HsmCmdCallback volatile hsmIntCallback = NULL;
+static void * volatile         hsmIntContext  = NULL;
+static HsmCmdReq * volatile    hsmIntReq      = &gHsmCmdReq;
+static HsmDeadline             hsmIntDeadline;
+static volatile bool           hsmIntPending  = false;
+static volatile bool           hsmPollPending = false;
+
+//Timed out command response can still be written to the MB (see 
+//HsmMbRspFlush())
+static volatile bool           hsmMbStaleRsp  = false;
+
+//Command completion wait 
+static HsmMbWaitMode           hsmMbWaitMode  = HSM_MB_WAIT_AUTO;
+static volatile bool           hsmIntSleep    = false;
+
 
 //******************************************************************************
 //******************************************************************************
@@ -107,23 +127,22 @@ int SendHsmCommandRequest()
     //HSM MB Status Reg:
     uint32_t mbrxstatus;
     uint32_t mbtxstatus;
+    HsmDeadline deadline;
 
     mbrxstatus = HSM_REGS->HSM_MBRXSTATUS;
-    SYS_PRINT("T0 MBRXSTATUS = 0x%08lx\r\n", mbrxstatus);
     mbtxstatus = HSM_REGS->HSM_MBTXSTATUS;
-    SYS_PRINT("T0 MBTXSTATUS = 0x%08lx\r\n", mbtxstatus);
 
     //Disable RX Interrupt
     HSM_REGS->HSM_MBCONFIG = HSM_MBCONFIG_RXINT(0);
 
     hsmStatus = HSM_REGS->HSM_STATUS; 
     GetHsmStatus(&busy, &ecode, &sbs, &lcs, &ps);
-    SYS_PRINT("T0 HSM Status: 0x%08lx\r\n", hsmStatus);
-    SYS_PRINT( "    %s  ECODE: %s\r\n    SBS: %s  LCS: %s  PS: %s\r\n",
-        busy?"BUSY":"NOT busy",ecodeStr[ecode], sbsStr[sbs], lcsStr[sbs], psStr[ps]);
+    HSM_TRACE(HSM_TRACE_MB_STATUS, HSM_TRACE_TAG_T0, 
+              mbrxstatus, mbtxstatus, hsmStatus);
 
     if (busy)
     {
+        HSM_TRACE(HSM_TRACE_CMD_ERR, HSMBUSYERR, hsmStatus, 0, 0);
         cmdRCStr = CmdResultCodeStr(HSMBUSYERR);
         return HSMBUSYERR; 
     }
@@ -139,71 +158,63 @@ int SendHsmCommandRequest()
     
     //Check the Status
     mbrxstatus = HSM_REGS->HSM_MBRXSTATUS;
-    SYS_PRINT("T1 MBRXSTATUS = 0x%08lx\r\n", mbrxstatus);
     mbtxstatus = HSM_REGS->HSM_MBTXSTATUS;
-    SYS_PRINT("T1 MBTXSTATUS = 0x%08lx\r\n", mbtxstatus);
+    HSM_TRACE(HSM_TRACE_MB_STATUS, HSM_TRACE_TAG_T1, 
+              mbrxstatus, mbtxstatus, hsmStatus);
 
-    //Clear the Data CACHE
-    //SCB_CleanDCache_by_Addr((uint32_t *) dmaDescriptorIn, sizeof(dmaDescriptorIn));
-   // SCB_CleanDCache_by_Addr((uint32_t *) dmaDescriptorOut, sizeof(dmaDescriptorOut));
-  //  SCB_CleanInvalidateDCache_by_Addr(dmaDataIn, sizeof(dmaDataIn));
-  //  SCB_CleanInvalidateDCache_by_Addr((uint32_t *) dmaDataOut, sizeof(dmaDataOut));
+    //Clean the Data CACHE (IN/OUT descriptors and data)
+    HsmDmaSGClean((CmdSGDescriptor *) globalCmdInput);
+    HsmDmaSGClean((CmdSGDescriptor *) globalCmdOutput);
 
     //Send the HSM Command Words
     HSM_REGS->HSM_MBTXHEAD = globalMbHeader; 
     hsmCmdLength = globalMbHeader & 0xff;
-    SYS_PRINT("  TX  MB: 0x%08lx\r\n", globalMbHeader);
-
     HSM_REGS->HSM_MBFIFO[0] = globalCmdHeader;
-    SYS_PRINT("  TX CMD: 0x%08lx\r\n", globalCmdHeader);
-
     HSM_REGS->HSM_MBFIFO[0] = globalCmdInput;
-    SYS_PRINT("  TX  IN: 0x%08lx\r\n", globalCmdInput);
-
     HSM_REGS->HSM_MBFIFO[0] = globalCmdOutput;
-    SYS_PRINT("  TX OUT: 0x%08lx\r\n", globalCmdOutput);
+    HSM_TRACE(HSM_TRACE_TX_CMD, globalMbHeader, globalCmdHeader, 
+              globalCmdInput, globalCmdOutput);
 
     //Parameter words after the first 4 words 
     ctr=0;
     while(hsmCmdLength > 0x10)//support Parameter Words
     {
         HSM_REGS->HSM_MBFIFO[0] = globalCmdParams[ctr];
-        SYS_PRINT("  TX PARAM%d: 0x%08lx\r\n", ctr, globalCmdParams[ctr]);
+        HSM_TRACE(HSM_TRACE_TX_PARAM, ctr, globalCmdParams[ctr], 0, 0);
         hsmCmdLength -= 4;
         ctr++;
     }
 
     hsmStatus = HSM_REGS->HSM_STATUS; 
-    SYS_PRINT("TC CMD HSM Status: 0x%08lx\r\n",hsmStatus);
     GetHsmStatus(&busy, &ecode, &sbs, &lcs, &ps);
-    SYS_PRINT( "    %s  ECODE: %s\r\n    SBS: %s  LCS: %s  PS: %s\r\n",
-        busy?"BUSY":"NOT busy", 
-        ecodeStr[ecode], sbsStr[sbs], lcsStr[sbs], psStr[ps]);
+    HSM_TRACE(HSM_TRACE_MB_STATUS, HSM_TRACE_TAG_TC, 
+              mbrxstatus, mbtxstatus, hsmStatus);
 
     if (ps != 2)
     {
+        HSM_TRACE(HSM_TRACE_CMD_ERR, HSMNONOPERR, hsmStatus, 0, 0);
         cmdRCStr = CmdResultCodeStr(HSMNONOPERR);
         return HSMNONOPERR; 
     }
-    SYS_PRINT("HSM Operational\r\n");
 
-    //Wait to Complete Tx
-    while(responseDelay)   // the busy polling isn't working so replace with this delay
+    //Wait to Complete Tx (command type/payload deadline)
+    HsmDeadlineStart(&deadline, HsmTimeoutCycles(globalCmdHeader,
+        HsmTimeoutSGBytes((CmdSGDescriptor *) globalCmdInput) +
+        HsmTimeoutSGBytes((CmdSGDescriptor *) globalCmdOutput)));
+    while (HSM_REGS->HSM_STATUS & HSM_STATUS_BUSY_Msk)
     {
-        if (!(HSM_REGS->HSM_STATUS & HSM_STATUS_BUSY_Msk))
+        if (HsmDeadlineExpired(&deadline))
         {
-            SYS_MESSAGE("HSM Send Complete(not busy)\r\n");
-            break;
+            hsmMbStaleRsp = true;
+            HSM_TRACE(HSM_TRACE_CMD_ERR, HSMBUSYTIMEOUTERR, 
+                      HSM_REGS->HSM_STATUS, 0, 0);
+            cmdRCStr = CmdResultCodeStr(HSMBUSYTIMEOUTERR);
+            return HSMBUSYTIMEOUTERR;
         }
-        responseDelay--;
     }
 
     hsmStatus = HSM_REGS->HSM_STATUS; 
-    SYS_PRINT("TF CMD HSM Status: 0x%08lx\r\n",hsmStatus);
     GetHsmStatus(&busy, &ecode, &sbs, &lcs, &ps);
-    SYS_PRINT( "    %s  ECODE: %s\r\n    SBS: %s  LCS: %s  PS: %s\r\n",
-        busy?"BUSY":"NOT busy", 
-        ecodeStr[ecode], sbsStr[sbs], lcsStr[sbs], psStr[ps]);
     
     // Poll RXINT in non-interrupt mode (in interrupt mode this 'while' acts as an 'if')
     //while((mbrxstatus & MBRXSTATUS_RXINT_MASK) != MBRXSTATUS_RXINT_MASK) 
@@ -212,20 +223,19 @@ int SendHsmCommandRequest()
     //} 
 
     mbrxstatus = HSM_REGS->HSM_MBRXSTATUS;
-    SYS_PRINT("TF MBRXSTATUS = 0x%08lx\r\n",mbrxstatus);
-    mbrxstatus = HSM_REGS->HSM_MBRXSTATUS;
-    SYS_PRINT("TF MBTXSTATUS = 0x%08lx\r\n",mbtxstatus);
+    HSM_TRACE(HSM_TRACE_MB_STATUS, HSM_TRACE_TAG_TF, 
+              mbrxstatus, mbtxstatus, hsmStatus);
     
     //Read the Response
     mailBoxHeaderRx = HSM_REGS->HSM_MBRXHEAD;
-    SYS_PRINT("  Rx  MB: 0x%08lx\r\n", mailBoxHeaderRx);
-
     cmdHeaderResponseRx = HSM_REGS->HSM_MBFIFO[0];
-    SYS_PRINT("  Rx CMD: 0x%08lx\r\n", cmdHeaderResponseRx);
-
     cmdResultRx = HSM_REGS->HSM_MBFIFO[0];
     cmdRCStr = CmdResultCodeStr(cmdResultRx);
-    SYS_PRINT("  Rx  RC: 0x%08lx %s\r\n", cmdResultRx, cmdRCStr);
+    HSM_TRACE(HSM_TRACE_RX_RSP, mailBoxHeaderRx, cmdHeaderResponseRx, 
+              cmdResultRx, 0);
+
+    //Invalidate the Data CACHE (OUT data written by the HSM)
+    HsmDmaSGInvalidate((CmdSGDescriptor *) globalCmdOutput);
 
 #if 0
     //Get VSS Info (after the result code)
@@ -240,13 +250,10 @@ int SendHsmCommandRequest()
     //RESULTS
     if (cmdHeaderResponseRx == CMD_HEADER_HASH_BLOCK_SHA256)
     {
-        SYS_PRINT("HASH COMMAND 0x%08lx Result:\r\n", cmdHeaderResponseRx);
         for (ctr=0; ctr<HASH_SHA256_RESULT_BYTES/4; ctr+=4)
         {
-            SYS_PRINT("    %08lx ",    dmaDataOut[ctr]);
-            SYS_PRINT    ("%08lx ",    dmaDataOut[ctr+1]);
-            SYS_PRINT("    %08lx ",    dmaDataOut[ctr+2]);
-            SYS_PRINT("    %08lx\r\n", dmaDataOut[ctr+3]);
+            HSM_TRACE(HSM_TRACE_RSP_DATA, dmaDataOut[ctr], dmaDataOut[ctr+1],
+                      dmaDataOut[ctr+2], dmaDataOut[ctr+3]);
         }
         //TODO:  Send string to python for result validation
     }
@@ -367,17 +374,16 @@ char * CmdResultCodeStr(uint32_t cmdResultCode)
         }
         else return cmdSpecialResultStr[NUMCMDERRORRESULTCODES]; //Invalid
     }
-#if 0
     else if ((cmdResultCode & HSMCMDERRMASK) > 0)
     {
+        //0x0000 0FXX
         strIndex = cmdResultCode & HSMCMDERRNUMMASK;
         if (strIndex < NUMHSMERRCODES)
         {
             return cmdHsmErrorStr[strIndex];
         }
-        else return cmdHsmErrStr[NUMHSMERRCODES];
+        else return cmdHsmErrorStr[NUMHSMERRCODES];
     }
-#endif //0
     else return cmdSpecialResultStr[NUMCMDERRORRESULTCODES]; //Invalid
 } //End CmdResultCodes()
 
@@ -401,26 +407,205 @@ void GetHsmStatus(bool *busy,
 
 
 //******************************************************************************
-// HSM ROM Test Driver Function
-// --Send the HSM Command Request to HSM Mailbox (SendHsmCommandRequest())
+// Command response of a command that was not completed by the HSM 
+// --resultCode:  HSMBUSYERR (not sent) or HSMBUSYTIMEOUTERR (timed out)
 //******************************************************************************
-void HsmMbCmdDriver(HsmCmdReq * cmdReq, bool int_mode) 
+static void HsmCmdRspError(HsmCmdReq *  cmdReq, 
+                           HsmCmdResp * cmdRsp,
+                           uint32_t     resultCode) 
 {
-    uint8_t                 i;
-    uint16_t                cmd_size;
+    cmdRsp->mbHeader.v     = 0;
+    cmdRsp->cmdHeader      = cmdReq->cmdHeader;
+    cmdRsp->resultCode     = (CmdResultCodes) resultCode;
+    cmdRsp->numResultWords = 0;
 
-    // Enable HSM Mailbox RX interrupt in int_mode
-    if (int_mode) 
+    HSM_TRACE(HSM_TRACE_CMD_ERR, resultCode, HSM_REGS->HSM_STATUS, 
+              cmdReq->cmdHeader, 0);
+} //End HsmCmdRspError()
+
+
+//******************************************************************************
+// Discard the response of a timed out command
+// --Called before the next command is written to the MB (HSM not BUSY), so 
+//   the late response is not read as the response of the next command.
+// --No RXINT by then means the HSM did not respond.
+//******************************************************************************
+static void HsmMbRspFlush(void) 
+{
+    uint32_t cmdSizeWds;
+    uint32_t i;
+
+    if (!hsmMbStaleRsp) return;
+    hsmMbStaleRsp = false;
+
+    if ((HSM_REGS->HSM_MBRXSTATUS & MBRXSTATUS_RXINT_MASK) == 
+        MBRXSTATUS_RXINT_MASK)
     {
-        HSM_REGS->HSM_MBCONFIG = HSM_MBCONFIG_RXINT(1);
-    } 
-    else 
+        cmdSizeWds = (HSM_REGS->HSM_MBRXHEAD & MBRXHEADER_LEN_MASK) / 4;
+        for (i = 1; i < cmdSizeWds; i++)
+        {
+            dummy32 = HSM_REGS->HSM_MBFIFO[0];
+        }
+    }
+} //End HsmMbRspFlush()
+
+
+//******************************************************************************
+// HSM MB response received (RXINT) 
+//******************************************************************************
+static bool HsmMbRxInt(void)
+{
+    return ((HSM_REGS->HSM_MBRXSTATUS & MBRXSTATUS_RXINT_MASK) == 
+            MBRXSTATUS_RXINT_MASK);
+} //End HsmMbRxInt()
+
+
+//******************************************************************************
+// Sleep while waiting for the command (see HsmMbSetWaitMode())
+// --HSM_MB_WAIT_AUTO:  Sleep for the commands with a measured mean latency of
+//                      at least HSM_MB_SLEEP_MIN_CYCLES.  A command not yet 
+//                      measured spins, since the latency of a command that 
+//                      slept is not measured (see HsmStatsCancel()).
+//******************************************************************************
+static bool HsmMbSleepCmd(HsmCmdReq * cmdReq)
+{
+    uint32_t expCycles;
+
+    if (hsmMbWaitMode == HSM_MB_WAIT_SPIN)  return false;
+    if (hsmMbWaitMode == HSM_MB_WAIT_SLEEP) return true;
+
+    expCycles = HsmStatsExpectedCycles(cmdReq->cmdHeader);
+    return (expCycles != 0 && expCycles >= HSM_MB_SLEEP_MIN_CYCLES);
+} //End HsmMbSleepCmd()
+
+
+//******************************************************************************
+// HSM MB sleep wake-up timer (RTC MODE0 32-bit counter, HSM_MB_SLEEP_RTC_HZ)
+// --The RTC keeps counting while the core sleeps (CYCCNT does not).  Its 
+//   interrupt is left disabled in the NVIC:  the pending CMP0 only wakes
+//   the core (SEVONPEND).
+//******************************************************************************
+static void HsmMbSleepTimerInit(void)
+{
+    static bool timerInit = false;
+
+    if (timerInit) return;
+
+    MCLK_REGS->MCLK_CLKMSK[RTC_MCLK_ID_APB / 32] |= 
+        (1u << (RTC_MCLK_ID_APB % 32));
+
+    if (!(RTC_REGS->MODE0.RTC_CTRLA & RTC_MODE0_CTRLA_ENABLE_Msk))
     {
-        HSM_REGS->HSM_MBCONFIG = HSM_MBCONFIG_RXINT(0);
+        RTC_REGS->MODE0.RTC_CTRLA = RTC_MODE0_CTRLA_MODE_COUNT32 | 
+                                    RTC_MODE0_CTRLA_PRESCALER_DIV1 |
+                                    RTC_MODE0_CTRLA_COUNTSYNC_Msk;
+        RTC_REGS->MODE0.RTC_CTRLA |= RTC_MODE0_CTRLA_ENABLE_Msk;
+        while (RTC_REGS->MODE0.RTC_SYNCBUSY & RTC_MODE0_SYNCBUSY_ENABLE_Msk);
+    }
+    RTC_REGS->MODE0.RTC_INTENCLR = RTC_MODE0_INTENCLR_CMP0_Msk;
+    NVIC_DisableIRQ(RTC_IRQn);
+
+    timerInit = true;
+} //End HsmMbSleepTimerInit()
+
+
+//******************************************************************************
+// RTC count (wake-up timer ticks)
+//******************************************************************************
+static uint32_t HsmMbSleepTimerCount(void)
+{
+    while (RTC_REGS->MODE0.RTC_SYNCBUSY & RTC_MODE0_SYNCBUSY_COUNT_Msk);
+    return RTC_REGS->MODE0.RTC_COUNT;
+} //End HsmMbSleepTimerCount()
+
+
+//******************************************************************************
+// Sleep (WFE) until the HSM MB RXINT, the HSM ERROR interrupt is pending or
+// the deadline
+// --Called with the interrupts disabled (PRIMASK) and the MB RXINT enabled.
+//   SEVONPEND makes a pending interrupt wake the core even when it is masked
+//   or disabled in the NVIC (HSM ERROR, e.g. HSM safe mode), so there is no
+//   check-then-sleep race.
+// --The core clock (and CYCCNT) stops while sleeping, so the RTC CMP0 is 
+//   armed for the cycles left to the deadline and the RTC ticks slept are 
+//   added to the deadline (HsmDeadlineSlept()).  The command latency is not
+//   measured (HSM_STATS_CANCEL()).
+// --Returns on any wake-up event, so the caller re-checks the response and 
+//   the command deadline.
+//******************************************************************************
+static void HsmMbSleep(HsmDeadline * deadline)
+{
+    const uint32_t cyclesPerTick = HSM_TIMEOUT_CPU_HZ / HSM_MB_SLEEP_RTC_HZ;
+    uint32_t       remaining;
+    uint32_t       startCount;
+    uint32_t       startCycles;
+    uint32_t       sleptTicks;
+    uint32_t       awakeCycles;
+
+    remaining = HsmDeadlineRemaining(deadline);
+    if (remaining == 0) return;
+
+    HsmMbSleepTimerInit();
+
+    SCB->SCR |= SCB_SCR_SEVONPEND_Msk;
+    HSM_REGS->HSM_INTENSET = HSM_INTENSET_ERROR_Msk;
+
+    //Wake-up at the deadline (+1 tick for the count read lag)
+    startCount  = HsmMbSleepTimerCount();
+    startCycles = DWT->CYCCNT;
+    RTC_REGS->MODE0.RTC_INTFLAG = RTC_MODE0_INTFLAG_CMP0_Msk;
+    RTC_REGS->MODE0.RTC_COMP[0] = startCount + 
+                                  (remaining + cyclesPerTick - 1) / 
+                                  cyclesPerTick + 1;
+    while (RTC_REGS->MODE0.RTC_SYNCBUSY & RTC_MODE0_SYNCBUSY_COMP0_Msk);
+    RTC_REGS->MODE0.RTC_INTENSET = RTC_MODE0_INTENSET_CMP0_Msk;
+
+    if (!HsmMbRxInt() && !(HSM_REGS->HSM_INTFLAG & HSM_INTFLAG_ERROR_Msk))
+    {
+        HSM_STATS_CANCEL();
+        __DSB();
+        __WFE();
+    }
+
+    //Time slept: the RTC ticks less the cycles CYCCNT counted meanwhile
+    sleptTicks  = HsmMbSleepTimerCount() - startCount;
+    awakeCycles = DWT->CYCCNT - startCycles;
+    if (RTC_REGS->MODE0.RTC_INTFLAG & RTC_MODE0_INTFLAG_CMP0_Msk)
+    {
+        HsmDeadlineSlept(deadline, remaining);
+    }
+    else if (sleptTicks * cyclesPerTick > awakeCycles)
+    {
+        HsmDeadlineSlept(deadline, sleptTicks * cyclesPerTick - awakeCycles);
     }
 
+    RTC_REGS->MODE0.RTC_INTENCLR = RTC_MODE0_INTENCLR_CMP0_Msk;
+    RTC_REGS->MODE0.RTC_INTFLAG  = RTC_MODE0_INTFLAG_CMP0_Msk;
+    NVIC_ClearPendingIRQ(RTC_IRQn);
+
+    HSM_REGS->HSM_INTENCLR = HSM_INTENCLR_ERROR_Msk;
+    SCB->SCR &= ~SCB_SCR_SEVONPEND_Msk;
+    NVIC_ClearPendingIRQ(HSM_ERROR_IRQn);
+} //End HsmMbSleep()
+
+
+//******************************************************************************
+// Write the HSM Command Request words to the HSM MB
+// --MB Header, CMD Header and the rest of the command inputs (IN/OUT/Params)
+//******************************************************************************
+static void HsmMbCmdWrite(HsmCmdReq * cmdReq) 
+{
+    uint8_t                 i;
+    uint16_t                cmd_size;
+
     // Extract the command length
-        cmd_size = (uint16_t) ((cmdReq->mbHeader & MBRXHEADER_LEN_MASK) / 4);
+    cmd_size = (uint16_t) ((cmdReq->mbHeader & MBRXHEADER_LEN_MASK) / 4);
+
+    // IN/OUT buffers to the HSM (data cache)
+    HsmDmaCmdPrepare(cmdReq);
+
+    // Command latency start
+    HSM_STATS_START(cmdReq->cmdHeader);
 
     // Write the Mailbox Header
     HSM_REGS->HSM_MBTXHEAD  = (uint32_t) cmdReq->mbHeader;
@@ -430,101 +615,345 @@ void HsmMbCmdDriver(HsmCmdReq * cmdReq, bool int_mode)
     HSM_REGS->HSM_MBFIFO[0] = (uint32_t) cmdReq->cmdHeader;
     //SYS_PRINT("CMD RQ: 0x%08x\r\n",cmdReq->cmdHeader);
 
+    HSM_TRACE(HSM_TRACE_TX_CMD, cmdReq->mbHeader, cmdReq->cmdHeader,
+              cmdReq->cmdInputs[0], cmdReq->cmdInputs[1]);
+
     // Write the rest of the command inputs
     for (i = 0; i < cmd_size - 2; i++) 
     {
-        CmdSGDescriptor *dataDesc;
-
         HSM_REGS->HSM_MBFIFO[0] = (uint32_t) cmdReq->cmdInputs[i];
-        if (i<2) //IN and OUT
+        //if (i==0)      SYS_PRINT("CMD IN: 0x%08lx\r\n",cmdReq->cmdInputs[i]);
+        //else if (i==1) SYS_PRINT("CMD OUT: 0x%08lx\r\n",cmdReq->cmdInputs[i]);
+        //else SYS_PRINT("CMD  P%d: 0x%08lx\r\n",i-2, cmdReq->cmdInputs[i]);
+    } //End cmdInput Loop
+
+} //End HsmMbCmdWrite()
+
+
+//******************************************************************************
+// HSM ROM Test Driver Function
+// --Send the HSM Command Request to HSM Mailbox 
+// --int_mode == false:  Poll for the response into gHsmCmdResp
+// --int_mode == true:   Return after the request is sent. HSM_RXINT_Handler()
+//                       reads the response into gHsmCmdResp 
+//                       (see HsmMbCmdSubmit())
+//******************************************************************************
+void HsmMbCmdDriver(HsmCmdReq * cmdReq, bool int_mode) 
+{
+    if (int_mode) 
+    {
+        HsmMbCmdSubmit(cmdReq, &gHsmCmdResp, NULL, NULL);
+        return;
+    } 
+
+    HsmMbCmdExec(cmdReq, &gHsmCmdResp);
+
+} //End hsmMbDriver()
+
+
+//******************************************************************************
+// Send the HSM Command Request to the HSM Mailbox (Polled Mode)
+// --Poll for the response into cmdRsp
+// --cmdRsp->resultCode is HSMBUSYTIMEOUTERR when there is no response by the 
+//   command deadline (see HsmTimeoutCmdCycles()).
+//******************************************************************************
+void HsmMbCmdExec(HsmCmdReq * cmdReq, HsmCmdResp * cmdRsp) 
+{
+    uint32_t    mbrxstatus;
+    uint32_t    primask;
+    HsmDeadline deadline;
+
+    // Disable HSM Mailbox RX interrupt in polled mode
+    HSM_REGS->HSM_MBCONFIG = HSM_MBCONFIG_RXINT(0);
+    HsmMbRspFlush();
+    hsmPollPending = true;
+
+    HsmMbCmdWrite(cmdReq);
+    HsmDeadlineStart(&deadline, HsmTimeoutCmdCycles(cmdReq));
+
+    //Sleep until RXINT (the RXINT interrupt only wakes the core, the 
+    //response is read below)
+    if (HsmMbSleepCmd(cmdReq))
+    {
+        primask = __get_PRIMASK();
+        __disable_irq();
+        HSM_REGS->HSM_MBCONFIG = HSM_MBCONFIG_RXINT(1);
+        while (!HsmMbRxInt() && 
+               !(HSM_REGS->HSM_INTFLAG & HSM_INTFLAG_ERROR_Msk) &&
+               !HsmDeadlineExpired(&deadline))
         {
-            //if (i==0) SYS_PRINT("CMD IN: 0x%08lx\r\n",cmdReq->cmdInputs[i]);
-            //else      SYS_PRINT("CMD OUT: 0x%08lx\r\n",cmdReq->cmdInputs[i]);
+            HsmMbSleep(&deadline);
+        }
+        HSM_REGS->HSM_MBCONFIG = HSM_MBCONFIG_RXINT(0);
+        NVIC_ClearPendingIRQ(HSM_RXINT_IRQn);
+        __set_PRIMASK(primask);
+    }
 
-            dataDesc = (CmdSGDescriptor *)cmdReq->cmdInputs[i];
-            if (dataDesc != 0x00000000)
-            {
-                if (dataDesc->flagsLength.s.length < 65 && i!=1)
-                {
-                    //PrintSG(*dataDesc, true);
-                }
-                else
-                {
-                    //PrintSG(*dataDesc, false);
-                }
-            }
+    //Poll RXINT
+    mbrxstatus = HSM_REGS->HSM_MBRXSTATUS;
+    while ((mbrxstatus & MBRXSTATUS_RXINT_MASK) != MBRXSTATUS_RXINT_MASK) 
+    { 
+        if (HsmDeadlineExpired(&deadline))
+        {
+            HsmCmdRspError(cmdReq, cmdRsp, HSMBUSYTIMEOUTERR);
+            hsmMbStaleRsp  = true;
+            hsmPollPending = false;
+            return;
         }
-        else
+        mbrxstatus = HSM_REGS->HSM_MBRXSTATUS; 
+    }
+
+    // Process the command response 
+    HsmCmdRspRead(cmdRsp);
+    HsmDmaCmdComplete(cmdReq);
+    hsmPollPending = false;
+
+} //End HsmMbCmdExec()
+
+
+//******************************************************************************
+// Send the HSM Command Request to the HSM Mailbox (Interrupt Mode)
+// --Returns after the request words are written to the MB FIFO.
+// --HSM_RXINT_Handler() reads the response into cmdRsp and then calls 
+//   callback(cmdRsp, context) (callback can be NULL).
+// --Only one command can be in the HSM at a time, so the caller must wait for
+//   the HSM to be not BUSY and for HsmMbCmdPending() == false.
+// --No response by the command deadline completes the command with 
+//   HSMBUSYTIMEOUTERR (see HsmMbCmdTimeoutCheck()).
+//******************************************************************************
+void HsmMbCmdSubmit(HsmCmdReq *    cmdReq, 
+                    HsmCmdResp *   cmdRsp,
+                    HsmCmdCallback callback, 
+                    void *         context) 
+{
+    HsmMbRspFlush();
+
+    hsmIntReq      = cmdReq;
+    hsmIntRsp      = cmdRsp;
+    hsmIntCallback = callback;
+    hsmIntContext  = context;
+    hsmIntPending  = true;
+    hsmIntSleep    = HsmMbSleepCmd(cmdReq);
+    gRspData.hsmRxInt = false;
+
+    // Enable HSM Mailbox RX interrupt in int_mode
+    HSM_REGS->HSM_MBCONFIG = HSM_MBCONFIG_RXINT(1);
+
+    HsmDeadlineStart(&hsmIntDeadline, HsmTimeoutCmdCycles(cmdReq));
+    HsmMbCmdWrite(cmdReq);
+
+} //End HsmMbCmdSubmit()
+
+
+//******************************************************************************
+// Interrupt mode command deadline
+// --Complete the outstanding command with HSMBUSYTIMEOUTERR when its deadline
+//   expired:  the callback is called as from HSM_RXINT_Handler().
+// --Called from the wait functions and the command queue dispatcher.
+// --Returns true if the command timed out
+//******************************************************************************
+bool HsmMbCmdTimeoutCheck(void)
+{
+    HsmCmdResp *   cmdRsp   = NULL;
+    HsmCmdCallback callback = NULL;
+    void *         context  = NULL;
+    bool           timedOut = false;
+    uint32_t       primask;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    if (hsmIntPending && HsmDeadlineExpired(&hsmIntDeadline))
+    {
+        //Late response is discarded by HsmMbRspFlush()
+        HSM_REGS->HSM_MBCONFIG = HSM_MBCONFIG_RXINT(0);
+        hsmMbStaleRsp = true;
+
+        cmdRsp   = hsmIntRsp;
+        callback = hsmIntCallback;
+        context  = hsmIntContext;
+        HsmCmdRspError(hsmIntReq, cmdRsp, HSMBUSYTIMEOUTERR);
+
+        hsmIntPending = false;
+        timedOut      = true;
+    }
+    __set_PRIMASK(primask);
+
+    if (timedOut && callback != NULL)
+    {
+        callback(cmdRsp, context);
+    }
+
+    return timedOut;
+} //End HsmMbCmdTimeoutCheck()
+
+
+//******************************************************************************
+// Interrupt mode command response status 
+// --true until HSM_RXINT_Handler() has read the response
+//******************************************************************************
+bool HsmMbCmdPending(void)
+{
+    return hsmIntPending;
+} //End HsmMbCmdPending()
+
+
+//******************************************************************************
+// Wait for the interrupt mode command response (or its deadline)
+// --Sleeps between the checks (see HsmMbSetWaitMode()):  HSM_RXINT_Handler()
+//   runs when PRIMASK is restored after the wake-up.
+//******************************************************************************
+void HsmMbCmdWait(void)
+{
+    uint32_t primask;
+
+    while (hsmIntPending)
+    {
+        if (HsmMbCmdTimeoutCheck()) break;
+
+        if (hsmIntSleep)
         {
-            //SYS_PRINT("CMD  P%d: 0x%08lx\r\n",i-2, cmdReq->cmdInputs[i]);
+            primask = __get_PRIMASK();
+            __disable_irq();
+            if (hsmIntPending) HsmMbSleep(&hsmIntDeadline);
+            __set_PRIMASK(primask);
         }
-    } //End cmdInput print Loop
-    
-    // Check if interrupt mode is enabled 
-    //if (int_mode) 
-    //{ //    // Create a null structure to return in interrupt mode
-    //    gHsmCmdResp.mbHeader.v      = 0;
-    //    gHsmCmdResp.cmdHeader     = 0;
-    //    gHsmCmdResp.resultCode    = 0;
-    //    gHsmCmdResp.resultData[0] = 0;
-    //} 
-    //else 
-    //{
-        // Process the command response 
-        HsmCmdRsp();
-    //}
+    }
+} //End HsmMbCmdWait()
+
+
+//******************************************************************************
+// Set how the host core waits for the HSM MB command responses
+// --HSM_MB_WAIT_SPIN:   Poll at full clock (lowest latency)
+// --HSM_MB_WAIT_SLEEP:  Sleep (WFE, PM_SLEEPCFG sleep mode) until the RXINT
+//                       or the deadline (RTC wake-up).  The latency of the
+//                       commands that slept is not measured.
+// --HSM_MB_WAIT_AUTO:   Sleep for the commands with a measured mean latency
+//                       of at least HSM_MB_SLEEP_MIN_CYCLES (default)
+//******************************************************************************
+void HsmMbSetWaitMode(HsmMbWaitMode mode)
+{
+    hsmMbWaitMode = mode;
+} //End HsmMbSetWaitMode()
+
+
+//******************************************************************************
+// Current HSM MB command response wait mode
+//******************************************************************************
+HsmMbWaitMode HsmMbGetWaitMode(void)
+{
+    return hsmMbWaitMode;
+} //End HsmMbGetWaitMode()
+
+
+//******************************************************************************
+// HSM Mailbox Idle
+// --No polled or interrupt mode command outstanding and the HSM is not BUSY,
+//   i.e. the next command request can be written to the MB.
+//******************************************************************************
+bool HsmMbIdle(void)
+{
+    return (!hsmIntPending && !hsmPollPending && 
+            !(HSM_REGS->HSM_STATUS & HSM_STATUS_BUSY_Msk));
+} //End HsmMbIdle()
 
-} //End hsmMbDriver()
+
+//******************************************************************************
+// Wait for the HSM Mailbox to be idle before sending the next command
+// --Replaces the HSM BUSY poll so a polled command does not overwrite the
+//   command of an interrupt mode (queued) command in the HSM.
+// --An outstanding interrupt mode command is bounded by its own deadline, 
+//   then the HSM BUSY by HSM_TIMEOUT_IDLE_CYCLES.
+// --Returns false if the HSM is still BUSY (HSMBUSYERR)
+//******************************************************************************
+bool HsmMbWaitIdle(void)
+{
+    HsmDeadline deadline;
+
+    HsmDeadlineStart(&deadline, HSM_TIMEOUT_IDLE_CYCLES);
+    while (!HsmMbIdle())
+    {
+        if (hsmIntPending)
+        {
+            HsmMbCmdWait();
+            HsmDeadlineStart(&deadline, HSM_TIMEOUT_IDLE_CYCLES);
+        }
+        else if (HsmDeadlineExpired(&deadline))
+        {
+            HSM_TRACE(HSM_TRACE_CMD_ERR, HSMBUSYERR, HSM_REGS->HSM_STATUS, 
+                      0, 0);
+            return false;
+        }
+    }
+
+    return true;
+} //End HsmMbWaitIdle()
 
 
 //******************************************************************************
 // Function to process the command response in gHsmCmdResp
-// --read back the response from the HSM MB FIFO 
-// --The numResultWords is the remaining words receive after the 1st 3,
-//   i.e. the number of cmd specific resultWords received. 
+// --Poll RXINT and read back the response from the HSM MB FIFO 
 //******************************************************************************
 void HsmCmdRsp() 
 {
 
     uint32_t                mbrxstatus;
-    uint16_t                cmdSizeWds;
-    uint8_t                 i;
 
     // Check for response recieved by reading RXINT
     //printc("HSM ROM Test Driver: Waiting for the command response (RXINT)...\n");
     mbrxstatus = HSM_REGS->HSM_MBRXSTATUS;
 
     //Poll RXINT in non-interrupt mode 
-    //  (in interrupt mode this 'while' acts as an 'if')
     while ((mbrxstatus & MBRXSTATUS_RXINT_MASK) != MBRXSTATUS_RXINT_MASK) 
         { mbrxstatus = HSM_REGS->HSM_MBRXSTATUS; }
     
+    HsmCmdRspRead(&gHsmCmdResp);
+    HsmDmaCmdComplete(&gHsmCmdReq);
+
+} //End HsmCmdRsp() 
+
+
+//******************************************************************************
+// Read the command response from the HSM MB FIFO into cmdRsp
+// --The numResultWords is the remaining words receive after the 1st 3,
+//   i.e. the number of cmd specific resultWords received. 
+// --Called from HsmCmdRsp() (polled) and HSM_RXINT_Handler() (int_mode)
+//******************************************************************************
+void HsmCmdRspRead(HsmCmdResp * cmdRsp) 
+{
+    uint16_t                cmdSizeWds;
+    uint8_t                 i;
+
+    // Command latency stop (response received)
+    HSM_STATS_STOP();
+
     // Check Mailbox Header
-    gHsmCmdResp.mbHeader.v = HSM_REGS->HSM_MBRXHEAD;
+    cmdRsp->mbHeader.v = HSM_REGS->HSM_MBRXHEAD;
     
     // Extract the command length
-    cmdSizeWds = (uint16_t) ((gHsmCmdResp.mbHeader.v & MBRXHEADER_LEN_MASK) / 4);
-    //SYS_PRINT("RSP  MB: 0x%08lx (%d Words)\r\n",gHsmCmdResp.mbHeader.v, cmdSizeWds);
+    cmdSizeWds = (uint16_t) ((cmdRsp->mbHeader.v & MBRXHEADER_LEN_MASK) / 4);
+    //SYS_PRINT("RSP  MB: 0x%08lx (%d Words)\r\n",cmdRsp->mbHeader.v, cmdSizeWds);
     
     // Check Mailbox Command Header
-    gHsmCmdResp.cmdHeader = HSM_REGS->HSM_MBFIFO[0];
-    //SYS_PRINT("RSP CMD: 0x%08lx\r\n",(uint32_t) gHsmCmdResp.cmdHeader);
+    cmdRsp->cmdHeader = HSM_REGS->HSM_MBFIFO[0];
+    //SYS_PRINT("RSP CMD: 0x%08lx\r\n",(uint32_t) cmdRsp->cmdHeader);
     
     // Check Response Code
-    gHsmCmdResp.resultCode = HSM_REGS->HSM_MBFIFO[0];
-    cmdRCStr = CmdResultCodeStr(gHsmCmdResp.resultCode);
-    //SYS_PRINT("RSP  RC: 0x%08lx %s\r\n", (uint32_t) gHsmCmdResp.resultCode,
-    //    CmdResultCodeStr(gHsmCmdResp.resultCode));
+    cmdRsp->resultCode = HSM_REGS->HSM_MBFIFO[0];
+    //SYS_PRINT("RSP  RC: 0x%08lx %s\r\n", (uint32_t) cmdRsp->resultCode,
+    //    CmdResultCodeStr(cmdRsp->resultCode));
     
     // Read the Command Result Data       
     cmdSizeWds = min(cmdSizeWds,MAX_RSP_RESULT_WORDS);
-    gHsmCmdResp.numResultWords = cmdSizeWds - 3;
+    cmdRsp->numResultWords = cmdSizeWds - 3;
     for (i = 0; i < cmdSizeWds - 3; i++) 
     { 
-        gHsmCmdResp.resultData[i] = HSM_REGS->HSM_MBFIFO[0]; 
-        //SYS_PRINT("RSP  W%d: 0x%08lx\r\n", i, gHsmCmdResp.resultData[i]);
+        cmdRsp->resultData[i] = HSM_REGS->HSM_MBFIFO[0]; 
+        //SYS_PRINT("RSP  W%d: 0x%08lx\r\n", i, cmdRsp->resultData[i]);
     }
-} //End HsmCmdRsp() 
+
+    HSM_TRACE(HSM_TRACE_RX_RSP, cmdRsp->mbHeader.v, cmdRsp->cmdHeader,
+              cmdRsp->resultCode, cmdRsp->numResultWords);
+} //End HsmCmdRspRead() 
 
 
 //******************************************************************************
@@ -537,112 +966,109 @@ void HsmCmdRsp()
 //     5. Output Data (if valid)
 //     6. Interrupt Flag
 //
-// --Globals:  rspData, gHsmCmdReq, gHsmCmdResp
+// --cmdReq/cmdRsp:  The command request and its MB response
+// --rsp:            Response check results
+// --printExpData:   Print the failed checks (expected/actual).  Passed 
+//                   checks are only traced (HSM_TRACE_RSP_CHK).
 //
 // --Returns:
 //******************************************************************************
-void HsmCmdRspChkr(RSP_DATA * rsp, bool printExpData) 
+static void HsmCmdRspCheck(HsmCmdReq *  cmdReq,
+                           HsmCmdResp * cmdRsp,
+                           RSP_DATA *   rsp, 
+                           bool         printExpData) 
 {
     uint32_t          rdData = 0;
-    static char *     rcStr; 
+    uint32_t          hsmStatusReg;
+    uint32_t          failMask = 0;
 
-    rsp->resultCode = gHsmCmdResp.resultCode;
+    rsp->resultCode = cmdRsp->resultCode;
 
     // Check the Mailbox Header
-    if (gHsmCmdResp.mbHeader.v != gHsmCmdReq.expMbHeader) 
+    if (cmdRsp->mbHeader.v != cmdReq->expMbHeader) 
     {
+        failMask |= HSM_TRACE_CHK_MBHEADER;
+        rsp->testFailCnt++;
+        rsp->rspChksPassed = false;
+        if (printExpData)
+        {
             SYS_MESSAGE("HSM FAIL: Mailbox Header Match\r\n");
-            SYS_PRINT("MBExpected: 0x%08lx\r\n", (uint32_t)gHsmCmdReq.expMbHeader);
-            SYS_PRINT("MBActual:   0x%08lx\r\n", (uint32_t)gHsmCmdResp.mbHeader.v);
-            rsp->testFailCnt++;
-            rsp->rspChksPassed = false;
-    }
-    else
-    {
-        SYS_MESSAGE("HSM Pass: MB Header Match OK:\r\n");
+            SYS_PRINT("MBExpected: 0x%08lx\r\n", (uint32_t)cmdReq->expMbHeader);
+            SYS_PRINT("MBActual:   0x%08lx\r\n", (uint32_t)cmdRsp->mbHeader.v);
+        }
     }
   
     //Check the Command Header 
-    if (gHsmCmdResp.cmdHeader != gHsmCmdReq.cmdHeader) 
+    if (cmdRsp->cmdHeader != cmdReq->cmdHeader) 
     {
-        if (gHsmCmdResp.resultCode != E_INVFORMAT && 
-            gHsmCmdResp.resultCode != E_SAFEMODE)
+        if (cmdRsp->resultCode != E_INVFORMAT && 
+            cmdRsp->resultCode != E_SAFEMODE)
         {
-            SYS_MESSAGE("HSM FAIL: Command Header Match\r\n");
-            SYS_PRINT("CMDExpected: 0x%08lx\r\n", (uint32_t)gHsmCmdReq.cmdHeader);
-            SYS_PRINT("CMDActual:   0x%08lx\r\n", (uint32_t)gHsmCmdResp.cmdHeader);
+            failMask |= HSM_TRACE_CHK_CMDHEADER;
+            if (printExpData)
+            {
+                SYS_MESSAGE("HSM FAIL: Command Header Match\r\n");
+                SYS_PRINT("CMDExpected: 0x%08lx\r\n", (uint32_t)cmdReq->cmdHeader);
+                SYS_PRINT("CMDActual:   0x%08lx\r\n", (uint32_t)cmdRsp->cmdHeader);
+            }
         }
     }
-    {
-        SYS_MESSAGE("HSM Pass: CMD Header Match OK:\r\n");
-    }
   
     // Check the Result Code
-    rcStr = CmdResultCodeStr((gHsmCmdResp.resultCode));
-    if (gHsmCmdResp.resultCode != gHsmCmdReq.expResultCode) 
+    if (cmdRsp->resultCode != cmdReq->expResultCode) 
     {
-        SYS_PRINT("HSM FAIL: RC ""%s""\r\n",rcStr);
+        failMask |= HSM_TRACE_CHK_RC;
         rsp->testFailCnt++;
         rsp->rspChksPassed = false;
-    }
-    else
-    {
-        SYS_PRINT("HSM Pass: RC OK(""%s""):\r\n",rcStr);
+        if (printExpData)
+        {
+            SYS_PRINT("HSM FAIL: RC ""%s""\r\n",
+                      CmdResultCodeStr(cmdRsp->resultCode));
+        }
     }
   
     // Check the HSM STATUS register
-    rdData = HSM_REGS->HSM_STATUS;
-    GetHsmStatus(&busy,&ecode,&sbs,&lcs,&ps);
-    if (rdData != gHsmCmdReq.expStatus) 
+    hsmStatusReg = HSM_REGS->HSM_STATUS;
+    if (hsmStatusReg != cmdReq->expStatus) 
     {
         HsmStatusReg r; 
 
+        GetHsmStatus(&busy,&ecode,&sbs,&lcs,&ps);
         if (sbs != HSM_SBS_DISABLED &&
             sbs != HSM_SBS_UNDETERM)
         {
-
+            failMask |= HSM_TRACE_CHK_STATUS;
             rsp->testFailCnt++;
-            SYS_MESSAGE("HSM STATUS FAIL \r\n");
-            //SYS_PRINT("    Actual: busy=%d ecode=%d sbs=%d lcs=%d ps=%d\r\n",
-            //          busy,ecode,sbs,lcs,ps);
-            SYS_PRINT( "     Actual- %s ECODE:%s SBS:%s LCS:%s PS:%s\r\n",
-                busy?"BUSY":"NOT busy", 
-                ecodeStr[ecode], sbsStr[sbs], lcsStr[lcs], psStr[ps]);
-               
-            r.v = gHsmCmdReq.expStatus;
-            //SYS_PRINT("  Expected: busy=%d ecode=%d sbs=%d lcs=%d ps=%d\r\n",
-            //           r.s.busy,r.s.ecode,r.s.sbs,r.s.lcs,ps);
-            SYS_PRINT( "   Expected- %s ECODE:%s SBS:%s LCS:%s PS:%s\r\n",
-                r.s.busy?"BUSY":"NOT busy", 
-                ecodeStr[r.s.ecode], sbsStr[r.s.sbs], lcsStr[r.s.lcs], psStr[r.s.ps]);
-        }
-        else
-        {
-            //SYS_PRINT( "HSM STATUS - %s ECODE:%s SBS:%s LCS:%s PS:%s\r\n",
-            //    busy?"BUSY":"NOT busy", 
-            //    ecodeStr[ecode], sbsStr[sbs], lcsStr[lcs], psStr[ps]);
-            SYS_MESSAGE("HSM Pass: Reg. STATUS OK:\r\n");
+            if (printExpData)
+            {
+                SYS_MESSAGE("HSM STATUS FAIL \r\n");
+                SYS_PRINT( "     Actual- %s ECODE:%s SBS:%s LCS:%s PS:%s\r\n",
+                    busy?"BUSY":"NOT busy", 
+                    ecodeStr[ecode], sbsStr[sbs], lcsStr[lcs], psStr[ps]);
+                   
+                r.v = cmdReq->expStatus;
+                SYS_PRINT( "   Expected- %s ECODE:%s SBS:%s LCS:%s PS:%s\r\n",
+                    r.s.busy?"BUSY":"NOT busy", 
+                    ecodeStr[r.s.ecode], sbsStr[r.s.sbs], lcsStr[r.s.lcs], psStr[r.s.ps]);
+            }
         }
     }
-    else
-    {
-        //SYS_PRINT( "HSM STATUS - %s ECODE:%s SBS:%s LCS:%s PS:%s\r\n",
-        //    busy?"BUSY":"NOT busy", 
-        //    ecodeStr[ecode], sbsStr[sbs], lcsStr[lcs], psStr[ps]);
-        SYS_MESSAGE("HSM Pass: Reg. STATUS OK:\r\n");
-    }
 
     //Check the HSM INTFLAG register
     rdData = HSM_REGS->HSM_INTFLAG;
-    if (rdData != gHsmCmdReq.expIntFlag) 
+    if (rdData != cmdReq->expIntFlag) 
     {
-      if (gHsmCmdResp.resultCode != E_INVFORMAT && 
-          gHsmCmdResp.resultCode != E_SAFEMODE)
+      if (cmdRsp->resultCode != E_INVFORMAT && 
+          cmdRsp->resultCode != E_SAFEMODE)
       {
+          failMask |= HSM_TRACE_CHK_INTFLAG;
           rsp->testFailCnt++;
-          SYS_MESSAGE("HSM FAIL: INTFLAG read after command completion failed:\r\n");
-          SYS_PRINT("Expected: 0x%08lx\r\n", gHsmCmdReq.expIntFlag);
-          SYS_PRINT("Actual:   0x%08lx\r\n", rdData);
+          if (printExpData)
+          {
+              SYS_MESSAGE("HSM FAIL: INTFLAG read after command completion failed:\r\n");
+              SYS_PRINT("Expected: 0x%08lx\r\n", cmdReq->expIntFlag);
+              SYS_PRINT("Actual:   0x%08lx\r\n", rdData);
+          }
       }
     }
   
@@ -661,9 +1087,23 @@ void HsmCmdRspChkr(RSP_DATA * rsp, bool printExpData)
         rsp->rspChksPassed = false;
     }
 
+    HSM_TRACE(HSM_TRACE_RSP_CHK, cmdRsp->cmdHeader, cmdRsp->resultCode,
+              hsmStatusReg, failMask);
+
+} //End HsmCmdRspCheck() 
+
+
+//******************************************************************************
+// Check the expected HSM Command Response against the Command
+// --Globals:  rspData, gHsmCmdReq, gHsmCmdResp
+//******************************************************************************
+void HsmCmdRspChkr(RSP_DATA * rsp, bool printExpData) 
+{
+    HsmCmdRspCheck(&gHsmCmdReq, &gHsmCmdResp, rsp, printExpData);
 } //End HsmCmdRspChkr(void) 
 
 
+
 //******************************************************************************
 //PrintSG()
 //******************************************************************************
@@ -685,29 +1125,193 @@ void PrintSG(CmdSGDescriptor dmaSG, bool printData)
     }
 }
 
-#if USE_HSM_INT==TRUE
 //******************************************************************************
-// HSM Interrupt Handler
+// HSM Mailbox RX Interrupt Handler (HSM_RXINT_IRQn)
+// --Read the response of the command sent by HsmMbCmdSubmit() and call the 
+//   completion callback.  RXINT stays disabled until the next submit, so the
+//   callback can submit the next command.
 //******************************************************************************
-void INTREQ_217_Handler(void) 
+void HSM_RXINT_Handler(void) 
 {
+    HsmCmdResp *   cmdRsp;
+    HsmCmdCallback callback;
+    void *         context;
 
     //Disable interrupt while processing
     HSM_REGS->HSM_MBCONFIG = HSM_MBCONFIG_RXINT(0);
+
+    //No interrupt mode command outstanding
+    if (!hsmIntPending) return;
     
+    cmdRsp   = hsmIntRsp;
+    callback = hsmIntCallback;
+    context  = hsmIntContext;
+
     //Process the command response
-    //HsmCmdRsp();
-    
-    //Check the command response 
-    //HsmCmdRspChkr(rsp, true);
+    HsmCmdRspRead(cmdRsp);
+    HsmDmaCmdComplete(hsmIntReq);
     
     //Set the interrupt triggered flag so the test can check the output data
     gRspData.hsmRxInt = true;
-    
-    //Re-enable the interrupt
-    HSM_REGS->HSM_MBCONFIG = HSM_MBCONFIG_RXINT(1);
-}
-#endif //0
+    hsmIntPending     = false;
+
+    if (callback != NULL) 
+    {
+        callback(cmdRsp, context);
+    }
+} //End HSM_RXINT_Handler()
+
+
+//******************************************************************************
+//******************************************************************************
+// HSM Command Context
+//******************************************************************************
+//******************************************************************************
+
+//******************************************************************************
+// Initialize the command context for the next command request
+// --Clear the request and the response check results, and point the request 
+//   IN/OUT to the context dmaIn[0]/dmaOut[0] descriptors.
+//******************************************************************************
+void HsmCmdCtxInit(HsmCmdCtx * ctx)
+{
+    memset(&ctx->req, 0, sizeof(ctx->req));
+    memset(ctx->dmaIn, 0, sizeof(ctx->dmaIn));
+    memset(ctx->dmaOut, 0, sizeof(ctx->dmaOut));
+    ctx->req.cmdInputs[0] = (uint32_t) (&(ctx->dmaIn[0]));
+    ctx->req.cmdInputs[1] = (uint32_t) (&(ctx->dmaOut[0]));
+    ClearRspData(&ctx->rspData);
+} //End HsmCmdCtxInit()
+
+
+//******************************************************************************
+// Set a SG descriptor
+// --next == NULL:  Last descriptor of the chain (stop)
+//******************************************************************************
+void HsmCmdCtxSetSG(CmdSGDescriptor * sg, 
+                    void *            addr, 
+                    uint32_t          numBytes,
+                    CmdSGDescriptor * next)
+{
+    sg->data.addr              = addr;
+    sg->next.s.stop            = (next == NULL) ? 1 : 0;
+    sg->next.s.addr            = HSM_SG_NEXT_ADDR(next);
+    sg->flagsLength.s.length   = numBytes;
+    sg->flagsLength.s.cstAddr  = 0;
+    sg->flagsLength.s.discard  = 0;
+    sg->flagsLength.s.realign  = 1;
+    sg->flagsLength.s.intEn    = 0;
+} //End HsmCmdCtxSetSG()
+
+
+//******************************************************************************
+// Set a SG chain for a data buffer larger than one descriptor 
+// (HSM_SG_MAX_LENGTH) in up to maxDesc consecutive descriptors
+// --Returns the number of descriptors used, 0 if numBytes does not fit
+//******************************************************************************
+int HsmCmdCtxSetSGData(CmdSGDescriptor * sg, 
+                       int               maxDesc,
+                       void *            addr, 
+                       uint32_t          numBytes)
+{
+    uint8_t * data = (uint8_t *) addr;
+    uint32_t  length;
+    int       n = 0;
+
+    do
+    {
+        if (n == maxDesc) return 0;
+
+        length    = min(numBytes, HSM_SG_MAX_LENGTH);
+        numBytes -= length;
+        HsmCmdCtxSetSG(&sg[n], data, length, 
+                       (numBytes > 0) ? &sg[n + 1] : NULL);
+        data     += length;
+        n++;
+    } while (numBytes > 0);
+
+    return n;
+} //End HsmCmdCtxSetSGData()
+
+
+//******************************************************************************
+// Send the context command request to the HSM MB and poll for the response 
+// into the context rsp.
+// --rsp.resultCode is HSMBUSYERR (not sent) or HSMBUSYTIMEOUTERR when the
+//   command did not complete.
+//******************************************************************************
+void HsmCmdCtxExec(HsmCmdCtx * ctx)
+{
+    // Make sure the HSM is not busy
+    if (!HsmMbWaitIdle())
+    {
+        HsmCmdRspError(&ctx->req, &ctx->rsp, HSMBUSYERR);
+        return;
+    }
+
+    HsmMbCmdExec(&ctx->req, &ctx->rsp);
+} //End HsmCmdCtxExec()
+
+
+//******************************************************************************
+// Send the context command request to the HSM MB (Interrupt Mode)
+// --The response is read into the context rsp, then callback(rsp, context) 
+//   is called from HSM_RXINT_Handler().  
+// --The context must not be changed until the command completes 
+//   (see HsmMbCmdPending()). 
+// --Returns false if the HSM stayed BUSY: the command is not sent 
+//   (rsp.resultCode HSMBUSYERR) and the callback is not called.
+//******************************************************************************
+bool HsmCmdCtxSubmit(HsmCmdCtx *    ctx,
+                     HsmCmdCallback callback, 
+                     void *         context)
+{
+    // Make sure the HSM is not busy
+    if (!HsmMbWaitIdle())
+    {
+        HsmCmdRspError(&ctx->req, &ctx->rsp, HSMBUSYERR);
+        return false;
+    }
+
+    HsmMbCmdSubmit(&ctx->req, &ctx->rsp, callback, context);
+    return true;
+} //End HsmCmdCtxSubmit()
+
+
+//******************************************************************************
+// Complete the context command with an error result code (not sent)
+// --e.g. HSMBUSYERR when the HSM stayed BUSY
+//******************************************************************************
+void HsmCmdCtxError(HsmCmdCtx * ctx, uint32_t resultCode)
+{
+    HsmCmdRspError(&ctx->req, &ctx->rsp, resultCode);
+} //End HsmCmdCtxError()
+
+
+//******************************************************************************
+// Check the context response against the context command request 
+// --Results in ctx->rspData
+//******************************************************************************
+void HsmCmdCtxRspChkr(HsmCmdCtx * ctx, bool printExpData) 
+{
+    HsmCmdRspCheck(&ctx->req, &ctx->rsp, &ctx->rspData, printExpData);
+} //End HsmCmdCtxRspChkr()
+
+
+//******************************************************************************
+// Copy the context request/response/check results to the legacy globals
+// --gHsmCmdReq, gHsmCmdResp and gRspData are what the non-context API
+//   callers (tests, kit protocol) look at after a command.
+// --Returns &gRspData
+//******************************************************************************
+RSP_DATA * HsmCmdCtxPublish(HsmCmdCtx * ctx)
+{
+    gHsmCmdReq  = ctx->req;
+    gHsmCmdResp = ctx->rsp;
+    gRspData    = ctx->rspData;
+
+    return &gRspData;
+} //End HsmCmdCtxPublish()
 
 
 #if 0
@@ -882,9 +1486,14 @@ void hsm_rom_test_get_challenge(bool int_mode)
 //******************************************************************************
 void ClearRsp()
 {
-    static RSP_DATA *      rsp    = &gRspData;
+    ClearRspData(&gRspData);
+}
 
-    // Reset the response checker global variable
+//******************************************************************************
+// Reset the response check results 
+//******************************************************************************
+void ClearRspData(RSP_DATA * rsp)
+{
     rsp->invArgs       = false;
     rsp->invSlot       = false;
     rsp->rspChksPassed = false;
@@ -58,6 +58,7 @@ extern "C" {
 #define HSMBUSYERR             0x00000F01 //HSM is Busy prior to sending the command
 #define HSMBUSYTIMEOUTERR      0x00000F02 //HSM Busy Timeout after sending command 
 #define HSMNONOPERR            0x00000F03 //HSM Not in Op mode
+#define NUMHSMERRCODES         4
 
 #define HSM_STATUS_BUSY_VAL  ((HSM_REGS->HSM_STATUS & HSM_STATUS_BUSY_Msk) >> HSM_STATUS_BUSY_Pos)
 #define HSM_STATUS_ECODE_VAL ((HSM_REGS->HSM_STATUS & HSM_STATUS_ECODE_Msk) >> HSM_STATUS_ECODE_Pos)
@@ -67,6 +68,15 @@ extern "C" {
 
 #define NBCYCLESPERTICK        1000
 #define MBRXSTATUS_RXINT_MASK  0x00100000
+
+//HSM_MB_WAIT_AUTO: Sleep when the expected command latency is at least this
+//                  (cycles), spin for the shorter commands
+#define HSM_MB_SLEEP_MIN_CYCLES  24000
+
+//HSM MB sleep wake-up timer: RTC MODE0 counter on GCLK_RTC (OSC32KCTRL
+//RTCSEL ULP1K, see the clock PLIB).  The RTC is reserved for HsmMbSleep().
+#define HSM_MB_SLEEP_RTC_HZ      1024
+
 #define MAILBOX_FIFO_ADDR      (HSM_REGS->HSM_MBFIFO)
 
 //Command Request Types
@@ -323,6 +333,19 @@ typedef struct {
     uint32_t                    resultData[MAX_RSP_RESULT_WORDS];
 } HsmCmdResp;
 
+// HSM MB command completion wait (HsmMbSetWaitMode())
+typedef enum _HsmMbWaitMode
+{
+    HSM_MB_WAIT_SPIN  = 0,  //Poll the HSM MB at full clock
+    HSM_MB_WAIT_SLEEP = 1,  //Sleep (WFE) until the HSM MB response
+    HSM_MB_WAIT_AUTO  = 2,  //Sleep for the long commands only
+} HsmMbWaitMode;
+
+// Interrupt mode (int_mode == true) command completion callback
+// --Called from HSM_RXINT_Handler() after the response has been read from 
+//   the MB FIFO into the cmdRsp given to HsmMbCmdSubmit().
+typedef void (*HsmCmdCallback)(HsmCmdResp * cmdRsp, void * context);
+
 // Test Data Struct
 typedef struct {
   bool               invArgs;       // Invalid Command Arguments
@@ -371,6 +394,39 @@ typedef struct
     CmdSGFlagsLength    flagsLength;
 } CmdSGDescriptor;
 
+#define HSM_SG_MAX_LENGTH       0x0FFFFFFF  //flagsLength.length (28 bits)
+#define HSM_SG_MAX_CHAIN        32          //Descriptors per chain (all walks)
+
+//Next descriptor address field (word address, bits [31:2])
+#define HSM_SG_NEXT_ADDR(sgPtr) ((uint32_t) (sgPtr) >> 2)
+#define HSM_SG_NEXT_PTR(sg)     ((CmdSGDescriptor *) \
+                                 ((uint32_t) (sg)->next.s.addr << 2))
+
+
+//======================================================================         
+// HSM Command Context 
+// --Everything one command request needs: the request, its IN/OUT SG 
+//   descriptors, the MB response, the response check results and a small
+//   output data buffer for commands that return a few words.
+// --The HsmCmd*Ctx() API variants only use the given context, so a command
+//   can be built in one context while another context is in the HSM, and
+//   callers with their own context do not corrupt each other's descriptors.
+// --req.cmdInputs[0]/[1] point to the context dmaIn[0]/dmaOut[0] 
+//   (see HsmCmdCtxInit()).
+//======================================================================         
+#define HSM_CMD_CTX_SG_DESC   3  //Input/Output SG Descriptors per context
+#define HSM_CMD_CTX_DATA_WORDS 4 //Command output data (e.g. VS slot info)
+
+typedef struct
+{
+    HsmCmdReq              req;
+    HsmCmdResp             rsp;
+    CmdSGDescriptor ALIGN4 dmaIn[HSM_CMD_CTX_SG_DESC];
+    CmdSGDescriptor ALIGN4 dmaOut[HSM_CMD_CTX_SG_DESC];
+    RSP_DATA               rspData;
+    uint32_t ALIGN4        cmdData[HSM_CMD_CTX_DATA_WORDS];
+} HsmCmdCtx;
+
 
 extern bool           busy;
 extern HsmStatusECODE ecode;
@@ -402,11 +458,41 @@ void          GetHsmStatus(bool *busy,
 char *        CmdResultCodeStr(uint32_t cmdResultCode);
 void          PrintSG(CmdSGDescriptor dmaData, bool printData);
 void          HsmCmdRsp(void); 
-
-void          HsmCmdRsp(void); 
+void          HsmCmdRspRead(HsmCmdResp * cmdRsp); 
 void          HsmMbCmdDriver(HsmCmdReq * cmd_req, bool int_mode); 
+void          HsmMbCmdSubmit(HsmCmdReq *    cmdReq, 
+                             HsmCmdResp *   cmdRsp,
+                             HsmCmdCallback callback, 
+                             void *         context); 
+bool          HsmMbCmdPending(void); 
+bool          HsmMbCmdTimeoutCheck(void); 
+void          HsmMbSetWaitMode(HsmMbWaitMode mode); 
+HsmMbWaitMode HsmMbGetWaitMode(void); 
+void          HsmMbCmdWait(void); 
+bool          HsmMbIdle(void); 
+bool          HsmMbWaitIdle(void); 
 void          HsmCmdRspChkr(RSP_DATA * rsp, bool printExpData); 
 void          ClearRsp();
+void          ClearRspData(RSP_DATA * rsp);
+
+//HSM Command Context
+void          HsmMbCmdExec(HsmCmdReq * cmdReq, HsmCmdResp * cmdRsp); 
+void          HsmCmdCtxInit(HsmCmdCtx * ctx);
+void          HsmCmdCtxSetSG(CmdSGDescriptor * sg, 
+                             void *            addr, 
+                             uint32_t          numBytes,
+                             CmdSGDescriptor * next);
+int           HsmCmdCtxSetSGData(CmdSGDescriptor * sg, 
+                                 int               maxDesc,
+                                 void *            addr, 
+                                 uint32_t          numBytes);
+void          HsmCmdCtxExec(HsmCmdCtx * ctx);
+bool          HsmCmdCtxSubmit(HsmCmdCtx *    ctx,
+                              HsmCmdCallback callback, 
+                              void *         context);
+void          HsmCmdCtxError(HsmCmdCtx * ctx, uint32_t resultCode);
+void          HsmCmdCtxRspChkr(HsmCmdCtx * ctx, bool printExpData); 
+RSP_DATA *    HsmCmdCtxPublish(HsmCmdCtx * ctx);
 
 
 // Create a global command response variable so it can be accessed by the 
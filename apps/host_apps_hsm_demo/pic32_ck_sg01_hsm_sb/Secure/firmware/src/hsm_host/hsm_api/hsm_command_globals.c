@@ -11,6 +11,9 @@ HsmCmdReq   gHsmCmdReq;
 HsmCmdResp  gHsmCmdResp;
 RSP_DATA    gRspData;
 
+//Command context of the non-context (legacy) HsmCmd* API functions
+HsmCmdCtx   gHsmCmdCtx;
+
 //HSM Status Register
 bool           busy;  //HSM Busy
 HsmStatusECODE ecode; //Error Return Code
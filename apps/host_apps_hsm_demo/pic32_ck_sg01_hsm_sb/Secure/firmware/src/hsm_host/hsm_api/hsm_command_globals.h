@@ -56,6 +56,7 @@ extern uint32_t ALIGN4        keyHostStoragePublic[16];
 extern HsmCmdResp gHsmCmdResp;
 extern RSP_DATA   gRspData;
 extern HsmCmdReq  gHsmCmdReq;
+extern HsmCmdCtx  gHsmCmdCtx;
 
 //HSM Status
 //extern bool           busy;  //HSM Busy
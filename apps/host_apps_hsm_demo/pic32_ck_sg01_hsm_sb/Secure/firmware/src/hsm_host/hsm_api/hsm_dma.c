@@ -0,0 +1,188 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Microchip Technology
+
+  @File Name
+    hsm_dma.c
+
+  @Summary
+    HSM DMA Buffer Cache Maintenance (CMCC)
+
+  @Description
+    Clean (write buffer drain) before and invalidate (CMCC line by
+    index/way) after the HSM DMA of the command SG chains.
+ */
+/* ************************************************************************** */
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Included Files                                                    */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+#include <stdlib.h>
+#include <string.h>
+#include "pic32ck2051sg01144.h"
+#include "core_cm33.h"
+#include "user.h"
+#include "peripheral/cmcc/plib_cmcc.h"
+#include "hsm_dma.h"
+
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Local Functions                                                   */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+//******************************************************************************
+// SG descriptor data the HSM DMA accesses in memory
+// --Not the discarded (no data) and the constant address (register) ones
+//******************************************************************************
+static bool HsmDmaSGData(CmdSGDescriptor * sg)
+{
+    return (sg->data.addr != NULL &&
+            sg->flagsLength.s.length > 0 &&
+            sg->flagsLength.s.discard == 0 &&
+            sg->flagsLength.s.cstAddr == 0);
+} //End HsmDmaSGData()
+
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Interface Functions                                               */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+//******************************************************************************
+// CMCC enabled with the data cache on
+//******************************************************************************
+bool HsmDmaCacheEnabled(void)
+{
+    return ((CMCC_REGS->CMCC_SR  & CMCC_SR_CSTS_Msk) != 0 &&
+            (CMCC_REGS->CMCC_CFG & CMCC_CFG_DCDIS_Msk) == 0);
+} //End HsmDmaCacheEnabled()
+
+
+//******************************************************************************
+// Make CPU writes of a buffer visible to the HSM DMA
+// --The CMCC is write-through: only the write buffer is drained.
+//******************************************************************************
+void HsmDmaClean(const void * addr, uint32_t numBytes)
+{
+    (void) addr;
+    (void) numBytes;
+
+    __DSB();
+} //End HsmDmaClean()
+
+
+//******************************************************************************
+// Discard the cached lines of a buffer written by the HSM DMA
+// --Every line of [addr, addr + numBytes) is invalidated in all the ways
+//   (CMCC_MAINT1 is by index/way).  Buffers of a cache size or more
+//   invalidate the whole cache (CMCC_MAINT0).
+// --The cache is disabled during the maintenance (CMCC line invalidate
+//   sequence), interrupts are disabled for its duration.
+//******************************************************************************
+void HsmDmaInvalidate(const void * addr, uint32_t numBytes)
+{
+    uint32_t line;
+    uint32_t lastLine;
+    uint32_t way;
+    uint32_t primask;
+
+    if (numBytes == 0 || !HsmDmaCacheEnabled()) return;
+
+    line     = (uint32_t) addr / CMCC_LINE_SIZE;
+    lastLine = ((uint32_t) addr + numBytes - 1) / CMCC_LINE_SIZE;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+
+    CMCC_REGS->CMCC_CTRL &= ~(CMCC_CTRL_CEN_Msk);
+    while ((CMCC_REGS->CMCC_SR & CMCC_SR_CSTS_Msk) == CMCC_SR_CSTS_Msk)
+    {
+        //Wait for the cache to be disabled
+    }
+
+    if ((lastLine - line) >= CMCC_LINE_PER_WAY)
+    {
+        CMCC_REGS->CMCC_MAINT0 = CMCC_MAINT0_INVALL_Msk;
+    }
+    else
+    {
+        for (; line <= lastLine; line++)
+        {
+            for (way = 0; way < CMCC_NO_OF_WAYS; way++)
+            {
+                CMCC_REGS->CMCC_MAINT1 =
+                    CMCC_MAINT1_INDEX(line % CMCC_LINE_PER_WAY) |
+                    CMCC_MAINT1_WAY(way);
+            }
+        }
+    }
+
+    CMCC_REGS->CMCC_CTRL = CMCC_CTRL_CEN_Msk;
+    __set_PRIMASK(primask);
+} //End HsmDmaInvalidate()
+
+
+//******************************************************************************
+// Clean the descriptors and the data of a SG chain (sg can be NULL)
+//******************************************************************************
+void HsmDmaSGClean(CmdSGDescriptor * sg)
+{
+    //Write-through:  one drain covers the whole chain
+    (void) sg;
+    HsmDmaClean(NULL, 0);
+} //End HsmDmaSGClean()
+
+
+//******************************************************************************
+// Invalidate the data of a SG chain (sg can be NULL)
+//******************************************************************************
+void HsmDmaSGInvalidate(CmdSGDescriptor * sg)
+{
+    int i;
+
+    if (!HsmDmaCacheEnabled()) return;
+
+    for (i = 0; i < HSM_SG_MAX_CHAIN && sg != NULL; i++)
+    {
+        if (HsmDmaSGData(sg))
+        {
+            HsmDmaInvalidate(sg->data.addr, sg->flagsLength.s.length);
+        }
+        if (sg->next.s.stop) break;
+        sg = HSM_SG_NEXT_PTR(sg);
+    }
+} //End HsmDmaSGInvalidate()
+
+
+//******************************************************************************
+// Command request buffers to the HSM (before the MB write)
+// --IN (cmdInputs[0]) and OUT (cmdInputs[1]) SG chains
+//******************************************************************************
+void HsmDmaCmdPrepare(HsmCmdReq * cmdReq)
+{
+    HsmDmaSGClean((CmdSGDescriptor *) cmdReq->cmdInputs[0]);
+    HsmDmaSGClean((CmdSGDescriptor *) cmdReq->cmdInputs[1]);
+} //End HsmDmaCmdPrepare()
+
+
+//******************************************************************************
+// Command output buffers to the CPU (after the response)
+// --OUT (cmdInputs[1]) SG chain
+//******************************************************************************
+void HsmDmaCmdComplete(HsmCmdReq * cmdReq)
+{
+    HsmDmaSGInvalidate((CmdSGDescriptor *) cmdReq->cmdInputs[1]);
+} //End HsmDmaCmdComplete()
+
+
+/* *****************************************************************************
+ End of File
+ */
@@ -0,0 +1,91 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Microchip Technology
+
+  @File Name
+    hsm_dma.h
+
+  @Summary
+    HSM DMA Buffer Cache Maintenance (CMCC)
+
+  @Description
+    Makes the HSM DMA buffers coherent with the CMCC data cache, so the data
+    cache (CMCC_EnableDCache()) can be enabled on the secure image:
+
+      HsmDmaCmdPrepare():  Before the command is written to the HSM MB, the
+                           IN/OUT descriptors and the IN data are in SRAM.
+      HsmDmaCmdComplete(): After the response, the OUT data lines are
+                           invalidated, so the CPU reads what the HSM wrote.
+
+    Both are called from the HSM MB command paths (hsm_command.c), the
+    HsmCmd* APIs do not need any cache maintenance.
+
+    The CMCC is write-through (no dirty lines), so the "clean" is a write
+    buffer drain (DSB) and an invalidate never loses CPU writes.  Buffers
+    that share a cache line with other data therefore do not need bounce
+    buffers:  the shared lines are invalidated and reloaded from SRAM.
+ */
+/* ************************************************************************** */
+
+#ifndef _HSM_DMA_H    /* Guard against multiple inclusion */
+#define _HSM_DMA_H
+
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Included Files                                                    */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "hsm_command.h"
+
+/* Provide C++ Compatibility */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Constants                                                         */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+//Set to 1 to enable the CMCC data cache in HSM_INIT (startup_xc32.c
+//CMCC_Configure() leaves it disabled)
+#ifndef HSM_DMA_DCACHE_ENABLE
+#define HSM_DMA_DCACHE_ENABLE  0
+#endif
+
+//Cache line aligned buffer (CMCC_LINE_SIZE)
+#define ALIGN_CACHE __attribute__((aligned(16)))
+
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+
+bool HsmDmaCacheEnabled(void);
+void HsmDmaClean(const void * addr, uint32_t numBytes);
+void HsmDmaInvalidate(const void * addr, uint32_t numBytes);
+void HsmDmaSGClean(CmdSGDescriptor * sg);
+void HsmDmaSGInvalidate(CmdSGDescriptor * sg);
+void HsmDmaCmdPrepare(HsmCmdReq * cmdReq);
+void HsmDmaCmdComplete(HsmCmdReq * cmdReq);
+
+/* Provide C++ Compatibility */
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _HSM_DMA_H */
+
+/* *****************************************************************************
+ End of File
+ */
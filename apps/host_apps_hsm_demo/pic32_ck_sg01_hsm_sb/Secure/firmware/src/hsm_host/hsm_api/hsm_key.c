@@ -0,0 +1,254 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Microchip Technology
+
+  @File Name
+    hsm_key.c
+
+  @Summary
+    HSM AES Key Promotion (VM_STORAGE Key Slots)
+
+  @Description
+    Loads the AES keys used by pointer more than once into the reserved
+    VM_STORAGE slots (LRU replacement).
+ */
+/* ************************************************************************** */
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Included Files                                                    */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+#include <stdlib.h>
+#include <string.h>
+#include "pic32ck2051sg01144.h"
+#include "core_cm33.h"
+#include "user.h"
+#include "vsm.h"
+#include "hsm_key.h"
+
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: File Scope or Global Data                                         */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+// Promoted key (entry i is slot HSM_KEY_SLOT_FIRST + i)
+typedef struct
+{
+    const uint32_t * key;        //Key buffer (NULL: entry free)
+    uint32_t         keyCopy[8]; //Key bytes (changed key buffer check)
+    uint8_t          keySize;    //CmdAesKeySize
+    uint8_t          aesType;    //VssSkAesType
+    uint8_t          uses;       //Up to HSM_KEY_PROMOTE_USES
+    bool             loaded;     //Key is in the slot
+    uint32_t         lastUse;    //LRU tick
+} HsmKeyEntry;
+
+static HsmKeyEntry hsmKeyTable[HSM_KEY_SLOTS];
+static uint32_t    hsmKeyTick = 0;
+
+//Slot input data:  VS metadata words, key words, one word for the SG length
+//(HsmCmdVsmInputDataUnencryptedStoragePrep())
+static uint32_t ALIGN4 hsmKeyInput[VSS_META_WORDS + 8 + 1];
+
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Local Functions                                                   */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+//******************************************************************************
+// Key bytes of an AES key size
+//******************************************************************************
+static uint32_t HsmKeyBytes(CmdAesKeySize keySize)
+{
+    return 16 + 8 * (uint32_t) keySize;  //128/192/256
+} //End HsmKeyBytes()
+
+
+//******************************************************************************
+// Free a table entry (its key slot is deleted)
+//******************************************************************************
+static void HsmKeyEntryFree(HsmCmdCtx * ctx, int index)
+{
+    HsmKeyEntry * entry = &hsmKeyTable[index];
+
+    if (entry->loaded)
+    {
+        HsmCmdVsmDeleteSlotCtx(ctx, HSM_KEY_SLOT_FIRST + index);
+    }
+    memset(entry, 0, sizeof(HsmKeyEntry));
+} //End HsmKeyEntryFree()
+
+
+//******************************************************************************
+// Load the key of a table entry into its slot (CMD_VSM_INPUT_DATA,
+// VM_STORAGE)
+//******************************************************************************
+static bool HsmKeyEntryLoad(HsmCmdCtx * ctx, int index)
+{
+    HsmKeyEntry *              entry    = &hsmKeyTable[index];
+    uint32_t                   keyBytes = HsmKeyBytes(entry->keySize);
+    CmdVSMDataSpecificMetaData specMetaData;
+    RSP_DATA *                 rsp;
+
+    //AES key metadata
+    specMetaData.v = 0;
+    specMetaData.aesSkMeta.s.keyType = VSS_SK_AES;
+    specMetaData.aesSkMeta.s.aesType = entry->aesType;
+    specMetaData.aesSkMeta.s.keySize = entry->keySize;
+
+    //VS Input Metadata (four words) prior to the key data
+    hsmKeyInput[0] = keyBytes + VSS_META_BYTES;
+    hsmKeyInput[1] = 0x00000000;  //Valid Before
+    hsmKeyInput[2] = 0xFFFFFFFF;  //Valid After
+    hsmKeyInput[3] = specMetaData.v;
+    memcpy(&hsmKeyInput[VSS_META_WORDS], entry->keyCopy, keyBytes);
+
+    rsp = HsmCmdVsmInputDataUnencryptedStorageCtx(ctx,
+            HSM_KEY_SLOT_FIRST + index, hsmKeyInput,
+            VSS_META_WORDS + keyBytes / BYTES_PER_WORD,
+            CMD_VSS_SYMMETRICALKEY, specMetaData, VM_STORAGE);
+
+    //No key copy left in the slot input buffer
+    memset(hsmKeyInput, 0, sizeof(hsmKeyInput));
+
+    entry->loaded = (rsp->rspChksPassed == true);
+    return entry->loaded;
+} //End HsmKeyEntryLoad()
+
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Interface Functions                                               */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+//******************************************************************************
+// Forget all the promoted keys (the VM_STORAGE slots are lost on HSM reset)
+//******************************************************************************
+void HsmKeyInit(void)
+{
+    memset(hsmKeyTable, 0, sizeof(hsmKeyTable));
+    hsmKeyTick = 0;
+} //End HsmKeyInit()
+
+
+//******************************************************************************
+// VSM slot of a key given by pointer
+// --Returns the slot with the key, or -1:  the key is not (yet) in a slot,
+//   use the key pointer.
+// --The key is loaded on its HSM_KEY_PROMOTE_USES'th use.  A new key takes
+//   the least recently used entry.
+// --ctx is used for the slot input/delete commands (not sent if the key is
+//   already in its slot).
+//******************************************************************************
+int HsmKeySlot(HsmCmdCtx *      ctx,
+               const uint32_t * key,
+               CmdAesKeySize    keySize,
+               VssSkAesType     aesType)
+{
+    HsmKeyEntry * entry;
+    int           index = -1;
+    int           i;
+
+    if (key == NULL || keySize > CMD_AES_KEY_256) return -1;
+
+    hsmKeyTick++;
+
+    for (i = 0; i < HSM_KEY_SLOTS; i++)
+    {
+        entry = &hsmKeyTable[i];
+        if (entry->key == key && entry->keySize == keySize &&
+            entry->aesType == aesType)
+        {
+            index = i;
+            break;
+        }
+    }
+
+    //Buffer holds another key:  drop the old slot
+    if (index >= 0 &&
+        memcmp(hsmKeyTable[index].keyCopy, key, HsmKeyBytes(keySize)) != 0)
+    {
+        HsmKeyEntryFree(ctx, index);
+        index = -1;
+    }
+
+    //New key:  free or least recently used entry
+    if (index < 0)
+    {
+        index = 0;
+        for (i = 0; i < HSM_KEY_SLOTS; i++)
+        {
+            if (hsmKeyTable[i].key == NULL)
+            {
+                index = i;
+                break;
+            }
+            if (hsmKeyTable[i].lastUse < hsmKeyTable[index].lastUse)
+            {
+                index = i;
+            }
+        }
+        HsmKeyEntryFree(ctx, index);
+
+        entry          = &hsmKeyTable[index];
+        entry->key     = key;
+        memcpy(entry->keyCopy, key, HsmKeyBytes(keySize));
+        entry->keySize = keySize;
+        entry->aesType = aesType;
+    }
+
+    entry = &hsmKeyTable[index];
+    entry->lastUse = hsmKeyTick;
+    if (entry->uses < HSM_KEY_PROMOTE_USES) entry->uses++;
+
+    if (!entry->loaded && entry->uses >= HSM_KEY_PROMOTE_USES &&
+        !HsmKeyEntryLoad(ctx, index))
+    {
+        //Slot not usable:  the key stays a pointer key
+        entry->uses = 0;
+    }
+
+    return entry->loaded ? HSM_KEY_SLOT_FIRST + index : -1;
+} //End HsmKeySlot()
+
+
+//******************************************************************************
+// Key buffer freed/reused:  delete the slots of the key
+//******************************************************************************
+void HsmKeyForget(HsmCmdCtx * ctx, const uint32_t * key)
+{
+    int i;
+
+    for (i = 0; i < HSM_KEY_SLOTS; i++)
+    {
+        if (hsmKeyTable[i].key == key) HsmKeyEntryFree(ctx, i);
+    }
+} //End HsmKeyForget()
+
+
+//******************************************************************************
+// Delete all the promoted key slots
+//******************************************************************************
+void HsmKeyFlush(HsmCmdCtx * ctx)
+{
+    int i;
+
+    for (i = 0; i < HSM_KEY_SLOTS; i++)
+    {
+        if (hsmKeyTable[i].key != NULL) HsmKeyEntryFree(ctx, i);
+    }
+} //End HsmKeyFlush()
+
+
+/* *****************************************************************************
+ End of File
+ */
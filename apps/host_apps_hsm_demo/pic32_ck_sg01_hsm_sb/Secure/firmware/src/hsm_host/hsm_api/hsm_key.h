@@ -0,0 +1,105 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Microchip Technology
+
+  @File Name
+    hsm_key.h
+
+  @Summary
+    HSM AES Key Promotion (VM_STORAGE Key Slots)
+
+  @Description
+    A key given by pointer (streamed key) is sent with every AES command as
+    an extra IN descriptor.  A key that is used again is loaded once into a
+    volatile (VM_STORAGE) VSM slot and the commands use the slot instead:
+
+        slot = HsmKeySlot(ctx, key, CMD_AES_KEY_128, VSS_SK_AES_ECB);
+        if (slot > 0) //Key in the HSM:  vsSlotNum = slot, key = NULL
+
+    The slots HSM_KEY_SLOT_FIRST..+HSM_KEY_SLOTS-1 are reserved for the
+    promoted keys, the least recently used one is replaced (and deleted)
+    when a new key needs a slot.
+
+    A key is identified by its buffer address, size and AES type.  A copy
+    of the key bytes is kept with the entry:  a buffer that holds a
+    different key is detected (the old slot is then dropped, the key is
+    never used from a stale slot).  Call HsmKeyForget() before freeing or
+    reusing a key buffer, so the key does not stay in the HSM or the host
+    table.
+
+    HSM_KEY_PROMOTE enables the promotion in HsmCmdAesEcbEncryptDecrypt*().
+ */
+/* ************************************************************************** */
+
+#ifndef _HSM_KEY_H    /* Guard against multiple inclusion */
+#define _HSM_KEY_H
+
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Included Files                                                    */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "hsm_command.h"
+#include "aes.h"
+
+/* Provide C++ Compatibility */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Constants                                                         */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+//Set to 1 to promote the HsmCmdAesEcbEncryptDecrypt*() key pointers
+#ifndef HSM_KEY_PROMOTE
+#define HSM_KEY_PROMOTE       0
+#endif
+
+//VSM slots reserved for the promoted keys (MINSLOTNUM < slot < MAXSLOTNUM)
+#ifndef HSM_KEY_SLOT_FIRST
+#define HSM_KEY_SLOT_FIRST    240
+#endif
+#ifndef HSM_KEY_SLOTS
+#define HSM_KEY_SLOTS         4
+#endif
+
+//Uses of a key before it is loaded into a slot (1: on the first use)
+#ifndef HSM_KEY_PROMOTE_USES
+#define HSM_KEY_PROMOTE_USES  2
+#endif
+
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+
+void HsmKeyInit(void);
+int  HsmKeySlot(HsmCmdCtx *      ctx,
+                const uint32_t * key,
+                CmdAesKeySize    keySize,
+                VssSkAesType     aesType);
+void HsmKeyForget(HsmCmdCtx * ctx, const uint32_t * key);
+void HsmKeyFlush(HsmCmdCtx * ctx);
+
+/* Provide C++ Compatibility */
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _HSM_KEY_H */
+
+/* *****************************************************************************
+ End of File
+ */
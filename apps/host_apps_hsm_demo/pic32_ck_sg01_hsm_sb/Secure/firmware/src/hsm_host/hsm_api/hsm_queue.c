@@ -0,0 +1,229 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Microchip Technology
+
+  @File Name
+    hsm_queue.c
+
+  @Summary
+    HSM Mailbox Command Queue
+
+  @Description
+    Bounded ring buffer of HSM command requests in front of the HSM mailbox.
+ */
+/* ************************************************************************** */
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Included Files                                                    */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+#include <stdlib.h>
+#include <string.h>
+#include "pic32ck2051sg01144.h"
+#include "core_cm33.h"
+#include "user.h"
+#include "hsm_queue.h"
+#include "hsm_timeout.h"
+
+#define HSM_CMD_QUEUE_MASK  (HSM_CMD_QUEUE_DEPTH - 1)
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: File Scope or Global Data                                         */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+//Queue Entries (indexed by the free running head/tail counters)
+static HsmCmdQueueEntry  hsmCmdQueue[HSM_CMD_QUEUE_DEPTH];
+static volatile uint32_t hsmCmdQueueHead = 0; //Oldest entry (next to send)
+static volatile uint32_t hsmCmdQueueTail = 0; //Next entry to allocate
+
+//Oldest entry ready, waiting for the HSM to be not BUSY
+static HsmDeadline       hsmCmdQueueIdleDeadline;
+static bool              hsmCmdQueueIdleWait = false;
+
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Local Functions                                                   */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+//******************************************************************************
+// Queue entry completion (called from HSM_RXINT_Handler())
+// --Check the response (not printed, interrupt context), call the producer
+//   callback, free the entry and send the next entry
+//******************************************************************************
+static void HsmCmdQueueComplete(HsmCmdResp * cmdRsp, void * context)
+{
+    HsmCmdQueueEntry * entry = (HsmCmdQueueEntry *) context;
+
+    HsmCmdCtxRspChkr(&entry->ctx, false);
+    if (entry->callback != NULL)
+    {
+        entry->callback(&entry->ctx, entry->context);
+    }
+
+    entry->state = HSM_QUEUE_FREE;
+    hsmCmdQueueHead++;
+
+    //Keep the HSM busy back-to-back
+    HsmCmdQueueTasks();
+
+} //End HsmCmdQueueComplete()
+
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Interface Functions                                               */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+//******************************************************************************
+// Initialize the HSM Command Queue (all entries free)
+//******************************************************************************
+void HsmCmdQueueInit(void)
+{
+    memset(hsmCmdQueue, 0, sizeof(hsmCmdQueue));
+    hsmCmdQueueHead = 0;
+    hsmCmdQueueTail = 0;
+} //End HsmCmdQueueInit()
+
+
+//******************************************************************************
+// Allocate the next queue entry (non-blocking)
+// --Returns NULL when the queue is full.
+// --The entry request IN/OUT point to the entry ctx.dmaIn[0]/ctx.dmaOut[0]
+//   descriptors.
+//******************************************************************************
+HsmCmdQueueEntry * HsmCmdQueueAlloc(void)
+{
+    HsmCmdQueueEntry * entry = NULL;
+    uint32_t           primask;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    if ((hsmCmdQueueTail - hsmCmdQueueHead) < HSM_CMD_QUEUE_DEPTH)
+    {
+        entry = &hsmCmdQueue[hsmCmdQueueTail & HSM_CMD_QUEUE_MASK];
+        entry->state = HSM_QUEUE_ALLOC;
+        hsmCmdQueueTail++;
+    }
+    __set_PRIMASK(primask);
+
+    if (entry != NULL)
+    {
+        HsmCmdCtxInit(&entry->ctx);
+        entry->callback = NULL;
+        entry->context  = NULL;
+    }
+
+    return entry;
+} //End HsmCmdQueueAlloc()
+
+
+//******************************************************************************
+// Submit an allocated entry to the HSM MB (non-blocking)
+// --entry->ctx is prepared by a HsmCmd*Prep() function.
+// --callback(ctx, context) is called from the HSM RXINT interrupt when the
+//   command completes (can be NULL).  It must not send polled commands.
+// --Entries are sent in allocation order.
+//******************************************************************************
+void HsmCmdQueueSubmit(HsmCmdQueueEntry *  entry,
+                       HsmCmdQueueCallback callback,
+                       void *              context)
+{
+    entry->callback = callback;
+    entry->context  = context;
+    entry->state    = HSM_QUEUE_READY;
+
+    HsmCmdQueueTasks();
+} //End HsmCmdQueueSubmit()
+
+
+//******************************************************************************
+// Queue Dispatcher
+// --Send the oldest entry when it is ready and the HSM MB is idle.
+// --Called on submit and on command completion.  Call from the application
+//   loop as well, since the HSM can still be BUSY when the RXINT of the
+//   previous command is handled.
+// --The active entry completes with HSMBUSYTIMEOUTERR at its deadline, and
+//   a ready entry with HSMBUSYERR when the HSM stays BUSY for 
+//   HSM_TIMEOUT_IDLE_CYCLES, so the queue always drains.
+//******************************************************************************
+void HsmCmdQueueTasks(void)
+{
+    HsmCmdQueueEntry * entry;
+    uint32_t           primask;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    HsmMbCmdTimeoutCheck();
+    if (hsmCmdQueueHead != hsmCmdQueueTail)
+    {
+        entry = &hsmCmdQueue[hsmCmdQueueHead & HSM_CMD_QUEUE_MASK];
+        if (entry->state == HSM_QUEUE_READY && 
+            (entry->ctx.rspData.invArgs || entry->ctx.rspData.invSlot))
+        {
+            //Rejected by the Prep function:  not sent
+            entry->state = HSM_QUEUE_ACTIVE;
+            HsmCmdCtxError(&entry->ctx, E_INVPARAM);
+            HsmCmdQueueComplete(&entry->ctx.rsp, entry);
+        }
+        else if (entry->state == HSM_QUEUE_READY && HsmMbIdle())
+        {
+            hsmCmdQueueIdleWait = false;
+            entry->state = HSM_QUEUE_ACTIVE;
+            HsmMbCmdSubmit(&entry->ctx.req, &entry->ctx.rsp,
+                           HsmCmdQueueComplete, entry);
+        }
+        else if (entry->state == HSM_QUEUE_READY && !HsmMbCmdPending())
+        {
+            if (!hsmCmdQueueIdleWait)
+            {
+                HsmDeadlineStart(&hsmCmdQueueIdleDeadline, 
+                                 HSM_TIMEOUT_IDLE_CYCLES);
+                hsmCmdQueueIdleWait = true;
+            }
+            else if (HsmDeadlineExpired(&hsmCmdQueueIdleDeadline))
+            {
+                hsmCmdQueueIdleWait = false;
+                entry->state = HSM_QUEUE_ACTIVE;
+                HsmCmdCtxError(&entry->ctx, HSMBUSYERR);
+                HsmCmdQueueComplete(&entry->ctx.rsp, entry);
+            }
+        }
+    }
+    __set_PRIMASK(primask);
+} //End HsmCmdQueueTasks()
+
+
+//******************************************************************************
+// Number of allocated entries (being prepared, waiting or in the HSM)
+//******************************************************************************
+int HsmCmdQueueCount(void)
+{
+    return (int) (hsmCmdQueueTail - hsmCmdQueueHead);
+} //End HsmCmdQueueCount()
+
+
+//******************************************************************************
+// Wait for all the submitted entries to complete
+// --Entries still being prepared (HSM_QUEUE_ALLOC) must be submitted first.
+//******************************************************************************
+void HsmCmdQueueFlush(void)
+{
+    while (HsmCmdQueueCount() > 0)
+    {
+        HsmCmdQueueTasks();
+    }
+} //End HsmCmdQueueFlush()
+
+
+/* *****************************************************************************
+ End of File
+ */
@@ -0,0 +1,124 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Microchip Technology
+
+  @File Name
+    hsm_queue.h
+
+  @Summary
+    HSM Mailbox Command Queue
+
+  @Description
+    Bounded ring buffer of HSM command requests in front of the HSM mailbox.
+    Each entry has its own command context (request, SG descriptors and 
+    response), so commands can be prepared while the HSM executes the 
+    previous one.  The dispatcher sends the next ready entry (interrupt mode) 
+    as soon as the HSM MB is idle.
+
+    A producer prepares the entry context with the HsmCmd*Prep() function of
+    the command and submits it:
+
+        entry = HsmCmdQueueAlloc();
+        if (entry != NULL)
+        {
+            HsmCmdHashBlockPrep(&entry->ctx, CMD_HASH_SHA256, in, len, out);
+            HsmCmdQueueSubmit(entry, callback, context);
+        }
+
+    (HsmCmdHashBlockQueue(), HsmCmdAesEcbEncryptDecryptQueue() do this).
+    HsmCmdQueueTasks() must be called from the application loop 
+    (HSM_Tasks()).
+ */
+/* ************************************************************************** */
+
+#ifndef _HSM_QUEUE_H    /* Guard against multiple inclusion */
+#define _HSM_QUEUE_H
+
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Included Files                                                    */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "hsm_command.h"
+
+/* Provide C++ Compatibility */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Constants                                                         */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+#define HSM_CMD_QUEUE_DEPTH     8  //Number of entries (power of 2)
+
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Data Types
+// *****************************************************************************
+// *****************************************************************************
+
+typedef enum _HsmCmdQueueState
+{
+    HSM_QUEUE_FREE   = 0,  //Not allocated
+    HSM_QUEUE_ALLOC  = 1,  //Allocated to a producer (being prepared)
+    HSM_QUEUE_READY  = 2,  //Submitted, waiting for the HSM MB
+    HSM_QUEUE_ACTIVE = 3,  //Sent to the HSM MB, waiting for RXINT
+} HsmCmdQueueState;
+
+// Queue entry completion callback (HSM RXINT interrupt or HsmCmdQueueTasks())
+// --ctx->rsp is the response and ctx->rspData its checks (HsmCmdCtxRspChkr())
+typedef void (*HsmCmdQueueCallback)(HsmCmdCtx * ctx, void * context);
+
+// HSM Command Queue Entry
+// --The producer fills the entry command context (HsmCmd*Prep(&entry->ctx)),
+//   with ctx.req.cmdInputs[0]/[1] pointing to the entry's own descriptors
+//   (or SG pool chains freed by the callback).
+// --A request the Prep function rejected (rspData.invArgs/invSlot) is not 
+//   sent, it completes with E_INVPARAM in its queue order.
+// --ctx.rsp/ctx.rspData are valid in the completion callback.  The entry is
+//   freed when the callback returns.
+typedef struct
+{
+    HsmCmdCtx                   ctx;
+    HsmCmdQueueCallback         callback;
+    void *                      context;
+    volatile HsmCmdQueueState   state;
+} HsmCmdQueueEntry;
+
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+
+void               HsmCmdQueueInit(void);
+HsmCmdQueueEntry * HsmCmdQueueAlloc(void);
+void               HsmCmdQueueSubmit(HsmCmdQueueEntry *  entry,
+                                     HsmCmdQueueCallback callback,
+                                     void *              context);
+void               HsmCmdQueueTasks(void);
+int                HsmCmdQueueCount(void);
+void               HsmCmdQueueFlush(void);
+
+/* Provide C++ Compatibility */
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _HSM_QUEUE_H */
+
+/* *****************************************************************************
+ End of File
+ */
@@ -0,0 +1,248 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Microchip Technology
+
+  @File Name
+    hsm_sg.c
+
+  @Summary
+    HSM Scatter/Gather Descriptor Chains
+
+  @Description
+    SG descriptor pool and the segment list to descriptor chain builder.
+ */
+/* ************************************************************************** */
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Included Files                                                    */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+#include <stdlib.h>
+#include <string.h>
+#include "pic32ck2051sg01144.h"
+#include "core_cm33.h"
+#include "user.h"
+#include "hsm_sg.h"
+
+#define min(a, b) (((a) < (b)) ? (a) : (b))
+
+//The pool is a bit mask (hsmSGPoolUsed)
+#if HSM_SG_POOL_DESC > 32
+#error "HSM_SG_POOL_DESC > 32 (hsmSGPoolUsed has one bit per descriptor)"
+#endif
+
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: File Scope or Global Data                                         */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+static HsmSGPoolDesc hsmSGPool[HSM_SG_POOL_DESC];
+static uint32_t      hsmSGPoolUsed = 0;  //Bit per pool descriptor
+
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Local Functions                                                   */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+//******************************************************************************
+// Pool index of a descriptor (-1 if not a pool descriptor)
+//******************************************************************************
+static int HsmSGPoolIndex(CmdSGDescriptor * sg)
+{
+    uint32_t offset = (uint32_t) sg - (uint32_t) hsmSGPool;
+
+    if ((uint32_t) sg < (uint32_t) hsmSGPool ||
+        offset >= sizeof(hsmSGPool) ||
+        (offset % sizeof(HsmSGPoolDesc)) != 0)
+    {
+        return -1;
+    }
+
+    return (int) (offset / sizeof(HsmSGPoolDesc));
+} //End HsmSGPoolIndex()
+
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Interface Functions                                               */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+//******************************************************************************
+// Free all the pool descriptors
+//******************************************************************************
+void HsmSGPoolInit(void)
+{
+    uint32_t primask;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    memset(hsmSGPool, 0, sizeof(hsmSGPool));
+    hsmSGPoolUsed = 0;
+    __set_PRIMASK(primask);
+} //End HsmSGPoolInit()
+
+
+//******************************************************************************
+// Number of free pool descriptors
+//******************************************************************************
+int HsmSGPoolAvail(void)
+{
+    uint32_t used = hsmSGPoolUsed;
+    int      n    = 0;
+    int      i;
+
+    for (i = 0; i < HSM_SG_POOL_DESC; i++)
+    {
+        if ((used & (1u << i)) == 0) n++;
+    }
+
+    return n;
+} //End HsmSGPoolAvail()
+
+
+//******************************************************************************
+// Build a SG descriptor chain of the segments
+// --One descriptor per segment, the empty segments are skipped (a single
+//   0 byte descriptor if all are empty).  A segment longer than
+//   HSM_SG_MAX_LENGTH (28 bit descriptor length) takes several descriptors.
+//   The last descriptor has stop set.
+// --realign is set on every descriptor, so segments do not have to be word
+//   aligned or a multiple of 4 bytes.  Segments with addr == NULL are
+//   discarded (output chains).
+// --Returns NULL if the pool does not have enough free descriptors (none
+//   are taken).  Can be called from the HSM command callbacks.
+//******************************************************************************
+CmdSGDescriptor * HsmSGChainAlloc(const HsmSGSegment * seg, int numSeg)
+{
+    int               idx[HSM_SG_POOL_DESC];
+    int               numDesc = 0;
+    uint32_t          numBytes;
+    uint32_t          length;
+    uint8_t *         addr;
+    int               i;
+    int               n;
+    uint32_t          primask;
+    CmdSGDescriptor * sg;
+
+    for (i = 0; i < numSeg; i++)
+    {
+        if (seg[i].numBytes > 0)
+        {
+            numDesc += (int) ((seg[i].numBytes - 1) / HSM_SG_MAX_LENGTH) + 1;
+        }
+    }
+    if (numDesc == 0) numDesc = 1;
+    if (numDesc > HSM_SG_POOL_DESC) return NULL;
+
+    //Take numDesc pool descriptors (all or none)
+    primask = __get_PRIMASK();
+    __disable_irq();
+    for (i = 0, n = 0; i < HSM_SG_POOL_DESC && n < numDesc; i++)
+    {
+        if ((hsmSGPoolUsed & (1u << i)) == 0) idx[n++] = i;
+    }
+    if (n < numDesc)
+    {
+        __set_PRIMASK(primask);
+        return NULL;
+    }
+    for (i = 0; i < numDesc; i++) hsmSGPoolUsed |= (1u << idx[i]);
+    __set_PRIMASK(primask);
+
+    //Link the descriptors in segment order
+    for (i = 0, n = 0; i < numSeg; i++)
+    {
+        addr     = (uint8_t *) seg[i].addr;
+        numBytes = seg[i].numBytes;
+        while (numBytes > 0)
+        {
+            length = min(numBytes, HSM_SG_MAX_LENGTH);
+            sg     = &hsmSGPool[idx[n++]].sg;
+            HsmCmdCtxSetSG(sg, addr, length,
+                (n < numDesc) ? &hsmSGPool[idx[n]].sg : NULL);
+            sg->flagsLength.s.discard = (addr == NULL) ? 1 : 0;
+
+            if (addr != NULL) addr += length;
+            numBytes -= length;
+        }
+    }
+    if (n == 0)
+    {
+        //All segments empty
+        HsmCmdCtxSetSG(&hsmSGPool[idx[0]].sg, NULL, 0, NULL);
+    }
+
+    return &hsmSGPool[idx[0]].sg;
+} //End HsmSGChainAlloc()
+
+
+//******************************************************************************
+// Return the descriptors of a HsmSGChainAlloc() chain to the pool
+// --Only after the HSM command using the chain has completed.
+//******************************************************************************
+void HsmSGChainFree(CmdSGDescriptor * sg)
+{
+    CmdSGDescriptor * next;
+    int               i;
+    int               n;
+    uint32_t          primask;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    for (n = 0; n < HSM_SG_MAX_CHAIN && sg != NULL; n++)
+    {
+        i = HsmSGPoolIndex(sg);
+        if (i < 0) break;
+
+        next = (sg->next.s.stop) ? NULL : HSM_SG_NEXT_PTR(sg);
+        hsmSGPoolUsed &= ~(1u << i);
+        sg = next;
+    }
+    __set_PRIMASK(primask);
+} //End HsmSGChainFree()
+
+
+//******************************************************************************
+// Number of descriptors of a SG chain (up to stop)
+//******************************************************************************
+int HsmSGChainNumDesc(CmdSGDescriptor * sg)
+{
+    int n = 0;
+
+    while (sg != NULL && n < HSM_SG_MAX_CHAIN)
+    {
+        n++;
+        if (sg->next.s.stop) break;
+        sg = HSM_SG_NEXT_PTR(sg);
+    }
+
+    return n;
+} //End HsmSGChainNumDesc()
+
+
+//******************************************************************************
+// Use SG chains as the context command IN/OUT data
+// (req.cmdInputs[0]/[1], after the HsmCmd*Prep() of the command)
+// --NULL:  Keep the context descriptor (dmaIn[0]/dmaOut[0])
+//******************************************************************************
+void HsmSGCtxSet(HsmCmdCtx *       ctx,
+                 CmdSGDescriptor * sgIn,
+                 CmdSGDescriptor * sgOut)
+{
+    if (sgIn  != NULL) ctx->req.cmdInputs[0] = (uint32_t) sgIn;
+    if (sgOut != NULL) ctx->req.cmdInputs[1] = (uint32_t) sgOut;
+} //End HsmSGCtxSet()
+
+
+/* *****************************************************************************
+ End of File
+ */
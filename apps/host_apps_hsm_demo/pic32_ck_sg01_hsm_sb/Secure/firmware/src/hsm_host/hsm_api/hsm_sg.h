@@ -0,0 +1,105 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Microchip Technology
+
+  @File Name
+    hsm_sg.h
+
+  @Summary
+    HSM Scatter/Gather Descriptor Chains
+
+  @Description
+    Builds terminated SG descriptor chains of any length from a list of
+    (addr, numBytes) segments, with the descriptors taken from a pool of
+    cache line aligned descriptors.  A fragmented buffer (e.g. a header and
+    a payload) is given to the HSM without copying it to one buffer:
+
+        HsmSGSegment seg[2] = {{hdr, hdrBytes}, {payload, payloadBytes}};
+
+        sgIn = HsmSGChainAlloc(seg, 2);
+        HsmSGCtxSet(ctx, sgIn, NULL);       //Command IN data chain
+        ...
+        HsmSGChainFree(sgIn);               //After the command completes
+
+    Output segments with addr == NULL are discarded by the HSM DMA.
+ */
+/* ************************************************************************** */
+
+#ifndef _HSM_SG_H    /* Guard against multiple inclusion */
+#define _HSM_SG_H
+
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Included Files                                                    */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "hsm_command.h"
+
+/* Provide C++ Compatibility */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Constants                                                         */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+#define HSM_SG_POOL_DESC   HSM_SG_MAX_CHAIN  //Pool descriptors (<= 32, one bit each)
+#define HSM_SG_ALIGN       16  //CMCC_LINE_SIZE (one descriptor per line)
+
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Data Types
+// *****************************************************************************
+// *****************************************************************************
+
+// Data segment (iovec)
+typedef struct
+{
+    void *   addr;      //NULL: Discard (output chains only)
+    uint32_t numBytes;
+} HsmSGSegment;
+
+// Pool descriptor (a cache line each, so one can be cleaned/invalidated
+// without touching the others)
+typedef struct
+{
+    CmdSGDescriptor sg;
+} __attribute__((aligned(HSM_SG_ALIGN))) HsmSGPoolDesc;
+
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+
+void              HsmSGPoolInit(void);
+int               HsmSGPoolAvail(void);
+CmdSGDescriptor * HsmSGChainAlloc(const HsmSGSegment * seg, int numSeg);
+void              HsmSGChainFree(CmdSGDescriptor * sg);
+int               HsmSGChainNumDesc(CmdSGDescriptor * sg);
+void              HsmSGCtxSet(HsmCmdCtx *       ctx,
+                              CmdSGDescriptor * sgIn,
+                              CmdSGDescriptor * sgOut);
+
+/* Provide C++ Compatibility */
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _HSM_SG_H */
+
+/* *****************************************************************************
+ End of File
+ */
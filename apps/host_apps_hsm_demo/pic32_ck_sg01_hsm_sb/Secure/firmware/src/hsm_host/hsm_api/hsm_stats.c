@@ -0,0 +1,241 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Microchip Technology
+
+  @File Name
+    hsm_stats.c
+
+  @Summary
+    HSM Mailbox Command Latency Statistics
+
+  @Description
+    Submit-to-completion latency of the HSM MB commands measured with the
+    Cortex-M33 DWT cycle counter (CYCCNT).
+ */
+/* ************************************************************************** */
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Included Files                                                    */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+#include <stdlib.h>
+#include <string.h>
+#include "pic32ck2051sg01144.h"
+#include "core_cm33.h"
+#include "user.h"
+#include "hsm_stats.h"
+
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: File Scope or Global Data                                         */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+static HsmStatsEntry     hsmStats[HSM_STATS_MAX_CMDS];
+static int               hsmStatsNumEntries = 0;
+
+//Command in the HSM MB (only one at a time)
+static volatile uint32_t hsmStatsStartCycles = 0;
+static volatile uint16_t hsmStatsKey         = 0;
+static volatile bool     hsmStatsActive      = false;
+
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Local Functions                                                   */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+//******************************************************************************
+// Find (or allocate) the entry of the command group/type key
+// --Returns NULL when all the entries are used by other commands
+//******************************************************************************
+static HsmStatsEntry * HsmStatsFind(uint16_t key)
+{
+    int i;
+
+    for (i = 0; i < hsmStatsNumEntries; i++)
+    {
+        if (hsmStats[i].key == key) return &hsmStats[i];
+    }
+
+    if (hsmStatsNumEntries == HSM_STATS_MAX_CMDS) return NULL;
+
+    hsmStats[i].key       = key;
+    hsmStats[i].minCycles = 0xFFFFFFFF;
+    hsmStatsNumEntries++;
+
+    return &hsmStats[i];
+} //End HsmStatsFind()
+
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Interface Functions                                               */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+//******************************************************************************
+// Enable the DWT cycle counter and clear the statistics
+//******************************************************************************
+void HsmStatsInit(void)
+{
+    DCB->DEMCR |= DCB_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL  |= DWT_CTRL_CYCCNTENA_Msk;
+
+    HsmStatsReset();
+} //End HsmStatsInit()
+
+
+//******************************************************************************
+// Clear the statistics
+//******************************************************************************
+void HsmStatsReset(void)
+{
+    uint32_t primask;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    memset(hsmStats, 0, sizeof(hsmStats));
+    hsmStatsNumEntries = 0;
+    hsmStatsActive     = false;
+    __set_PRIMASK(primask);
+} //End HsmStatsReset()
+
+
+//******************************************************************************
+// Command request written to the HSM MB (called from HsmMbCmdWrite())
+//******************************************************************************
+void HsmStatsStart(uint32_t cmdHeader)
+{
+    hsmStatsKey         = HSM_STATS_KEY(cmdHeader);
+    hsmStatsStartCycles = DWT->CYCCNT;
+    hsmStatsActive      = true;
+} //End HsmStatsStart()
+
+
+//******************************************************************************
+// Command response received (called from HsmCmdRspRead())
+// --Polled or RXINT interrupt context
+//******************************************************************************
+void HsmStatsStop(void)
+{
+    uint32_t        cycles;
+    uint32_t        bin;
+    HsmStatsEntry * entry;
+
+    cycles = DWT->CYCCNT - hsmStatsStartCycles;
+
+    if (!hsmStatsActive) return;
+    hsmStatsActive = false;
+
+    entry = HsmStatsFind(hsmStatsKey);
+    if (entry == NULL) return;
+
+    entry->count++;
+    entry->sumCycles += cycles;
+    if (cycles < entry->minCycles) entry->minCycles = cycles;
+    if (cycles > entry->maxCycles) entry->maxCycles = cycles;
+
+    //log2 bin
+    bin = (cycles == 0) ? 0 : (31 - __CLZ(cycles));
+    entry->hist[bin]++;
+} //End HsmStatsStop()
+
+
+//******************************************************************************
+// Drop the current command latency sample (called from HsmMbSleep())
+// --CYCCNT stops while the core sleeps, so the latency of a command that
+//   slept is not measured:  it is left out of the statistics, the
+//   HSM_MB_WAIT_AUTO estimate and HsmTimeoutCalibrate().
+//******************************************************************************
+void HsmStatsCancel(void)
+{
+    hsmStatsActive = false;
+} //End HsmStatsCancel()
+
+
+//******************************************************************************
+// Number of command group/type entries with statistics
+//******************************************************************************
+int HsmStatsNumEntries(void)
+{
+    return hsmStatsNumEntries;
+} //End HsmStatsNumEntries()
+
+
+//******************************************************************************
+// Statistics entry (NULL if index is not valid)
+//******************************************************************************
+HsmStatsEntry * HsmStatsGetEntry(int index)
+{
+    if (index < 0 || index >= hsmStatsNumEntries) return NULL;
+    return &hsmStats[index];
+} //End HsmStatsGetEntry()
+
+
+//******************************************************************************
+// Mean command latency (cycles)
+//******************************************************************************
+uint32_t HsmStatsMeanCycles(HsmStatsEntry * entry)
+{
+    if (entry->count == 0) return 0;
+    return (uint32_t) (entry->sumCycles / entry->count);
+} //End HsmStatsMeanCycles()
+
+
+//******************************************************************************
+// Expected latency of the command group/type (mean cycles)
+// --Returns 0 if the command has not been measured
+//******************************************************************************
+uint32_t HsmStatsExpectedCycles(uint32_t cmdHeader)
+{
+    uint16_t key = HSM_STATS_KEY(cmdHeader);
+    int      i;
+
+    for (i = 0; i < hsmStatsNumEntries; i++)
+    {
+        if (hsmStats[i].key == key) return HsmStatsMeanCycles(&hsmStats[i]);
+    }
+
+    return 0;
+} //End HsmStatsExpectedCycles()
+
+
+//******************************************************************************
+// Print the statistics (cycles)
+//******************************************************************************
+void HsmStatsPrint(void)
+{
+    int             i;
+    int             bin;
+    HsmStatsEntry * entry;
+
+    SYS_MESSAGE("HSM CMD Latency (cycles):\r\n");
+    for (i = 0; i < hsmStatsNumEntries; i++)
+    {
+        entry = &hsmStats[i];
+        SYS_PRINT("  CMD %02x:%02x n=%ld min=%ld max=%ld mean=%ld\r\n",
+            HSM_STATS_KEY_GROUP(entry->key), HSM_STATS_KEY_TYPE(entry->key),
+            entry->count, entry->minCycles, entry->maxCycles,
+            HsmStatsMeanCycles(entry));
+        for (bin = 0; bin < HSM_STATS_HIST_BINS; bin++)
+        {
+            if (entry->hist[bin] != 0)
+            {
+                SYS_PRINT("    2^%-2d: %ld\r\n", bin, entry->hist[bin]);
+            }
+        }
+    }
+} //End HsmStatsPrint()
+
+
+/* *****************************************************************************
+ End of File
+ */
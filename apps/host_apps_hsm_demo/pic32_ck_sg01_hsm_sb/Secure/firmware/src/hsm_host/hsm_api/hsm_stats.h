@@ -0,0 +1,115 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Microchip Technology
+
+  @File Name
+    hsm_stats.h
+
+  @Summary
+    HSM Mailbox Command Latency Statistics
+
+  @Description
+    Submit-to-completion latency of the HSM MB commands measured with the
+    Cortex-M33 DWT cycle counter (CYCCNT).  Min/max/mean and a log2
+    histogram are kept for each command group/type.
+ */
+/* ************************************************************************** */
+
+#ifndef _HSM_STATS_H    /* Guard against multiple inclusion */
+#define _HSM_STATS_H
+
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Included Files                                                    */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "hsm_command.h"
+
+/* Provide C++ Compatibility */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Constants                                                         */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+//Set to 0 to remove the statistics from the HSM MB command path
+#ifndef HSM_STATS_ENABLE
+#define HSM_STATS_ENABLE     1
+#endif
+
+#define HSM_STATS_MAX_CMDS   16  //Command group/type entries
+#define HSM_STATS_HIST_BINS  32  //Bin n: 2^n <= cycles < 2^(n+1)
+
+//Entry key from the command header: group(7:0) type(15:8)
+#define HSM_STATS_KEY(cmdHeader)  ((uint16_t) ((cmdHeader) & 0xFFFF))
+#define HSM_STATS_KEY_GROUP(key)  ((key) & 0xFF)
+#define HSM_STATS_KEY_TYPE(key)   (((key) >> 8) & 0xFF)
+
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Data Types
+// *****************************************************************************
+// *****************************************************************************
+
+// Latency statistics of one command group/type (cycles)
+typedef struct
+{
+    uint16_t key;        //HSM_STATS_KEY()
+    uint32_t count;
+    uint32_t minCycles;
+    uint32_t maxCycles;
+    uint64_t sumCycles;
+    uint32_t hist[HSM_STATS_HIST_BINS];
+} HsmStatsEntry;
+
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+
+void            HsmStatsInit(void);
+void            HsmStatsReset(void);
+void            HsmStatsStart(uint32_t cmdHeader);
+void            HsmStatsStop(void);
+void            HsmStatsCancel(void);
+int             HsmStatsNumEntries(void);
+HsmStatsEntry * HsmStatsGetEntry(int index);
+uint32_t        HsmStatsMeanCycles(HsmStatsEntry * entry);
+uint32_t        HsmStatsExpectedCycles(uint32_t cmdHeader);
+void            HsmStatsPrint(void);
+
+//HSM MB command path hooks
+#if HSM_STATS_ENABLE
+#define HSM_STATS_START(cmdHeader)  HsmStatsStart(cmdHeader)
+#define HSM_STATS_STOP()            HsmStatsStop()
+#define HSM_STATS_CANCEL()          HsmStatsCancel()
+#else
+#define HSM_STATS_START(cmdHeader)
+#define HSM_STATS_STOP()
+#define HSM_STATS_CANCEL()
+#endif //HSM_STATS_ENABLE
+
+/* Provide C++ Compatibility */
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _HSM_STATS_H */
+
+/* *****************************************************************************
+ End of File
+ */
@@ -0,0 +1,310 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Microchip Technology
+
+  @File Name
+    hsm_timeout.c
+
+  @Summary
+    HSM Mailbox Command Timeouts
+
+  @Description
+    Deadline wait primitive on the DWT cycle counter (CYCCNT) and the per
+    command group/type timeout model.
+ */
+/* ************************************************************************** */
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Included Files                                                    */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+#include <stdlib.h>
+#include <string.h>
+#include "pic32ck2051sg01144.h"
+#include "core_cm33.h"
+#include "user.h"
+#include "hsm_stats.h"
+#include "hsm_timeout.h"
+
+#define HSM_TIMEOUT_NUM_GROUPS  (CMD_DICE + 1)
+
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: File Scope or Global Data                                         */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+//Command group defaults {key(unused), base, per byte}
+//--BOOT self test/firmware load and the VSM NVM writes are the long ones
+static const HsmTimeoutEntry hsmTimeoutGroup[HSM_TIMEOUT_NUM_GROUPS] =
+{
+    [CMD_BOOT]   = {0, HSM_TIMEOUT_MS(1000), 256},
+    [CMD_SDBG]   = {0, HSM_TIMEOUT_MS(100),  64},
+    [CMD_TMPR]   = {0, HSM_TIMEOUT_MS(100),  64},
+    [CMD_VSM]    = {0, HSM_TIMEOUT_MS(500),  4096},
+    [CMD_KEYMGM] = {0, HSM_TIMEOUT_MS(500),  64},
+    [CMD_HASH]   = {0, HSM_TIMEOUT_MS(10),   64},
+    [CMD_AES]    = {0, HSM_TIMEOUT_MS(10),   64},
+    [CMD_CHACHA] = {0, HSM_TIMEOUT_MS(10),   64},
+    [CMD_TDES]   = {0, HSM_TIMEOUT_MS(10),   128},
+    [CMD_DES]    = {0, HSM_TIMEOUT_MS(10),   128},
+    [CMD_RSA]    = {0, HSM_TIMEOUT_MS(2000), 64},
+    [CMD_SIGN]   = {0, HSM_TIMEOUT_MS(1000), 64},
+    [CMD_X509]   = {0, HSM_TIMEOUT_MS(1000), 64},
+    [CMD_DH]     = {0, HSM_TIMEOUT_MS(1000), 64},
+    [CMD_DICE]   = {0, HSM_TIMEOUT_MS(1000), 64},
+};
+
+//Unknown groups (e.g. CMD_MISC)
+static const HsmTimeoutEntry hsmTimeoutDefault = {0, HSM_TIMEOUT_MS(100), 256};
+
+//Calibrated/set command group/type entries
+static HsmTimeoutEntry       hsmTimeout[HSM_TIMEOUT_MAX_CMDS];
+static int                   hsmTimeoutNumEntries = 0;
+
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Local Functions                                                   */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+//******************************************************************************
+// Calibrated/set entry of the command group/type key
+// --alloc == true:  Allocate the entry if not found
+// --Returns NULL if not found (or all the entries are used)
+//******************************************************************************
+static HsmTimeoutEntry * HsmTimeoutFind(uint16_t key, bool alloc)
+{
+    int i;
+
+    for (i = 0; i < hsmTimeoutNumEntries; i++)
+    {
+        if (hsmTimeout[i].key == key) return &hsmTimeout[i];
+    }
+
+    if (!alloc || hsmTimeoutNumEntries == HSM_TIMEOUT_MAX_CMDS) return NULL;
+
+    hsmTimeout[i].key = key;
+    hsmTimeoutNumEntries++;
+
+    return &hsmTimeout[i];
+} //End HsmTimeoutFind()
+
+
+//******************************************************************************
+// Timeout model of the command group/type key
+//******************************************************************************
+static const HsmTimeoutEntry * HsmTimeoutModel(uint16_t key)
+{
+    HsmTimeoutEntry * entry;
+    uint8_t           group = HSM_STATS_KEY_GROUP(key);
+
+    entry = HsmTimeoutFind(key, false);
+    if (entry != NULL) return entry;
+
+    if (group < HSM_TIMEOUT_NUM_GROUPS) return &hsmTimeoutGroup[group];
+
+    return &hsmTimeoutDefault;
+} //End HsmTimeoutModel()
+
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Interface Functions                                               */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+//******************************************************************************
+// Start a deadline of cycles (CYCCNT)
+//******************************************************************************
+void HsmDeadlineStart(HsmDeadline * deadline, uint32_t cycles)
+{
+    deadline->startCycles = DWT->CYCCNT;
+    deadline->cycles      = cycles;
+    deadline->sleptCycles = 0;
+} //End HsmDeadlineStart()
+
+
+//******************************************************************************
+// Deadline expired
+// --Unsigned elapsed cycles, so CYCCNT wrap around is handled for deadlines
+//   up to HSM_TIMEOUT_MAX_CYCLES.
+//******************************************************************************
+bool HsmDeadlineExpired(HsmDeadline * deadline)
+{
+    return (HsmDeadlineRemaining(deadline) == 0);
+} //End HsmDeadlineExpired()
+
+
+//******************************************************************************
+// Cycles left to the deadline (0 when expired)
+// --Counts the CYCCNT cycles and the cycles slept (HsmDeadlineSlept())
+//******************************************************************************
+uint32_t HsmDeadlineRemaining(HsmDeadline * deadline)
+{
+    uint32_t elapsed = DWT->CYCCNT - deadline->startCycles;
+
+    if (elapsed >= deadline->cycles) return 0;
+    if (deadline->sleptCycles >= deadline->cycles - elapsed) return 0;
+    return deadline->cycles - elapsed - deadline->sleptCycles;
+} //End HsmDeadlineRemaining()
+
+
+//******************************************************************************
+// Add the cycles the core slept (CYCCNT stopped) to the deadline
+//******************************************************************************
+void HsmDeadlineSlept(HsmDeadline * deadline, uint32_t cycles)
+{
+    if (cycles > HSM_TIMEOUT_MAX_CYCLES - deadline->sleptCycles)
+    {
+        cycles = HSM_TIMEOUT_MAX_CYCLES - deadline->sleptCycles;
+    }
+    deadline->sleptCycles += cycles;
+} //End HsmDeadlineSlept()
+
+
+//******************************************************************************
+// Enable the DWT cycle counter and clear the calibrated timeouts
+// (group defaults)
+//******************************************************************************
+void HsmTimeoutInit(void)
+{
+    DCB->DEMCR |= DCB_DEMCR_TRCENA_Msk;
+    DWT->CTRL  |= DWT_CTRL_CYCCNTENA_Msk;
+
+    memset(hsmTimeout, 0, sizeof(hsmTimeout));
+    hsmTimeoutNumEntries = 0;
+} //End HsmTimeoutInit()
+
+
+//******************************************************************************
+// Command timeout (cycles)
+// --numBytes:  Command IN + OUT data bytes
+//******************************************************************************
+uint32_t HsmTimeoutCycles(uint32_t cmdHeader, uint32_t numBytes)
+{
+    const HsmTimeoutEntry * model;
+    uint64_t                cycles;
+
+    model  = HsmTimeoutModel(HSM_STATS_KEY(cmdHeader));
+    cycles = (uint64_t) model->baseCycles +
+             (uint64_t) model->perByteCycles * numBytes;
+
+    if (cycles > HSM_TIMEOUT_MAX_CYCLES) cycles = HSM_TIMEOUT_MAX_CYCLES;
+
+    return (uint32_t) cycles;
+} //End HsmTimeoutCycles()
+
+
+//******************************************************************************
+// Number of data bytes of a SG descriptor chain (sg can be NULL)
+//******************************************************************************
+uint32_t HsmTimeoutSGBytes(CmdSGDescriptor * sg)
+{
+    uint32_t numBytes = 0;
+    int      i;
+
+    for (i = 0; i < HSM_SG_MAX_CHAIN && sg != NULL; i++)
+    {
+        numBytes += sg->flagsLength.s.length;
+        if (sg->next.s.stop) break;
+        sg = HSM_SG_NEXT_PTR(sg);
+    }
+
+    return numBytes;
+} //End HsmTimeoutSGBytes()
+
+
+//******************************************************************************
+// Command request timeout (cycles)
+// --Payload from the IN (cmdInputs[0]) and OUT (cmdInputs[1]) SG chains
+//******************************************************************************
+uint32_t HsmTimeoutCmdCycles(HsmCmdReq * cmdReq)
+{
+    uint32_t numBytes;
+
+    numBytes  = HsmTimeoutSGBytes((CmdSGDescriptor *) cmdReq->cmdInputs[0]);
+    numBytes += HsmTimeoutSGBytes((CmdSGDescriptor *) cmdReq->cmdInputs[1]);
+
+    return HsmTimeoutCycles(cmdReq->cmdHeader, numBytes);
+} //End HsmTimeoutCmdCycles()
+
+
+//******************************************************************************
+// Set the timeout model of a command group/type
+//******************************************************************************
+void HsmTimeoutSet(uint32_t cmdHeader,
+                   uint32_t baseCycles,
+                   uint32_t perByteCycles)
+{
+    HsmTimeoutEntry * entry;
+
+    entry = HsmTimeoutFind(HSM_STATS_KEY(cmdHeader), true);
+    if (entry == NULL) return;
+
+    entry->baseCycles    = baseCycles;
+    entry->perByteCycles = perByteCycles;
+} //End HsmTimeoutSet()
+
+
+//******************************************************************************
+// Calibrate the command timeouts from the HSM command latency statistics
+// --base = HSM_TIMEOUT_MARGIN * max latency (>= HSM_TIMEOUT_MIN_CYCLES) for
+//   the command types with at least HSM_TIMEOUT_MIN_SAMPLES.  The max latency
+//   includes the payload of the measured commands, the per byte cycles of
+//   the group are kept for longer payloads.
+// --Returns the number of calibrated command types
+//******************************************************************************
+int HsmTimeoutCalibrate(void)
+{
+    HsmStatsEntry *         stats;
+    const HsmTimeoutEntry * model;
+    uint64_t                base;
+    int                     numCal = 0;
+    int                     i;
+
+    for (i = 0; i < HsmStatsNumEntries(); i++)
+    {
+        stats = HsmStatsGetEntry(i);
+        if (stats->count < HSM_TIMEOUT_MIN_SAMPLES) continue;
+
+        base = (uint64_t) stats->maxCycles * HSM_TIMEOUT_MARGIN;
+        if (base < HSM_TIMEOUT_MIN_CYCLES) base = HSM_TIMEOUT_MIN_CYCLES;
+        if (base > HSM_TIMEOUT_MAX_CYCLES) base = HSM_TIMEOUT_MAX_CYCLES;
+
+        model = HsmTimeoutModel(stats->key);
+        HsmTimeoutSet(stats->key, (uint32_t) base, model->perByteCycles);
+        numCal++;
+    }
+
+    return numCal;
+} //End HsmTimeoutCalibrate()
+
+
+//******************************************************************************
+// Print the calibrated/set command timeouts (cycles)
+//******************************************************************************
+void HsmTimeoutPrint(void)
+{
+    int i;
+
+    SYS_MESSAGE("HSM CMD Timeouts (cycles):\r\n");
+    for (i = 0; i < hsmTimeoutNumEntries; i++)
+    {
+        SYS_PRINT("  CMD %02x:%02x base=%ld perByte=%ld\r\n",
+            HSM_STATS_KEY_GROUP(hsmTimeout[i].key),
+            HSM_STATS_KEY_TYPE(hsmTimeout[i].key),
+            hsmTimeout[i].baseCycles, hsmTimeout[i].perByteCycles);
+    }
+} //End HsmTimeoutPrint()
+
+
+/* *****************************************************************************
+ End of File
+ */
@@ -0,0 +1,125 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Microchip Technology
+
+  @File Name
+    hsm_timeout.h
+
+  @Summary
+    HSM Mailbox Command Timeouts
+
+  @Description
+    Deadline wait primitive on the DWT cycle counter (CYCCNT) and the per
+    command group/type timeout model:
+
+        timeout = baseCycles + perByteCycles * (IN + OUT SG bytes)
+
+    The group defaults are conservative.  HsmTimeoutCalibrate() replaces the
+    base of each command type with the worst case latency measured by the
+    HSM command statistics (hsm_stats.c) times HSM_TIMEOUT_MARGIN.
+ */
+/* ************************************************************************** */
+
+#ifndef _HSM_TIMEOUT_H    /* Guard against multiple inclusion */
+#define _HSM_TIMEOUT_H
+
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Included Files                                                    */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "hsm_command.h"
+
+/* Provide C++ Compatibility */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Constants                                                         */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+//CPU_CLOCK_FREQUENCY (definitions.h)
+#ifndef HSM_TIMEOUT_CPU_HZ
+#define HSM_TIMEOUT_CPU_HZ      120000000
+#endif
+
+#define HSM_TIMEOUT_MS(ms)      ((uint32_t) (ms) * (HSM_TIMEOUT_CPU_HZ / 1000))
+
+//Longest deadline (CYCCNT wraps at 2^32, ~35s at 120MHz)
+#define HSM_TIMEOUT_MAX_CYCLES  0x7FFFFFFF
+
+//HSM not BUSY wait before a command is sent (HSMBUSYERR)
+#define HSM_TIMEOUT_IDLE_CYCLES HSM_TIMEOUT_MS(2000)
+
+#define HSM_TIMEOUT_MAX_CMDS    16  //Calibrated command group/type entries
+#define HSM_TIMEOUT_MIN_SAMPLES 4   //Statistics samples needed to calibrate
+#define HSM_TIMEOUT_MARGIN      4   //Calibrated base = margin * max latency
+#define HSM_TIMEOUT_MIN_CYCLES  HSM_TIMEOUT_MS(1)
+
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Data Types
+// *****************************************************************************
+// *****************************************************************************
+
+// Deadline (CYCCNT)
+// --CYCCNT stops while the core sleeps: the sleep time measured on a clock
+//   that keeps running (see HsmMbSleep()) is added with HsmDeadlineSlept()
+typedef struct
+{
+    uint32_t startCycles;
+    uint32_t cycles;
+    uint32_t sleptCycles;
+} HsmDeadline;
+
+// Timeout model of one command group/type (cycles)
+typedef struct
+{
+    uint16_t key;            //HSM_STATS_KEY()
+    uint32_t baseCycles;
+    uint32_t perByteCycles;
+} HsmTimeoutEntry;
+
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+
+void     HsmDeadlineStart(HsmDeadline * deadline, uint32_t cycles);
+bool     HsmDeadlineExpired(HsmDeadline * deadline);
+uint32_t HsmDeadlineRemaining(HsmDeadline * deadline);
+void     HsmDeadlineSlept(HsmDeadline * deadline, uint32_t cycles);
+
+void     HsmTimeoutInit(void);
+uint32_t HsmTimeoutCycles(uint32_t cmdHeader, uint32_t numBytes);
+uint32_t HsmTimeoutCmdCycles(HsmCmdReq * cmdReq);
+uint32_t HsmTimeoutSGBytes(CmdSGDescriptor * sg);
+void     HsmTimeoutSet(uint32_t cmdHeader,
+                       uint32_t baseCycles,
+                       uint32_t perByteCycles);
+int      HsmTimeoutCalibrate(void);
+void     HsmTimeoutPrint(void);
+
+/* Provide C++ Compatibility */
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _HSM_TIMEOUT_H */
+
+/* *****************************************************************************
+ End of File
+ */
@@ -0,0 +1,176 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Microchip Technology
+
+  @File Name
+    hsm_trace.c
+
+  @Summary
+    HSM Mailbox Binary Trace
+
+  @Description
+    RAM ring buffer of binary trace records.  Timestamps are the DWT CYCCNT
+    (enabled by HsmStatsInit()).
+ */
+/* ************************************************************************** */
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Included Files                                                    */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+#include <stdlib.h>
+#include <string.h>
+#include "pic32ck2051sg01144.h"
+#include "core_cm33.h"
+#include "user.h"
+#include "hsm_trace.h"
+
+#define HSM_TRACE_MASK          (HSM_TRACE_RECORDS - 1)
+#define HSM_TRACE_PRINT_RECORDS 8 //Records per HsmTracePrint() line
+
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: File Scope or Global Data                                         */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+static HsmTraceRecord    hsmTrace[HSM_TRACE_RECORDS];
+static volatile uint32_t hsmTraceHead = 0; //Next record to write
+static uint32_t          hsmTraceTail = 0; //Next record to read
+static uint32_t          hsmTraceLost = 0; //Overwritten before read
+
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+// Section: Interface Functions                                               */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+//******************************************************************************
+// Clear the trace buffer
+//******************************************************************************
+void HsmTraceInit(void)
+{
+    uint32_t primask;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    memset(hsmTrace, 0, sizeof(hsmTrace));
+    hsmTraceHead = 0;
+    hsmTraceTail = 0;
+    hsmTraceLost = 0;
+    __set_PRIMASK(primask);
+} //End HsmTraceInit()
+
+
+//******************************************************************************
+// Write a trace record (overwrites the oldest record when full)
+// --Called from the polled and the RXINT interrupt command paths
+//******************************************************************************
+void HsmTraceEvent(HsmTraceId id,
+                   uint32_t a0, uint32_t a1, uint32_t a2, uint32_t a3)
+{
+    HsmTraceRecord * rec;
+    uint32_t         primask;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    rec = &hsmTrace[hsmTraceHead & HSM_TRACE_MASK];
+    rec->timestamp = DWT->CYCCNT;
+    rec->id        = (uint16_t) id;
+    rec->seq       = (uint16_t) hsmTraceHead;
+    rec->arg[0]    = a0;
+    rec->arg[1]    = a1;
+    rec->arg[2]    = a2;
+    rec->arg[3]    = a3;
+    hsmTraceHead++;
+    __set_PRIMASK(primask);
+} //End HsmTraceEvent()
+
+
+//******************************************************************************
+// Copy out the records written since the last read (oldest first)
+// --Returns the number of records copied (<= maxRecords)
+//******************************************************************************
+int HsmTraceRead(HsmTraceRecord * records, int maxRecords)
+{
+    int      n = 0;
+    uint32_t primask;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+
+    //Skip the overwritten records
+    if ((hsmTraceHead - hsmTraceTail) > HSM_TRACE_RECORDS)
+    {
+        hsmTraceLost += (hsmTraceHead - hsmTraceTail) - HSM_TRACE_RECORDS;
+        hsmTraceTail  = hsmTraceHead - HSM_TRACE_RECORDS;
+    }
+
+    while (hsmTraceTail != hsmTraceHead && n < maxRecords)
+    {
+        records[n++] = hsmTrace[hsmTraceTail & HSM_TRACE_MASK];
+        hsmTraceTail++;
+    }
+    __set_PRIMASK(primask);
+
+    return n;
+} //End HsmTraceRead()
+
+
+//******************************************************************************
+// Number of records overwritten before they were read
+//******************************************************************************
+uint32_t HsmTraceLost(void)
+{
+    return hsmTraceLost;
+} //End HsmTraceLost()
+
+
+//******************************************************************************
+// Print the records written since the last read (console, oldest first)
+// --One "TRACE(<#records><#lost><HsmTraceRecord>...)" line per
+//   HSM_TRACE_PRINT_RECORDS records, the bytes in hex (little endian).  The
+//   last line has 0 records.  Decode the saved console output on the host
+//   with hsm_host/utilities/hsm_trace/hsm_trace_decode.c.
+//******************************************************************************
+void HsmTracePrint(void)
+{
+    HsmTraceRecord  records[HSM_TRACE_PRINT_RECORDS];
+    uint32_t        header[2];
+    const uint8_t * bytes;
+    uint32_t        numBytes;
+    uint32_t        i;
+    int             numRecords;
+
+    do
+    {
+        numRecords = HsmTraceRead(records, HSM_TRACE_PRINT_RECORDS);
+        header[0]  = (uint32_t) numRecords;
+        header[1]  = HsmTraceLost();
+
+        SYS_MESSAGE("TRACE(");
+        bytes = (const uint8_t *) header;
+        for (i = 0; i < sizeof(header); i++)
+        {
+            SYS_PRINT("%02x", bytes[i]);
+        }
+        bytes    = (const uint8_t *) records;
+        numBytes = (uint32_t) numRecords * sizeof(HsmTraceRecord);
+        for (i = 0; i < numBytes; i++)
+        {
+            SYS_PRINT("%02x", bytes[i]);
+        }
+        SYS_MESSAGE(")\r\n");
+    } while (numRecords != 0);
+} //End HsmTracePrint()
+
+
+/* *****************************************************************************
+ End of File
+ */
@@ -0,0 +1,132 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Microchip Technology
+
+  @File Name
+    hsm_trace.h
+
+  @Summary
+    HSM Mailbox Binary Trace
+
+  @Description
+    Fixed size binary event records (timestamp, event id and up to 4 words)
+    written to a RAM ring buffer from the HSM MB command path.  The records
+    are not decoded on the target; HsmTracePrint() dumps them to the console
+    in hex for hsm_host/utilities/hsm_trace/hsm_trace_decode.c (host).
+ */
+/* ************************************************************************** */
+
+#ifndef _HSM_TRACE_H    /* Guard against multiple inclusion */
+#define _HSM_TRACE_H
+
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Included Files                                                    */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Provide C++ Compatibility */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* ************************************************************************** */
+/* ************************************************************************** */
+/* Section: Constants                                                         */
+/* ************************************************************************** */
+/* ************************************************************************** */
+
+//Set to 0 to remove the trace from the HSM MB command path
+#ifndef HSM_TRACE_ENABLE
+#define HSM_TRACE_ENABLE     1
+#endif
+
+#define HSM_TRACE_RECORDS    128 //Ring buffer records (power of 2)
+#define HSM_TRACE_ARGS       4   //Words per record
+
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Data Types
+// *****************************************************************************
+// *****************************************************************************
+
+// Trace Event IDs
+// --Host trace decoders depend on these values
+typedef enum _HsmTraceId
+{
+    HSM_TRACE_NONE      = 0,
+    HSM_TRACE_MB_STATUS = 1, //tag, MBRXSTATUS, MBTXSTATUS, STATUS
+    HSM_TRACE_TX_CMD    = 2, //MB header, CMD header, IN, OUT
+    HSM_TRACE_TX_PARAM  = 3, //param index, param
+    HSM_TRACE_RX_RSP    = 4, //MB header, CMD header, result code, #words
+    HSM_TRACE_CMD_ERR   = 5, //result code, STATUS
+    HSM_TRACE_RSP_CHK   = 6, //CMD header, result code, STATUS, fail mask
+    HSM_TRACE_RSP_DATA  = 7, //result data words
+} HsmTraceId;
+
+// HSM_TRACE_MB_STATUS tag (SendHsmCommandRequest() step)
+#define HSM_TRACE_TAG_T0   0  //Before the command
+#define HSM_TRACE_TAG_T1   1  //HSM not busy
+#define HSM_TRACE_TAG_TC   2  //Command written
+#define HSM_TRACE_TAG_TF   3  //Command complete
+
+// HSM_TRACE_RSP_CHK fail mask (HsmCmdRspChkr())
+#define HSM_TRACE_CHK_MBHEADER   0x01
+#define HSM_TRACE_CHK_CMDHEADER  0x02
+#define HSM_TRACE_CHK_RC         0x04
+#define HSM_TRACE_CHK_STATUS     0x08
+#define HSM_TRACE_CHK_INTFLAG    0x10
+
+// Trace Record (24 bytes, little endian)
+typedef struct
+{
+    uint32_t timestamp;             //DWT CYCCNT
+    uint16_t id;                    //HsmTraceId
+    uint16_t seq;                   //Record sequence number
+    uint32_t arg[HSM_TRACE_ARGS];
+} HsmTraceRecord;
+
+
+// *****************************************************************************
+// *****************************************************************************
+// Section: Interface Functions
+// *****************************************************************************
+// *****************************************************************************
+
+void     HsmTraceInit(void);
+void     HsmTraceEvent(HsmTraceId id,
+                       uint32_t a0, uint32_t a1, uint32_t a2, uint32_t a3);
+int      HsmTraceRead(HsmTraceRecord * records, int maxRecords);
+uint32_t HsmTraceLost(void);
+void     HsmTracePrint(void);
+
+//HSM MB command path hook
+#if HSM_TRACE_ENABLE
+#define HSM_TRACE(id, a0, a1, a2, a3) \
+    HsmTraceEvent((id), (uint32_t) (a0), (uint32_t) (a1), \
+                  (uint32_t) (a2), (uint32_t) (a3))
+#else
+//Arguments still evaluated (no unused variable warnings, e.g. the MB status
+//reads of SendHsmCommandRequest())
+#define HSM_TRACE(id, a0, a1, a2, a3) \
+    ((void) (id), (void) (a0), (void) (a1), (void) (a2), (void) (a3))
+#endif //HSM_TRACE_ENABLE
+
+/* Provide C++ Compatibility */
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _HSM_TRACE_H */
+
+/* *****************************************************************************
+ End of File
+ */
@@ -23,6 +23,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdint.h>
+#include <string.h>
 #include "pic32ck2051sg01144.h"
 #include "core_cm33.h"
 #include "user.h"
@@ -70,6 +71,17 @@ char * VssSymmetricalKeyTypeStr[] = {
     "VSS_SK_DES",
 };
 
+//Slot metadata cache (HsmCmdVsmGetSlotInfoCachedCtx())
+//--Indexed by the slot number, MINSLOTNUM/MAXSLOTNUM are never cached 
+typedef enum {
+    VSM_SLOT_CACHE_UNKNOWN = 0, //Not read since the last change (or boot)
+    VSM_SLOT_CACHE_VALID,       //vsmSlotCache[] is the slot metadata
+    VSM_SLOT_CACHE_EMPTY        //E_VSEMPTY
+} VsmSlotCacheState;
+
+static VSMetaData vsmSlotCache[MAXSLOTNUM + 1];
+static uint8_t    vsmSlotCacheState[MAXSLOTNUM + 1];
+
 
 /* ************************************************************************** */
 /* ************************************************************************** */
@@ -80,95 +92,173 @@ char * VssSymmetricalKeyTypeStr[] = {
 //******************************************************************************
 // CMD_VSM_INPUT_DATA - Unencrypted VSS Internal Slot Input Command--
 //
-// NOTE:  APL=0, No Auth, Unencrypted Slot, NVM_Unencrypted Storage Type 
+// NOTE:  APL=0, No Auth, Unencrypted Slot
 //
+// --storageType:  NVM_UNENCRYPTED or VM_STORAGE (volatile, lost on HSM reset)
+// --Build the command request in ctx only (not sent, see HsmCmdBankSubmit())
 //******************************************************************************
 
-RSP_DATA * HsmCmdVsmInputDataUnencrypted(
+RSP_DATA * HsmCmdVsmInputDataUnencryptedStoragePrep(
+        HsmCmdCtx * ctx,
         int vssSlotNum,
         uint32_t * vsmInputDataPtr, //including meta
         unsigned short numSlotWords,
         CmdVSMSlotType slotType,
-        CmdVSMDataSpecificMetaData specMetaData) {
+        CmdVSMDataSpecificMetaData specMetaData,
+        VSStorageType storageType) {
     CmdVSMInputSlotInfoParameter1 vsmInputParam1;
-    RSP_DATA * rsp = &gRspData;
+    RSP_DATA * rsp = &ctx->rspData;
     //VSHeader *                    vsHeaderPtr;
 
-    // Reset the response checker global variable
-    rsp->invArgs = false;
-    rsp->rspChksPassed = false;
+    // Reset the response checker
+    HsmCmdCtxInit(ctx);
     rsp->resultCode = S_OK;
-    rsp->testFailCnt = 0;
-
-    // Make sure the HSM is not busy
-    while (HSM_REGS->HSM_STATUS & HSM_STATUS_BUSY_Msk);
 
-    //Send CMD_VSM_INPUT_DATA - Input Clear Data
+    //CMD_VSM_INPUT_DATA - Input Clear Data
     //--No TA/No Slot/No Auth
-    gHsmCmdReq.mbHeader = 0x00f00014; //5 Words
-    gHsmCmdReq.cmdHeader = CMD_VSM_INPUT_DATA_INST; //CMD_VSM_INPUT_DATA
-    gHsmCmdReq.cmdInputs[0] = (uint32_t) (&(dmaDescriptorIn[0]));
-    gHsmCmdReq.cmdInputs[1] = 0x00000000; //OUT: Unused
+    ctx->req.mbHeader = 0x00f00014; //5 Words
+    ctx->req.cmdHeader = CMD_VSM_INPUT_DATA_INST; //CMD_VSM_INPUT_DATA
+    ctx->req.cmdInputs[1] = 0x00000000; //OUT: Unused
 
     vsmInputParam1.v = 0;
     vsmInputParam1.s.slotInfo = CMD_VSM_NOT_ENCRYPTED;
     vsmInputParam1.s.slotNumber = vssSlotNum;
     vsmInputParam1.s.slotType = slotType; //Sym/Asym/hash/iv
     vsmInputParam1.s.vsStorageData.s.apl = 0; //Only storage that is unencrypt. 
-    vsmInputParam1.s.vsStorageData.s.storageType = NVM_UNENCRYPTED;
+    vsmInputParam1.s.vsStorageData.s.storageType = storageType;
     //TODO: vsStorageData HSMonly/ext/valid
 
-    gHsmCmdReq.cmdInputs[2] = vsmInputParam1.v;
+    ctx->req.cmdInputs[2] = vsmInputParam1.v;
     //SYS_PRINT("XXCMD INP[2]: 0x%08lx, VS#%d\r\n",
-    //           gHsmCmdReq.cmdInputs[2], vssSlotNum);
+    //           ctx->req.cmdInputs[2], vssSlotNum);
 
-    gHsmCmdReq.cmdInputs[3] = 0x00000000; //(unused)
+    ctx->req.cmdInputs[3] = 0x00000000; //(unused)
+
+    //Slot metadata changes (HSM assigned header fields are read back on the
+    //next lookup)
+    HsmCmdVsmSlotCacheInvalidate(vssSlotNum);
 
     //Input SG for Key Block Data
-    dmaDescriptorIn[0].data.addr = vsmInputDataPtr;
-    dmaDescriptorIn[0].next.s.stop = 1;
-    dmaDescriptorIn[0].next.s.addr = 0;
-    dmaDescriptorIn[0].flagsLength.s.length =
-            (unsigned int) (numSlotWords + 1) * BYTES_PER_WORD;
-    dmaDescriptorIn[0].flagsLength.s.cstAddr = 0;
-    dmaDescriptorIn[0].flagsLength.s.discard = 0;
-    dmaDescriptorIn[0].flagsLength.s.realign = 1;
-    dmaDescriptorIn[0].flagsLength.s.intEn = 0;
+    HsmCmdCtxSetSG(&ctx->dmaIn[0], vsmInputDataPtr,
+                   (numSlotWords + 1) * BYTES_PER_WORD, NULL);
     //SYS_MESSAGE("VSM INPUT DATA SG:\r\n");
-    //PrintSG(dmaDescriptorIn[0], true);
+    //PrintSG(ctx->dmaIn[0], true);
 
     //Output (Not Used)
-    dmaDescriptorOut[0].data.addr = &dummy32;
-    dmaDescriptorOut[0].next.s.stop = 1;
-    dmaDescriptorOut[0].next.s.addr = 0;
-    dmaDescriptorOut[0].flagsLength.s.length = 1;
-    dmaDescriptorOut[0].flagsLength.s.cstAddr = 0;
-    dmaDescriptorOut[0].flagsLength.s.discard = 0;
-    dmaDescriptorOut[0].flagsLength.s.realign = 1;
-    dmaDescriptorOut[0].flagsLength.s.intEn = 0;
+    HsmCmdCtxSetSG(&ctx->dmaOut[0], &dummy32, 1, NULL);
 
     //Expected Response 
-    gHsmCmdReq.expMbHeader = 0x0020000c;
-    gHsmCmdReq.expResultCode = S_OK;
-    gHsmCmdReq.expStatus = 0x00000320;
-    gHsmCmdReq.expIntFlag = 0x00000000;
-    gHsmCmdReq.expData = 0x00000000;
-    gHsmCmdReq.expNumDataBytes = 0;
-
-    //SCB_CleanDCache_by_Addr((uint32_t *)           dmaDescriptorIn,  sizeof(dmaDescriptorIn));
-    // SCB_CleanDCache_by_Addr((uint32_t *)           dmaDescriptorOut, sizeof(dmaDescriptorOut));
-    // SCB_CleanInvalidateDCache_by_Addr((uint32_t *) dummy32,          sizeof(uint32_t));
-    //  SCB_CleanInvalidateDCache_by_Addr((uint32_t *) vsmInputDataPtr,  numSlotWords*sizeof(uint32_t));
+    ctx->req.expMbHeader = 0x0020000c;
+    ctx->req.expResultCode = S_OK;
+    ctx->req.expStatus = 0x00000320;
+    ctx->req.expIntFlag = 0x00000000;
+    ctx->req.expData = 0x00000000;
+    ctx->req.expNumDataBytes = 0;
+
+    //Data cache: HsmDmaCmdPrepare()/HsmDmaCmdComplete() (hsm_dma.c)
+
+    return rsp;
+
+} //End HsmCmdVsmInputDataUnencryptedStoragePrep()
+
+
+//******************************************************************************
+// CMD_VSM_INPUT_DATA - Unencrypted VSS Internal Slot Input Command--
+//
+// NOTE:  APL=0, No Auth, Unencrypted Slot, NVM_Unencrypted Storage Type 
+//
+// --Build the command request in ctx only (not sent, see HsmCmdBankSubmit())
+//******************************************************************************
+
+RSP_DATA * HsmCmdVsmInputDataUnencryptedPrep(
+        HsmCmdCtx * ctx,
+        int vssSlotNum,
+        uint32_t * vsmInputDataPtr, //including meta
+        unsigned short numSlotWords,
+        CmdVSMSlotType slotType,
+        CmdVSMDataSpecificMetaData specMetaData) {
+    return HsmCmdVsmInputDataUnencryptedStoragePrep(ctx, vssSlotNum,
+            vsmInputDataPtr, numSlotWords, slotType, specMetaData,
+            NVM_UNENCRYPTED);
+} //End HsmCmdVsmInputDataUnencryptedPrep()
+
+
+//******************************************************************************
+// CMD_VSM_INPUT_DATA - Unencrypted VSS Internal Slot Input Command--
+//
+// NOTE:  APL=0, No Auth, Unencrypted Slot
+//
+// --storageType:  NVM_UNENCRYPTED or VM_STORAGE (volatile, lost on HSM reset)
+// --Command context variant (ctx->rspData has the response check results)
+//******************************************************************************
+
+RSP_DATA * HsmCmdVsmInputDataUnencryptedStorageCtx(
+        HsmCmdCtx * ctx,
+        int vssSlotNum,
+        uint32_t * vsmInputDataPtr, //including meta
+        unsigned short numSlotWords,
+        CmdVSMSlotType slotType,
+        CmdVSMDataSpecificMetaData specMetaData,
+        VSStorageType storageType) {
+    RSP_DATA * rsp;
+
+    rsp = HsmCmdVsmInputDataUnencryptedStoragePrep(ctx, vssSlotNum, 
+            vsmInputDataPtr, numSlotWords, slotType, specMetaData, 
+            storageType);
 
     //SYS_PRINT("HSM: Sending CMD_VSM_INPUT_DATA Command\r\n");
-    HsmMbCmdDriver(&gHsmCmdReq, false);
+    HsmCmdCtxExec(ctx);
+
+    HsmCmdCtxRspChkr(ctx, true);
 
-    HsmCmdRspChkr(rsp, true);
+    //Lookups between the Prep and the response may have cached the old slot
+    HsmCmdVsmSlotCacheInvalidate(vssSlotNum);
 
     return rsp;
 
+} //End HsmCmdVsmInputDataUnencryptedStorageCtx()
+
+
+//******************************************************************************
+// CMD_VSM_INPUT_DATA - Unencrypted VSS Internal Slot Input Command--
+//
+// NOTE:  APL=0, No Auth, Unencrypted Slot, NVM_Unencrypted Storage Type 
+//
+// --Command context variant (ctx->rspData has the response check results)
+//******************************************************************************
+
+RSP_DATA * HsmCmdVsmInputDataUnencryptedCtx(
+        HsmCmdCtx * ctx,
+        int vssSlotNum,
+        uint32_t * vsmInputDataPtr, //including meta
+        unsigned short numSlotWords,
+        CmdVSMSlotType slotType,
+        CmdVSMDataSpecificMetaData specMetaData) {
+    return HsmCmdVsmInputDataUnencryptedStorageCtx(ctx, vssSlotNum,
+            vsmInputDataPtr, numSlotWords, slotType, specMetaData,
+            NVM_UNENCRYPTED);
+} //End HsmCmdVsmInputDataUnencryptedCtx()
+
+
+//******************************************************************************
+// CMD_VSM_INPUT_DATA - Unencrypted VSS Internal Slot Input Command--
+//
+// NOTE:  APL=0, No Auth, Unencrypted Slot, NVM_Unencrypted Storage Type 
+//
+//******************************************************************************
+
+RSP_DATA * HsmCmdVsmInputDataUnencrypted(
+        int vssSlotNum,
+        uint32_t * vsmInputDataPtr, //including meta
+        unsigned short numSlotWords,
+        CmdVSMSlotType slotType,
+        CmdVSMDataSpecificMetaData specMetaData) {
+    HsmCmdVsmInputDataUnencryptedCtx(&gHsmCmdCtx, vssSlotNum, 
+            vsmInputDataPtr, numSlotWords, slotType, specMetaData);
+    return HsmCmdCtxPublish(&gHsmCmdCtx);
 } //End HsmCmdVsmInputDataUnencrypted()
 
+
 //******************************************************************************
 //CMD_VSM_OUTPUT_DATA Unencrypted Internal Slot Output Data Command--
 //
@@ -181,23 +271,24 @@ RSP_DATA * HsmCmdVsmInputDataUnencrypted(
 //       SS(15:08) Storage Slot# -- VS# where data stored
 //       0O(07-00) Output Type   -- UNEN|ENCR|WRAPPED
 //
+// --Command context variant (ctx->rspData has the response check results, 
+//   ctx->rsp.resultData[0] the slot size)
 //******************************************************************************
 
-RSP_DATA * HsmCmdVsmOutputDataUnencrypted(
+RSP_DATA * HsmCmdVsmOutputDataUnencryptedCtx(
+        HsmCmdCtx * ctx,
         int vssSlotNum,
         uint32_t * dataOut,
         int * numDataWords,
         uint32_t maxDataBytes) {
-    RSP_DATA * rsp = &gRspData;
+    RSP_DATA * rsp = &ctx->rspData;
     //VSMetaData vsMetaData;
     CmdVSMOutputSlotParameter1 vssOutputParam1;
     CmdResultCodes __attribute__((unused)) rcode;
     uint32_t __attribute__((unused)) slotInfoBytes;
 
     //Reset the response 
-    rsp->invArgs = false;
-    rsp->rspChksPassed = false;
-    rsp->testFailCnt = 0;
+    HsmCmdCtxInit(ctx);
     rsp->resultCode = S_OK;
 
     vssOutputParam1.v = 0x00000000;
@@ -205,15 +296,19 @@ RSP_DATA * HsmCmdVsmOutputDataUnencrypted(
     vssOutputParam1.s.slotNumber = (uint8_t) vssSlotNum;
     vssOutputParam1.s.slotInfo = CMD_VSM_NOT_ENCRYPTED;
 
-    // Make sure the HSM is not busy
-    while (HSM_REGS->HSM_STATUS & HSM_STATUS_BUSY_Msk);
     //SYS_PRINT("HSM: CMD_VSM_OUTPUT_DATA Slot %d Command\r\n", vssSlotNum);
 
 #undef USEVSINFO
 #ifdef USEVSINFO 
     //Check Slot Info 
     //SYS_PRINT("VSM Get Slot Info Slot#%d\r\n",vssSlotNum);
-    rcode = HsmCmdVsmGetSlotInfo(vssSlotNum, &vsMetaData, &slotInfoBytes);
+    {
+        HsmCmdCtx  slotCtx;
+        VSMetaData vsMetaData;
+
+        rcode = HsmCmdVsmGetSlotInfoCtx(&slotCtx, vssSlotNum, 
+                                        &vsMetaData, &slotInfoBytes);
+    }
     if (rcode != S_OK) {
         //SYS_PRINT("HSM Key Slot# %d Empty or Invalid - Abort Output Data Command\r\n", 
         //           vssSlotNum);
@@ -223,117 +318,68 @@ RSP_DATA * HsmCmdVsmOutputDataUnencrypted(
         rsp->resultCode = rcode;
         return rsp;
     }
-
-    // Make sure the HSM is not busy after the Slot Info Command
-    while (HSM_REGS->HSM_STATUS & HSM_STATUS_BUSY_Msk);
 #endif //0
 
-    //Send CMD_VSM_OUTPUT_DATA - Input Clear Data/Internal Slot/APL 0/No Auth
+    //CMD_VSM_OUTPUT_DATA - Input Clear Data/Internal Slot/APL 0/No Auth
     //--No TA/No Slot/No Auth
-    gHsmCmdReq.mbHeader = 0x00f00014; //5 Words/PROT bits
-    gHsmCmdReq.cmdHeader = CMD_VSM_OUTPUT_DATA_INST; //CMD_VSM_OUTPUT_DATA
+    ctx->req.mbHeader = 0x00f00014; //5 Words/PROT bits
+    ctx->req.cmdHeader = CMD_VSM_OUTPUT_DATA_INST; //CMD_VSM_OUTPUT_DATA
 
     //IN/OUT
-    gHsmCmdReq.cmdInputs[0] = 0x00000000; //IN: (No Auth - Unused)
-    gHsmCmdReq.cmdInputs[1] = (uint32_t) (&(dmaDescriptorOut[0])); //OUT
+    ctx->req.cmdInputs[0] = 0x00000000; //IN: (No Auth - Unused)
 
     //PARAM
-    gHsmCmdReq.cmdInputs[2] = vssOutputParam1.v;
-    //SYS_PRINT("XXCMD INP[2]: 0x%08lx \r\n", gHsmCmdReq.cmdInputs[2]);
-    gHsmCmdReq.cmdInputs[3] = 0x00000000; //(unused)
+    ctx->req.cmdInputs[2] = vssOutputParam1.v;
+    //SYS_PRINT("XXCMD INP[2]: 0x%08lx \r\n", ctx->req.cmdInputs[2]);
+    ctx->req.cmdInputs[3] = 0x00000000; //(unused)
 
     //Expected CMD Response 
-    gHsmCmdReq.expMbHeader = 0x00200010; //4 Words
-    gHsmCmdReq.expResultCode = S_OK;
-    gHsmCmdReq.expStatus = 0x00000320;
-    gHsmCmdReq.expIntFlag = 0x00000000;
-    gHsmCmdReq.expData = 0x00000000;
-    gHsmCmdReq.expNumDataBytes = 0x00000000;
+    ctx->req.expMbHeader = 0x00200010; //4 Words
+    ctx->req.expResultCode = S_OK;
+    ctx->req.expStatus = 0x00000320;
+    ctx->req.expIntFlag = 0x00000000;
+    ctx->req.expData = 0x00000000;
+    ctx->req.expNumDataBytes = 0x00000000;
 
     //Input SG (unused))
-    dmaDescriptorIn[0].data.addr = &dummy32;
-    dmaDescriptorIn[0].next.s.stop = 1;
-    dmaDescriptorIn[0].next.s.addr = 0;
-    dmaDescriptorIn[0].flagsLength.s.length = 0;
-    dmaDescriptorIn[0].flagsLength.s.cstAddr = 0;
-    dmaDescriptorIn[0].flagsLength.s.discard = 0;
-    dmaDescriptorIn[0].flagsLength.s.realign = 1;
-    dmaDescriptorIn[0].flagsLength.s.intEn = 0;
+    HsmCmdCtxSetSG(&ctx->dmaIn[0], &dummy32, 0, NULL);
 
     //Output SG for Key Block Result
-    dmaDescriptorOut[0].data.addr = dataOut;
-    dmaDescriptorOut[0].next.s.stop = 1;
-    dmaDescriptorOut[0].next.s.addr = 0;
-    dmaDescriptorOut[0].flagsLength.s.length = (*numDataWords) * BYTES_PER_WORD;
-    dmaDescriptorOut[0].flagsLength.s.cstAddr = 0;
-    dmaDescriptorOut[0].flagsLength.s.discard = 0;
-    dmaDescriptorOut[0].flagsLength.s.realign = 1;
-    dmaDescriptorOut[0].flagsLength.s.intEn = 0;
-
-    // SCB_CleanDCache_by_Addr((uint32_t *) dmaDescriptorIn, sizeof(dmaDescriptorIn));
-    //  SCB_CleanDCache_by_Addr((uint32_t *) dmaDescriptorOut, sizeof(dmaDescriptorOut));
-    //   SCB_CleanInvalidateDCache_by_Addr((uint32_t *) dataOut, maxDataBytes);
-    //SCB_CleanInvalidateDCache_by_Addr((uint32_t *) vsmInputDataRaw, 12*sizeof(uint32_t));
+    HsmCmdCtxSetSG(&ctx->dmaOut[0], dataOut, 
+                   (*numDataWords) * BYTES_PER_WORD, NULL);
 
-    //SYS_MESSAGE("VSM OUT SG (Data Prior to DMA Write):\r\n");
-    //PrintSG(dmaDescriptorOut[0], true);
-    HsmMbCmdDriver(&gHsmCmdReq, false);
+    //Data cache: HsmDmaCmdPrepare()/HsmDmaCmdComplete() (hsm_dma.c)
 
+    //SYS_MESSAGE("VSM OUT SG (Data Prior to DMA Write):\r\n");
+    //PrintSG(ctx->dmaOut[0], true);
+    HsmCmdCtxExec(ctx);
 
     SYS_MESSAGE("****HSM Cmd Response Checks****\r\n");
-    // Wait for an interrupt in interrupt mode
-    //if (int_mode) 
-    //{
-    //SYS_PRINT("HSM ROM Cmd: Waiting for interrupt...\r\n");
-    //while (!gRspData.hsm_rx_int);
-    //gRspData.hsm_rx_int = false;
-    //} 
-    HsmCmdRspChkr(rsp, true);
-
-    //if (gHsmCmdResp.resultCode == S_OK)
-    //{
-    //    vsMetaData.vsHeader             = (VSHeader) dataOut[0];
-    //    vsMetaData.validAfter           = dataOut[1];
-    //    vsMetaData.validBefore          = dataOut[2];
-    //    vsMetaData.dataSpecificMetaData = dataOut[3];
-    //}
+    HsmCmdCtxRspChkr(ctx, true);
 
     //TODO:  Other Key types, other than RAW
-    //int slotSizeBytes = 0;
-
-    //if (vsMetaData.vsHeader.s.vsSlotType == VSS_RAW)
-    //{
-    //    slotSizeBytes = vsMetaData.dataSpecificMetaData; 
-    //}
-    //else
-    //{
-    //    //TODO: 
-    //    slotSizeBytes = 0;
-    //}
-
     //Check the FiFo data count against the metadata derived count
-    //if (gHsmCmdResp.numResultWords == 1)
-    //{
-    //    if (slotSizeBytes > 0 &&
-    //        slotSizeBytes != gHsmCmdResp.resultData[0])
-    //    {
     SYS_PRINT("DMA slot size (%d bytes)\r\n",
-            (int) gHsmCmdResp.resultData[0]);
-    //      numDataWords = gHsmCmdResp.resultData[0]/BYTES_PER_WORD;
-    //    }
-    //else
-    //{
-    //    *numDataWords = gHsmCmdResp.resultData[0];
-    //}
-    //}
-    //else
-    //{
-    //Not Valid Output
-    //    *numDataWords = slotSizeBytes/BYTES_PER_WORD;
-    //}
+            (int) ctx->rsp.resultData[0]);
 
     return rsp;
 
+} //End HsmCmdVsmOutputDataUnencryptedCtx()
+
+
+//******************************************************************************
+//CMD_VSM_OUTPUT_DATA Unencrypted Internal Slot Output Data Command--
+// --The slot size is in gHsmCmdResp.resultData[0]
+//******************************************************************************
+
+RSP_DATA * HsmCmdVsmOutputDataUnencrypted(
+        int vssSlotNum,
+        uint32_t * dataOut,
+        int * numDataWords,
+        uint32_t maxDataBytes) {
+    HsmCmdVsmOutputDataUnencryptedCtx(&gHsmCmdCtx, vssSlotNum, 
+            dataOut, numDataWords, maxDataBytes);
+    return HsmCmdCtxPublish(&gHsmCmdCtx);
 } //End HsmCmdVsmOutputDataUnencrypted()
 
 
@@ -345,80 +391,76 @@ RSP_DATA * HsmCmdVsmOutputDataUnencrypted(
 //    0  - Slot Info Available
 //    1  - VS is Empty
 //
+// --Command context variant (slot info words in ctx->cmdData)
 //******************************************************************************
 
-CmdResultCodes HsmCmdVsmGetSlotInfo(int vssSlotNum,
+CmdResultCodes HsmCmdVsmGetSlotInfoCtx(HsmCmdCtx * ctx,
+        int vssSlotNum,
         VSMetaData *vsMetaData,
         uint32_t *slotSizeBytes) {
-    static CmdVSMGetSlotInfoParameter1 cmdParam1;
+    CmdVSMGetSlotInfoParameter1 cmdParam1;
+    uint32_t * slotInfoOut = ctx->cmdData; //VS Header/NV Before/NV After/VS Meta
 
-    // Make sure the HSM is not busy
-    while (HSM_REGS->HSM_STATUS & HSM_STATUS_BUSY_Msk);
+    HsmCmdCtxInit(ctx);
     //SYS_PRINT("VSM SLOT INFO (Slot %d):\r\n", vssSlotNum);
 
-    //Send CMD_VSM_GET_SLOT_INFO - Input Clear Data/Internal Slot/APL 0/No Auth
+    //CMD_VSM_GET_SLOT_INFO - Input Clear Data/Internal Slot/APL 0/No Auth
     //--No TA/No Slot/No Auth
-    gHsmCmdReq.mbHeader = 0x00f00014; //5 Words/PROT bits
-    gHsmCmdReq.cmdHeader = CMD_VSM_SLOT_GET_INFO_INST; //CMD_VSM_SLOT_GET_INFO
-    gHsmCmdReq.cmdInputs[0] = 0x00000000; //IN: (No Auth - Unused)
-    gHsmCmdReq.cmdInputs[1] = (uint32_t) (&(dmaDescriptorOut[0])); //OUT
+    ctx->req.mbHeader = 0x00f00014; //5 Words/PROT bits
+    ctx->req.cmdHeader = CMD_VSM_SLOT_GET_INFO_INST; //CMD_VSM_SLOT_GET_INFO
+    ctx->req.cmdInputs[0] = 0x00000000; //IN: (No Auth - Unused)
 
     //Parameters
+    cmdParam1.v = 0;
     cmdParam1.s.slotNumber = vssSlotNum; //Only field
-    gHsmCmdReq.cmdInputs[2] = (uint32_t) cmdParam1.v;
-    gHsmCmdReq.cmdInputs[3] = 0x00000000; //(unused)
+    ctx->req.cmdInputs[2] = (uint32_t) cmdParam1.v;
+    ctx->req.cmdInputs[3] = 0x00000000; //(unused)
 
     //Expected Response CMD
-    gHsmCmdReq.expMbHeader = 0x00200010; //4 Words(UNPROT))
-    gHsmCmdReq.expResultCode = S_OK;
-    gHsmCmdReq.expStatus = 0x00000320;
-    gHsmCmdReq.expIntFlag = 0x00000000;
-    gHsmCmdReq.expData = 0;
-    gHsmCmdReq.expNumDataBytes = 0;
+    ctx->req.expMbHeader = 0x00200010; //4 Words(UNPROT))
+    ctx->req.expResultCode = S_OK;
+    ctx->req.expStatus = 0x00000320;
+    ctx->req.expIntFlag = 0x00000000;
+    ctx->req.expData = 0;
+    ctx->req.expNumDataBytes = 0;
 
     //Input SG (unused))
-    dmaDescriptorIn[0].data.addr = &dummy32;
-    dmaDescriptorIn[0].next.s.stop = 1;
-    dmaDescriptorIn[0].next.s.addr = 0;
-    dmaDescriptorIn[0].flagsLength.s.length = 0;
-    dmaDescriptorIn[0].flagsLength.s.cstAddr = 0;
-    dmaDescriptorIn[0].flagsLength.s.discard = 0;
-    dmaDescriptorIn[0].flagsLength.s.realign = 1;
-    dmaDescriptorIn[0].flagsLength.s.intEn = 0;
+    HsmCmdCtxSetSG(&ctx->dmaIn[0], &dummy32, 0, NULL);
 
     //Output SG /VS Header/NV Before/NV After/VS Meta
-    dmaDescriptorOut[0].data.addr = vsmSlotInfoOut;
-    dmaDescriptorOut[0].next.s.stop = 1;
-    dmaDescriptorOut[0].next.s.addr = 0;
-    dmaDescriptorOut[0].flagsLength.s.length = 16; //4 Words
-    dmaDescriptorOut[0].flagsLength.s.cstAddr = 0;
-    dmaDescriptorOut[0].flagsLength.s.discard = 0;
-    dmaDescriptorOut[0].flagsLength.s.realign = 1;
-    dmaDescriptorOut[0].flagsLength.s.intEn = 0;
-
-    //  SCB_CleanDCache_by_Addr((uint32_t *) dmaDescriptorIn, sizeof(dmaDescriptorIn));
-    //  SCB_CleanDCache_by_Addr((uint32_t *) dmaDescriptorOut, sizeof(dmaDescriptorOut));
-    //  SCB_CleanInvalidateDCache_by_Addr((uint32_t *) dummy32, 4);
+    HsmCmdCtxSetSG(&ctx->dmaOut[0], slotInfoOut, 16, NULL); //4 Words
+
+    //Data cache: HsmDmaCmdPrepare()/HsmDmaCmdComplete() (hsm_dma.c)
 
     //Send HSM Command
-    HsmMbCmdDriver(&gHsmCmdReq, false);
+    HsmCmdCtxExec(ctx);
 
     // Check Response
     // --Mailbox Header
-    if (gHsmCmdResp.mbHeader.v != gHsmCmdReq.expMbHeader) {
-        return gHsmCmdResp.resultCode;
+    if (ctx->rsp.mbHeader.v != ctx->req.expMbHeader) {
+        return ctx->rsp.resultCode;
     }
 
     //Check the Command Header 
-    if (gHsmCmdResp.cmdHeader != gHsmCmdReq.cmdHeader) {
-        return gHsmCmdResp.resultCode;
+    if (ctx->rsp.cmdHeader != ctx->req.cmdHeader) {
+        return ctx->rsp.resultCode;
     }
 
-    if (gHsmCmdResp.resultCode == S_OK) {
-        vsMetaData->vsHeader = (VSHeader) vsmSlotInfoOut[0];
-        vsMetaData->validBefore = vsmSlotInfoOut[1];
-        vsMetaData->validAfter = vsmSlotInfoOut[2];
-        vsMetaData->dataSpecificMetaData = vsmSlotInfoOut[3];
+    if (ctx->rsp.resultCode == S_OK) {
+        vsMetaData->vsHeader = (VSHeader) slotInfoOut[0];
+        vsMetaData->validBefore = slotInfoOut[1];
+        vsMetaData->validAfter = slotInfoOut[2];
+        vsMetaData->dataSpecificMetaData = slotInfoOut[3];
+    }
+
+    //Every slot info read refreshes the slot metadata cache
+    if (vssSlotNum > MINSLOTNUM && vssSlotNum < MAXSLOTNUM) {
+        if (ctx->rsp.resultCode == S_OK) {
+            vsmSlotCache[vssSlotNum] = *vsMetaData;
+            vsmSlotCacheState[vssSlotNum] = VSM_SLOT_CACHE_VALID;
+        } else if (ctx->rsp.resultCode == E_VSEMPTY) {
+            vsmSlotCacheState[vssSlotNum] = VSM_SLOT_CACHE_EMPTY;
+        }
     }
 
     //TODO:  Other Key types, other than RAW
@@ -429,9 +471,33 @@ CmdResultCodes HsmCmdVsmGetSlotInfo(int vssSlotNum,
         *slotSizeBytes = 0;
     }
 
+    return ctx->rsp.resultCode;
 
-    return gHsmCmdResp.resultCode;
+} //End HsmCmdVsmGetSlotInfoCtx()
 
+
+//******************************************************************************
+//CMD_VSM_SLOT_GET_INFO Command
+//
+//   Return ErrCode:
+//   -1 - General Error
+//    0  - Slot Info Available
+//    1  - VS is Empty
+//
+// --Slot info words in vsmSlotInfoOut
+//******************************************************************************
+
+CmdResultCodes HsmCmdVsmGetSlotInfo(int vssSlotNum,
+        VSMetaData *vsMetaData,
+        uint32_t *slotSizeBytes) {
+    CmdResultCodes rc;
+
+    rc = HsmCmdVsmGetSlotInfoCtx(&gHsmCmdCtx, vssSlotNum, 
+                                 vsMetaData, slotSizeBytes);
+    HsmCmdCtxPublish(&gHsmCmdCtx);
+    memcpy(vsmSlotInfoOut, gHsmCmdCtx.cmdData, sizeof(vsmSlotInfoOut));
+
+    return rc;
 } //End HsmCmdVsmGetSlotInfo()
 
 
@@ -443,83 +509,67 @@ CmdResultCodes HsmCmdVsmGetSlotInfo(int vssSlotNum,
 //    0  - Slot Info Available
 //    1  - VS is Empty
 //
+// --Command context variant
 //******************************************************************************
 
-SLOTINFORETURN HsmCmdVsmPrintSlotInfo(int vssSlotNum) {
-    static CmdVSMGetSlotInfoParameter1 cmdParam1;
+SLOTINFORETURN HsmCmdVsmPrintSlotInfoCtx(HsmCmdCtx * ctx, int vssSlotNum) {
+    CmdVSMGetSlotInfoParameter1 cmdParam1;
+    uint32_t * slotInfoOut = ctx->cmdData; //VS Header/NV Before/NV After/VS Meta
     char * rcStr;
 
-    // Make sure the HSM is not busy
-    while (HSM_REGS->HSM_STATUS & HSM_STATUS_BUSY_Msk);
+    HsmCmdCtxInit(ctx);
     SYS_PRINT("CMD_VSM_GET_SLOT_INFO (VSS %d)\r\n", vssSlotNum);
 
-    //Send CMD_VSM_GET_SLOT_INFO - Input Clear Data/Internal Slot/APL 0/No Auth
+    //CMD_VSM_GET_SLOT_INFO - Input Clear Data/Internal Slot/APL 0/No Auth
     //--No TA/No Slot/No Auth
-    gHsmCmdReq.mbHeader = 0x00f00014; //5 Words/PROT bits
-    gHsmCmdReq.cmdHeader = CMD_VSM_SLOT_GET_INFO_INST; //CMD_VSM_SLOT_GET_INFO
-    gHsmCmdReq.cmdInputs[0] = 0x00000000; //IN: (No Auth - Unused)
-    gHsmCmdReq.cmdInputs[1] = (uint32_t) (&(dmaDescriptorOut[0])); //OUT
+    ctx->req.mbHeader = 0x00f00014; //5 Words/PROT bits
+    ctx->req.cmdHeader = CMD_VSM_SLOT_GET_INFO_INST; //CMD_VSM_SLOT_GET_INFO
+    ctx->req.cmdInputs[0] = 0x00000000; //IN: (No Auth - Unused)
 
     //Parameters
+    cmdParam1.v = 0;
     cmdParam1.s.slotNumber = vssSlotNum; //Only field
-    gHsmCmdReq.cmdInputs[2] = (uint32_t) cmdParam1.v;
-    gHsmCmdReq.cmdInputs[3] = 0x00000000; //(unused)
+    ctx->req.cmdInputs[2] = (uint32_t) cmdParam1.v;
+    ctx->req.cmdInputs[3] = 0x00000000; //(unused)
 
     //Expected Response CMD
-    gHsmCmdReq.expMbHeader = 0x00200010; //4 Words(UNPROT))
-    gHsmCmdReq.expResultCode = S_OK;
-    gHsmCmdReq.expStatus = 0x00000320;
-    gHsmCmdReq.expIntFlag = 0x00000000;
-    gHsmCmdReq.expData = 0;
-    gHsmCmdReq.expNumDataBytes = 0;
+    ctx->req.expMbHeader = 0x00200010; //4 Words(UNPROT))
+    ctx->req.expResultCode = S_OK;
+    ctx->req.expStatus = 0x00000320;
+    ctx->req.expIntFlag = 0x00000000;
+    ctx->req.expData = 0;
+    ctx->req.expNumDataBytes = 0;
 
     //Input SG (unused))
-    dmaDescriptorIn[0].data.addr = &dummy32;
-    dmaDescriptorIn[0].next.s.stop = 1;
-    dmaDescriptorIn[0].next.s.addr = 0;
-    dmaDescriptorIn[0].flagsLength.s.length = 0;
-    dmaDescriptorIn[0].flagsLength.s.cstAddr = 0;
-    dmaDescriptorIn[0].flagsLength.s.discard = 0;
-    dmaDescriptorIn[0].flagsLength.s.realign = 1;
-    dmaDescriptorIn[0].flagsLength.s.intEn = 0;
+    HsmCmdCtxSetSG(&ctx->dmaIn[0], &dummy32, 0, NULL);
 
     //Output SG /VS Header/NV Before/NV After/VS Meta
-    dmaDescriptorOut[0].data.addr = vsmSlotInfoOut;
-    dmaDescriptorOut[0].next.s.stop = 1;
-    dmaDescriptorOut[0].next.s.addr = 0;
-    dmaDescriptorOut[0].flagsLength.s.length = 16; //4 Words
-    dmaDescriptorOut[0].flagsLength.s.cstAddr = 0;
-    dmaDescriptorOut[0].flagsLength.s.discard = 0;
-    dmaDescriptorOut[0].flagsLength.s.realign = 1;
-    dmaDescriptorOut[0].flagsLength.s.intEn = 0;
-
-    //   SCB_CleanDCache_by_Addr((uint32_t *) dmaDescriptorIn, sizeof(dmaDescriptorIn));
-    //   SCB_CleanDCache_by_Addr((uint32_t *) dmaDescriptorOut, sizeof(dmaDescriptorOut));
-    //   SCB_CleanInvalidateDCache_by_Addr((uint32_t *) dummy32, 4);
-    //   SCB_CleanInvalidateDCache_by_Addr((uint32_t *) vsmSlotInfoOut, 16);
+    HsmCmdCtxSetSG(&ctx->dmaOut[0], slotInfoOut, 16, NULL); //4 Words
+
+    //Data cache: HsmDmaCmdPrepare()/HsmDmaCmdComplete() (hsm_dma.c)
 
     //Send HSM Command
-    HsmMbCmdDriver(&gHsmCmdReq, false);
+    HsmCmdCtxExec(ctx);
 
     // Check Response
     // --Mailbox Header
-    if (gHsmCmdResp.mbHeader.v != gHsmCmdReq.expMbHeader) {
-        if (gHsmCmdResp.resultCode != E_INVFORMAT &&
-                gHsmCmdResp.resultCode != E_SAFEMODE) {
+    if (ctx->rsp.mbHeader.v != ctx->req.expMbHeader) {
+        if (ctx->rsp.resultCode != E_INVFORMAT &&
+                ctx->rsp.resultCode != E_SAFEMODE) {
             SYS_MESSAGE("HSM CMD VSS Slot Info FAIL: Mailbox Header Match\r\n");
-            SYS_PRINT("Expected: 0x%08lx\r\n", (uint32_t) gHsmCmdReq.expMbHeader);
-            SYS_PRINT("Actual:   0x%08lx\r\n", (uint32_t) gHsmCmdResp.mbHeader.v);
+            SYS_PRINT("Expected: 0x%08lx\r\n", (uint32_t) ctx->req.expMbHeader);
+            SYS_PRINT("Actual:   0x%08lx\r\n", (uint32_t) ctx->rsp.mbHeader.v);
             //return -1;
         }
     }
 
     //Check the Command Header 
-    if (gHsmCmdResp.cmdHeader != gHsmCmdReq.cmdHeader) {
-        if (gHsmCmdResp.resultCode != E_INVFORMAT &&
-                gHsmCmdResp.resultCode != E_SAFEMODE) {
+    if (ctx->rsp.cmdHeader != ctx->req.cmdHeader) {
+        if (ctx->rsp.resultCode != E_INVFORMAT &&
+                ctx->rsp.resultCode != E_SAFEMODE) {
             SYS_MESSAGE("HSM CMD VSS Slot Info FAIL: Command Header Match\r\n");
-            SYS_PRINT("Expected: 0x%08lx\r\n", (uint32_t) gHsmCmdReq.cmdHeader);
-            SYS_PRINT("Actual:   0x%08lx\r\n", (uint32_t) gHsmCmdResp.cmdHeader);
+            SYS_PRINT("Expected: 0x%08lx\r\n", (uint32_t) ctx->req.cmdHeader);
+            SYS_PRINT("Actual:   0x%08lx\r\n", (uint32_t) ctx->rsp.cmdHeader);
             return ERR_GENERAL;
         } else {
             SYS_MESSAGE("HSM FAIL: INV Command or SAFEMODE:\r\n");
@@ -531,23 +581,23 @@ SLOTINFORETURN HsmCmdVsmPrintSlotInfo(int vssSlotNum) {
     VSMetaData vsMetaData;
     int slotSizeBytes;
 
-    rcStr = CmdResultCodeStr(gHsmCmdResp.resultCode);
-    if (gHsmCmdResp.resultCode != S_OK) {
-        if (gHsmCmdResp.resultCode == E_VSEMPTY) {
+    rcStr = CmdResultCodeStr(ctx->rsp.resultCode);
+    if (ctx->rsp.resultCode != S_OK) {
+        if (ctx->rsp.resultCode == E_VSEMPTY) {
             SYS_PRINT("VS #%d is EMPTY\r\n", vssSlotNum);
             return VS_SLOT_EMPTY;
-        } else if (gHsmCmdResp.resultCode == E_VSINUSE) {
+        } else if (ctx->rsp.resultCode == E_VSINUSE) {
             SYS_PRINT("VS #%d IN USE\r\n", vssSlotNum);
             return ERR_GENERAL;
         } else {
             SYS_PRINT("!!!VS #%d - %s!!!\r\n", vssSlotNum, rcStr);
             return ERR_GENERAL;
         }
-    } else if (gHsmCmdResp.resultCode == S_OK) {
-        vsMetaData.vsHeader = (VSHeader) vsmSlotInfoOut[0];
-        vsMetaData.validBefore = vsmSlotInfoOut[1];
-        vsMetaData.validAfter = vsmSlotInfoOut[2];
-        vsMetaData.dataSpecificMetaData = vsmSlotInfoOut[3];
+    } else if (ctx->rsp.resultCode == S_OK) {
+        vsMetaData.vsHeader = (VSHeader) slotInfoOut[0];
+        vsMetaData.validBefore = slotInfoOut[1];
+        vsMetaData.validAfter = slotInfoOut[2];
+        vsMetaData.dataSpecificMetaData = slotInfoOut[3];
     }
 
     //TODO:  Other Key types, other than RAW
@@ -568,94 +618,218 @@ SLOTINFORETURN HsmCmdVsmPrintSlotInfo(int vssSlotNum) {
     SYS_PRINT("  VSS Before: 0x%08x\r\n", vsMetaData.validBefore);
     SYS_PRINT("  VSS  After: 0x%08x\r\n", vsMetaData.validAfter);
     SYS_PRINT("  VSS   Meta: 0x%08x\r\n", vsMetaData.dataSpecificMetaData);
-    //PrintSG(dmaDescriptorOut[0], true);
+    //PrintSG(ctx->dmaOut[0], true);
 
     return VS_SLOT_INFO_AVAIL;
 
-} //End HsmCmdVsmPrintSlotInfo()
-
+} //End HsmCmdVsmPrintSlotInfoCtx()
 
 
 //******************************************************************************
-//CMD_VSM_DELETE_SLOT Command--Delete the slot data
-//   returns: ResultCode
+//CMD_VSM_SLOT_GET_INFO Command (Print the slot info)
 //******************************************************************************
 
-RSP_DATA * HsmCmdVsmDeleteSlot(int vssSlotNum) {
-    RSP_DATA * rsp = &gRspData;
-    static CmdVSMDeleteSlotParameter1 cmdParam1;
+SLOTINFORETURN HsmCmdVsmPrintSlotInfo(int vssSlotNum) {
+    SLOTINFORETURN ret;
 
-    SYS_PRINT("HSM: Sending CMD_VSM_DELETE_SLOT Command (VSS %d)\r\n",
-            vssSlotNum);
+    ret = HsmCmdVsmPrintSlotInfoCtx(&gHsmCmdCtx, vssSlotNum);
+    HsmCmdCtxPublish(&gHsmCmdCtx);
+    memcpy(vsmSlotInfoOut, gHsmCmdCtx.cmdData, sizeof(vsmSlotInfoOut));
 
-    // Reset the response checker global variable
-    rsp->invArgs = false;
-    rsp->rspChksPassed = false;
-    rsp->resultCode = S_OK;
-    rsp->testFailCnt = 0;
+    return ret;
+} //End HsmCmdVsmPrintSlotInfo()
+
+
+//******************************************************************************
+//CMD_VSM_DELETE_SLOT Command--Delete the slot data (request only)
+// --Command context variant (ctx->rspData has the response check results)
+//******************************************************************************
 
+RSP_DATA * HsmCmdVsmDeleteSlotPrep(HsmCmdCtx * ctx, int vssSlotNum) {
+    RSP_DATA * rsp = &ctx->rspData;
+    CmdVSMDeleteSlotParameter1 cmdParam1;
 
-    // Make sure the HSM is not busy
-    while (HSM_REGS->HSM_STATUS & HSM_STATUS_BUSY_Msk);
+    // Reset the response checker
+    HsmCmdCtxInit(ctx);
+    rsp->resultCode = S_OK;
 
-    //Send CMD_VSM_DELETE_SLOT - Input Clear Data/Internal Slot/APL 0/No Auth
+    //CMD_VSM_DELETE_SLOT - Input Clear Data/Internal Slot/APL 0/No Auth
     //--No TA/No Slot/No Auth
-    gHsmCmdReq.mbHeader = 0x00f00014; //5 Words/PROT bits
-    gHsmCmdReq.cmdHeader = CMD_VSM_DELETE_SLOT_INST; //CMD_VSM_DELETE_SLOT
-    gHsmCmdReq.cmdInputs[0] = 0x00000000; //IN: (No Auth - Unused)
-    gHsmCmdReq.cmdInputs[1] = 0x00000000; //OUT
+    ctx->req.mbHeader = 0x00f00014; //5 Words/PROT bits
+    ctx->req.cmdHeader = CMD_VSM_DELETE_SLOT_INST; //CMD_VSM_DELETE_SLOT
+    ctx->req.cmdInputs[0] = 0x00000000; //IN: (No Auth - Unused)
+    ctx->req.cmdInputs[1] = 0x00000000; //OUT
 
-    //gHsmCmdReq.cmdInputs[2] = CMD_VSM_SLOT_NUMBER_FIELD & 
-    //                         vssSlotNum<<CMD_VSM_SLOT_NUMBER_SHIFT;
     cmdParam1.v = 0x0F000000;
     cmdParam1.s.slotNumber = vssSlotNum;
-    SYS_PRINT("--CMD INP[2]: 0x%08lx\r\n", cmdParam1.v);
-    gHsmCmdReq.cmdInputs[2] = cmdParam1.v;
-    SYS_PRINT("--CMD INP[2]: 0x%08lx\r\n", gHsmCmdReq.cmdInputs[2]);
+    ctx->req.cmdInputs[2] = cmdParam1.v;
 
-    gHsmCmdReq.cmdInputs[3] = 0x00000000; //(unused)
+    ctx->req.cmdInputs[3] = 0x00000000; //(unused)
 
     //Expected Response CMD
-    gHsmCmdReq.expMbHeader = 0x0020000c; //4 Words(UNPROT))
-    gHsmCmdReq.expResultCode = S_OK; //E_VSEMPTY;
-    gHsmCmdReq.expStatus = 0x00000320;
-    gHsmCmdReq.expIntFlag = 0x00000000;
-    gHsmCmdReq.expData = 0;
-    gHsmCmdReq.expNumDataBytes = 0;
-
+    ctx->req.expMbHeader = 0x0020000c; //4 Words(UNPROT))
+    ctx->req.expResultCode = S_OK; //E_VSEMPTY;
+    ctx->req.expStatus = 0x00000320;
+    ctx->req.expIntFlag = 0x00000000;
+    ctx->req.expData = 0;
+    ctx->req.expNumDataBytes = 0;
 
     //Input SG (unused))
-    dmaDescriptorIn[0].data.addr = &dummy32;
-    dmaDescriptorIn[0].next.s.stop = 1;
-    dmaDescriptorIn[0].next.s.addr = 0;
-    dmaDescriptorIn[0].flagsLength.s.length = 0;
-    dmaDescriptorIn[0].flagsLength.s.cstAddr = 0;
-    dmaDescriptorIn[0].flagsLength.s.discard = 0;
-    dmaDescriptorIn[0].flagsLength.s.realign = 1;
-    dmaDescriptorIn[0].flagsLength.s.intEn = 0;
+    HsmCmdCtxSetSG(&ctx->dmaIn[0], &dummy32, 0, NULL);
 
     //Output SG
-    dmaDescriptorOut[0].data.addr = &dummy32;
-    dmaDescriptorOut[0].next.s.stop = 1;
-    dmaDescriptorOut[0].next.s.addr = 0;
-    dmaDescriptorOut[0].flagsLength.s.length = 0 * sizeof (uint32_t);
-    dmaDescriptorOut[0].flagsLength.s.cstAddr = 0;
-    dmaDescriptorOut[0].flagsLength.s.discard = 0;
-    dmaDescriptorOut[0].flagsLength.s.realign = 1;
-    dmaDescriptorOut[0].flagsLength.s.intEn = 0;
+    HsmCmdCtxSetSG(&ctx->dmaOut[0], &dummy32, 0, NULL);
 
-    // SCB_CleanDCache_by_Addr((uint32_t *) dmaDescriptorIn, sizeof(dmaDescriptorIn));
-    // SCB_CleanDCache_by_Addr((uint32_t *) dmaDescriptorOut, sizeof(dmaDescriptorOut));
+    //Data cache: HsmDmaCmdPrepare()/HsmDmaCmdComplete() (hsm_dma.c)
 
-    HsmMbCmdDriver(&gHsmCmdReq, false);
-    SYS_PRINT("HSM: RC 0x%08lx %s\r\n", (uint32_t) gHsmCmdResp.resultCode,
-            CmdResultCodeStr(gHsmCmdResp.resultCode));
+    return rsp;
+} //End HsmCmdVsmDeleteSlotPrep() 
 
-    HsmCmdRspChkr(rsp, true);
+
+//******************************************************************************
+//CMD_VSM_DELETE_SLOT Command--Delete the slot data
+//   returns: ResultCode
+// --Command context variant (ctx->rspData has the response check results)
+// --No console output (HsmKeySlot() key eviction)
+//******************************************************************************
+
+RSP_DATA * HsmCmdVsmDeleteSlotCtx(HsmCmdCtx * ctx, int vssSlotNum) {
+    RSP_DATA * rsp;
+
+    rsp = HsmCmdVsmDeleteSlotPrep(ctx, vssSlotNum);
+
+    HsmCmdCtxExec(ctx);
+
+    HsmCmdCtxRspChkr(ctx, true);
+
+    //Deleted:  the slot is known empty, otherwise read it again
+    HsmCmdVsmSlotCacheInvalidate(vssSlotNum);
+    if (rsp->rspChksPassed == true &&
+            vssSlotNum > MINSLOTNUM && vssSlotNum < MAXSLOTNUM) {
+        vsmSlotCacheState[vssSlotNum] = VSM_SLOT_CACHE_EMPTY;
+    }
 
     return rsp;
+} //End HsmCmdVsmDeleteSlotCtx() 
+
+
+//******************************************************************************
+//CMD_VSM_DELETE_SLOT Command--Delete the slot data
+//   returns: ResultCode
+//******************************************************************************
+
+RSP_DATA * HsmCmdVsmDeleteSlot(int vssSlotNum) {
+    SYS_PRINT("HSM: Sending CMD_VSM_DELETE_SLOT Command (VSS %d)\r\n",
+            vssSlotNum);
+    HsmCmdVsmDeleteSlotCtx(&gHsmCmdCtx, vssSlotNum);
+    SYS_PRINT("--CMD INP[2]: 0x%08lx\r\n", gHsmCmdCtx.req.cmdInputs[2]);
+    SYS_PRINT("HSM: RC 0x%08lx %s\r\n", (uint32_t) gHsmCmdCtx.rsp.resultCode,
+            CmdResultCodeStr(gHsmCmdCtx.rsp.resultCode));
+    return HsmCmdCtxPublish(&gHsmCmdCtx);
 } //End HsmCmdVsmDeleteSlot() 
 
+//******************************************************************************
+//******************************************************************************
+//  VSM Slot Metadata Cache
+//
+//  Host copy of the CMD_VSM_SLOT_GET_INFO metadata per slot, so the slot 
+//  checks of the slot keyed commands (e.g. HsmCmdAesHdrPrep()) do not send a
+//  slot info command each time.  Kept coherent by the host VSM commands:
+//    --HsmCmdVsmGetSlotInfoCtx():   Updates the slot entry (or empty)
+//    --HsmCmdVsmInputDataUnencrypted*(): Invalidates the slot entry
+//    --HsmCmdVsmDeleteSlotCtx():    Marks the slot empty
+//  The HSM VM_STORAGE slots do not survive a HSM reset, so the cache is 
+//  cleared in HSM_INIT().  HsmCmdVsmSlotCacheRefresh() reads all the slots 
+//  (HSM_VSM_SLOT_CACHE_REFRESH at boot).
+//******************************************************************************
+//******************************************************************************
+
+//******************************************************************************
+// Forget the metadata of all the slots
+//******************************************************************************
+
+void HsmCmdVsmSlotCacheInit(void) {
+    memset(vsmSlotCacheState, VSM_SLOT_CACHE_UNKNOWN,
+            sizeof (vsmSlotCacheState));
+} //End HsmCmdVsmSlotCacheInit()
+
+
+//******************************************************************************
+// Forget the metadata of a slot (next lookup sends CMD_VSM_SLOT_GET_INFO)
+//******************************************************************************
+
+void HsmCmdVsmSlotCacheInvalidate(int vssSlotNum) {
+    if (vssSlotNum > MINSLOTNUM && vssSlotNum < MAXSLOTNUM) {
+        vsmSlotCacheState[vssSlotNum] = VSM_SLOT_CACHE_UNKNOWN;
+    }
+} //End HsmCmdVsmSlotCacheInvalidate()
+
+
+//******************************************************************************
+//CMD_VSM_SLOT_GET_INFO Command (Slot Metadata Cache)
+//
+//   Return: Same as HsmCmdVsmGetSlotInfoCtx()
+//     S_OK       - vsMetaData has the slot info
+//     E_VSEMPTY  - VS is Empty
+//
+// --Cached slot:  no command is sent (ctx is not used)
+// --Otherwise HsmCmdVsmGetSlotInfoCtx() (ctx has the command) and the result
+//   is cached.
+//******************************************************************************
+
+CmdResultCodes HsmCmdVsmGetSlotInfoCachedCtx(HsmCmdCtx * ctx,
+        int vssSlotNum,
+        VSMetaData *vsMetaData,
+        uint32_t *slotSizeBytes) {
+    if (vssSlotNum > MINSLOTNUM && vssSlotNum < MAXSLOTNUM) {
+        if (vsmSlotCacheState[vssSlotNum] == VSM_SLOT_CACHE_EMPTY) {
+            return E_VSEMPTY;
+        }
+        if (vsmSlotCacheState[vssSlotNum] == VSM_SLOT_CACHE_VALID) {
+            *vsMetaData = vsmSlotCache[vssSlotNum];
+
+            //TODO:  Other Key types, other than RAW
+            if (vsMetaData->vsHeader.s.vsSlotType == VSS_RAW) {
+                *slotSizeBytes = vsMetaData->dataSpecificMetaData;
+            } else {
+                *slotSizeBytes = 0;
+            }
+            return S_OK;
+        }
+    }
+
+    return HsmCmdVsmGetSlotInfoCtx(ctx, vssSlotNum, vsMetaData, slotSizeBytes);
+} //End HsmCmdVsmGetSlotInfoCachedCtx()
+
+
+//******************************************************************************
+//CMD_VSM_SLOT_GET_INFO Command (Slot Metadata Cache)
+// --Read the info of every slot into the cache (MAXSLOTNUM - 1 commands)
+// --returns the number of slots in use (-1 if a slot info command failed)
+//******************************************************************************
+
+int HsmCmdVsmSlotCacheRefresh(HsmCmdCtx * ctx) {
+    VSMetaData vsMetaData;
+    uint32_t slotSizeBytes;
+    CmdResultCodes rc;
+    int numSlots = 0;
+    int slot;
+
+    HsmCmdVsmSlotCacheInit();
+
+    for (slot = MINSLOTNUM + 1; slot < MAXSLOTNUM; slot++) {
+        rc = HsmCmdVsmGetSlotInfoCtx(ctx, slot, &vsMetaData, &slotSizeBytes);
+        if (rc == S_OK) {
+            numSlots++;
+        } else if (rc != E_VSEMPTY) {
+            return -1;
+        }
+    }
+
+    return numSlots;
+} //End HsmCmdVsmSlotCacheRefresh()
+
+
 //******************************************************************************
 //******************************************************************************
 //  VSM Utility Functions
@@ -45,6 +45,12 @@ extern "C" {
 #define VSS_META_WORDS  4  
 #define VSS_META_BYTES  VSS_META_WORDS*BYTES_PER_WORD 
 
+//Set to 1 to read the metadata of all the slots into the slot metadata cache
+//after the HSM is operational (HSM_Wait(), MAXSLOTNUM - 1 commands)
+#ifndef HSM_VSM_SLOT_CACHE_REFRESH
+#define HSM_VSM_SLOT_CACHE_REFRESH  0
+#endif
+
     // *****************************************************************************
     // *****************************************************************************
     // Section: Data Types
@@ -456,6 +462,64 @@ uint32_t:
 
     RSP_DATA * HsmCmdVsmDeleteSlot(int vssSlotNum);
 
+    //Command context variants
+    CmdResultCodes HsmCmdVsmGetSlotInfoCtx(HsmCmdCtx * ctx,
+            int vssSlotNum,
+            VSMetaData *vsMetaData,
+            uint32_t *slotSizeBytes);
+
+    SLOTINFORETURN HsmCmdVsmPrintSlotInfoCtx(HsmCmdCtx * ctx, int vssSlotNum);
+
+    RSP_DATA * HsmCmdVsmDeleteSlotPrep(HsmCmdCtx * ctx, int vssSlotNum);
+    RSP_DATA * HsmCmdVsmDeleteSlotCtx(HsmCmdCtx * ctx, int vssSlotNum);
+
+    //Slot metadata cache
+    CmdResultCodes HsmCmdVsmGetSlotInfoCachedCtx(HsmCmdCtx * ctx,
+            int vssSlotNum,
+            VSMetaData *vsMetaData,
+            uint32_t *slotSizeBytes);
+    void HsmCmdVsmSlotCacheInit(void);
+    void HsmCmdVsmSlotCacheInvalidate(int vssSlotNum);
+    int  HsmCmdVsmSlotCacheRefresh(HsmCmdCtx * ctx);
+
+    RSP_DATA * HsmCmdVsmInputDataUnencryptedStoragePrep(
+            HsmCmdCtx * ctx,
+            int vssSlotNum,
+            uint32_t * vsmInputDataPtr,
+            unsigned short numDataWords,
+            CmdVSMSlotType slotType,
+            CmdVSMDataSpecificMetaData specMetaData,
+            VSStorageType storageType);
+    RSP_DATA * HsmCmdVsmInputDataUnencryptedStorageCtx(
+            HsmCmdCtx * ctx,
+            int vssSlotNum,
+            uint32_t * vsmInputDataPtr,
+            unsigned short numDataWords,
+            CmdVSMSlotType slotType,
+            CmdVSMDataSpecificMetaData specMetaData,
+            VSStorageType storageType);
+    RSP_DATA * HsmCmdVsmInputDataUnencryptedPrep(
+            HsmCmdCtx * ctx,
+            int vssSlotNum,
+            uint32_t * vsmInputDataPtr,
+            unsigned short numDataWords,
+            CmdVSMSlotType slotType,
+            CmdVSMDataSpecificMetaData specMetaData);
+    RSP_DATA * HsmCmdVsmInputDataUnencryptedCtx(
+            HsmCmdCtx * ctx,
+            int vssSlotNum,
+            uint32_t * vsmInputDataPtr,
+            unsigned short numDataWords,
+            CmdVSMSlotType slotType,
+            CmdVSMDataSpecificMetaData specMetaData);
+
+    RSP_DATA * HsmCmdVsmOutputDataUnencryptedCtx(
+            HsmCmdCtx * ctx,
+            int vssSlotNum,
+            uint32_t * dataOut,
+            int * dataLenBytes,
+            uint32_t maxDataBytes);
+
     RSP_DATA * HsmCmdVsmInputDataUnencrypted(
             int vssSlotNum,
             uint32_t * vsmInputDataPtr,
@@ -1,105 +1,23 @@
-
-/* ************************************************************************** */
-/* ************************************************************************** */
-/* Section: Included Files                                                    */
 /* ************************************************************************** */
-/* ************************************************************************** */
-
-#ifndef _HSM_COMMAND_GLOBALS /* Guard against multiple inclusion */
-#define _HSM_COMMAND_GLOBALS
-
-#include <stdint.h>
-#include <stdbool.h>
-#include "hsm_command.h"
-
-/* Provide C++ Compatibility */
-#ifdef __cplusplus
-extern "C" {
-#endif
-
-    /* ************************************************************************** */
-    /* ************************************************************************** */
-    /* Section: Definitions and Structs                                           */
-    /* ************************************************************************** */
-    /* ************************************************************************** */
-
-#define MAXSLOTDATABYTES   1024
-#define MAXSLOTDATAWORDS   MAXSLOTDATABYTES/8 
-#define MAX_KEY_LENGTH  CMD_AES_KEY_256
-#define SLOTMETAWORDS      4
-
-
-    //====================================================================== 
-    // Mailbox/Command
-    //====================================================================== 
-
-    //******************************************************************************
-    //  Struct/Class
-    //******************************************************************************
+/** Descriptive File Name
 
-    /* ************************************************************************** */
-    /* ************************************************************************** */
-    /* Section: Externals/Function Prototypes                                               */
-    /* ************************************************************************** */
-    /* ************************************************************************** */
-    extern uint32_t globalMbHeader;
-    extern uint32_t globalCmdHeader;
-    extern uint32_t globalCmdInput;
-    extern uint32_t globalCmdOutput;
-    extern uint32_t globalCmdParams[MAX_CMD_PARAM_WORDS];
+  @Company
+    Microchip Technology
 
-    extern uint32_t * dataPtrOut;
-    extern uint32_t ALIGN4 dmaDataOut[MAX_OUTPUT_DMA_LENGTH];
-    extern uint32_t ALIGN4 keyHostStoragePublic[16];
+  @File Name
+    hsm_command_globals.h
 
-    //HSM Response
-    extern HsmCmdResp gHsmCmdResp;
-    extern RSP_DATA gRspData;
-    extern HsmCmdReq gHsmCmdReq;
+  @Summary
+    HSM Mailbox Command globals (see hsm_api/hsm_command_globals.h)
 
-    //HSM Status
-    //extern bool           busy;  //HSM Busy
-    //extern HsmStatusECODE ecode; //Error Return Code
-    //extern HsmStatusSBS   sbs;   //Secure Boot Status
-    //extern HsmStatusLCS   lcs;   //Lifecycle Status 
-    //extern HsmStatusPS    ps;    //Processor Status
-
-    extern char messageBuffer[5][64];
-
-    extern char * gPrintStr;
-    extern char gPrintBuffer[MAX_PRINT_BYTES];
-
-    //COM UART 
-    extern int volatile gRcvCnt;
-    extern int volatile gRcvCmdRdy;
-
-    extern uint8_t gRcvCmdStr[MAX_PRINT_BYTES];
-
-    //HSM Status Register Fields
-    extern const char * ecodeStr[];
-    extern const char * sbsStr[];
-    extern const char * lcsStr[];
-    extern const char * psStr[];
-    extern char * cmdResultStr[NUMCMDRESULTCODES];
-    extern char * cmdSpecialResultStr[NUMCMDERRORRESULTCODES];
-    extern char * cmdHsmErrorStr[];
-
-    extern CmdSGDescriptor ALIGN4 dmaDescriptorIn[3];
-    extern CmdSGDescriptor ALIGN4 dmaDescriptorOut[3];
-    extern uint32_t ALIGN4 dmaDataIn[MAX_INPUT_DMA_LENGTH];
-
-    extern uint32_t vssSlotData[MAXSLOTDATAWORDS + SLOTMETAWORDS];
-
-    // Function Prototypes
-    char * CmdResultCodeStr(uint32_t cmdResultCode);
-
-
-    /* Provide C++ Compatibility */
-#ifdef __cplusplus
-}
-#endif
+  @Description
+    The HSM mailbox command globals are maintained in 
+    hsm_api/hsm_command_globals.h.  This header is kept so the existing 
+    "hsm_host\hsm_command_globals.h" includes resolve to the same externals.
+ */
+/* ************************************************************************** */
 
-#endif /* _HSM_COMMAND_GLOBALS */
+#include "hsm_api/hsm_command_globals.h"
 
 /* *****************************************************************************
  End of File
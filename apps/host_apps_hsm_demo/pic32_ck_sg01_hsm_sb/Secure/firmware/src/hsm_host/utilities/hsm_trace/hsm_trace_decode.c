@@ -0,0 +1,275 @@
+/* ************************************************************************** */
+/** Descriptive File Name
+
+  @Company
+    Microchip Technology
+
+  @File Name
+    hsm_trace_decode.c
+
+  @Summary
+    Host side decoder of the HSM MB binary trace (hsm_trace.h)
+
+  @Description
+    HOST TOOL -- not part of the firmware project.  Build with any host C
+    compiler, e.g. from the firmware src directory:
+
+        gcc -o hsm_trace_decode -Ihsm_host/hsm_api \
+            hsm_host/utilities/hsm_trace/hsm_trace_decode.c
+
+    Console output of HsmTracePrint() (end of the HSM MB command test
+    suite, HSM_command()), one line per 8 records, the bytes in hex:
+
+        TRACE(<#records><#lost><HsmTraceRecord>...)
+
+        #records  uint32 LE  records in this line (oldest first)
+        #lost     uint32 LE  records overwritten before they were read
+        record    24 bytes   HsmTraceRecord (timestamp, id, seq, arg[4]) LE
+
+    The last line has 0 records.  Save the console output to a file and
+    decode it:
+
+        hsm_trace_decode console.txt        (or from stdin)
+
+    Only the TRACE(...) lines are decoded, the other console lines are
+    skipped.
+ */
+/* ************************************************************************** */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "hsm_trace.h"
+
+#define TRACE_HDR_BYTES     (2 * sizeof(uint32_t))
+#define TRACE_REC_BYTES     24
+#define TRACE_MAX_LINE      8192
+#define TRACE_LINE_TAG      "TRACE("
+
+static const char * traceIdName[] =
+{
+    "NONE", "MB_STATUS", "TX_CMD", "TX_PARAM",
+    "RX_RSP", "CMD_ERR", "RSP_CHK", "RSP_DATA"
+};
+
+static const char * traceTagName[] = { "T0", "T1", "TC", "TF" };
+
+
+//******************************************************************************
+// Little endian field extraction (the host need not be little endian)
+//******************************************************************************
+static uint32_t TraceGet32(const uint8_t * p)
+{
+    return (uint32_t) p[0]         | ((uint32_t) p[1] << 8) |
+           ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static uint16_t TraceGet16(const uint8_t * p)
+{
+    return (uint16_t) (p[0] | (p[1] << 8));
+}
+
+
+//******************************************************************************
+// Convert the hex data of one HsmTracePrint() console line to bytes
+// --Returns #bytes, 0 for other console lines or -1 on a bad TRACE line
+//******************************************************************************
+static int TraceHexToBytes(const char * line, uint8_t * bytes, int maxBytes)
+{
+    const char * hex      = strstr(line, TRACE_LINE_TAG);
+    int          numBytes = 0;
+
+    if (hex == NULL)
+    {
+        return 0;
+    }
+    hex += strlen(TRACE_LINE_TAG);
+
+    while (*hex != '\0' && *hex != ')')
+    {
+        unsigned int byte;
+
+        if (isspace((unsigned char) *hex))
+        {
+            hex++;
+            continue;
+        }
+        if (!isxdigit((unsigned char) hex[0]) ||
+            !isxdigit((unsigned char) hex[1]) ||
+            numBytes >= maxBytes)
+        {
+            return -1;
+        }
+        sscanf(hex, "%2x", &byte);
+        bytes[numBytes++] = (uint8_t) byte;
+        hex += 2;
+    }
+
+    return numBytes;
+} //End TraceHexToBytes()
+
+
+//******************************************************************************
+// Print the HSM_TRACE_RSP_CHK fail mask
+//******************************************************************************
+static void TracePrintChkMask(uint32_t mask)
+{
+    if (mask == 0)
+    {
+        printf(" PASS");
+        return;
+    }
+    if (mask & HSM_TRACE_CHK_MBHEADER)  printf(" MBHEADER");
+    if (mask & HSM_TRACE_CHK_CMDHEADER) printf(" CMDHEADER");
+    if (mask & HSM_TRACE_CHK_RC)        printf(" RC");
+    if (mask & HSM_TRACE_CHK_STATUS)    printf(" STATUS");
+    if (mask & HSM_TRACE_CHK_INTFLAG)   printf(" INTFLAG");
+}
+
+
+//******************************************************************************
+// Print one trace record
+// --delta is the CYCCNT difference to the previous record (mod 2^32)
+//******************************************************************************
+static void TracePrintRecord(const uint8_t * rec, uint32_t * lastTs, int first)
+{
+    uint32_t ts  = TraceGet32(&rec[0]);
+    uint16_t id  = TraceGet16(&rec[4]);
+    uint16_t seq = TraceGet16(&rec[6]);
+    uint32_t arg[HSM_TRACE_ARGS];
+    int      i;
+
+    for (i = 0; i < HSM_TRACE_ARGS; i++)
+    {
+        arg[i] = TraceGet32(&rec[8 + 4 * i]);
+    }
+
+    printf("%5u %10u %+10d  %-9s", seq, ts,
+           first ? 0 : (int32_t) (ts - *lastTs),
+           (id < sizeof(traceIdName) / sizeof(traceIdName[0])) ?
+               traceIdName[id] : "?");
+    *lastTs = ts;
+
+    switch (id)
+    {
+        case HSM_TRACE_MB_STATUS:
+            printf(" %s MBRXSTATUS=%08x MBTXSTATUS=%08x STATUS=%08x",
+                   (arg[0] < 4) ? traceTagName[arg[0]] : "??",
+                   arg[1], arg[2], arg[3]);
+            break;
+
+        case HSM_TRACE_TX_CMD:
+            printf(" MBHDR=%08x CMDHDR=%08x IN=%08x OUT=%08x",
+                   arg[0], arg[1], arg[2], arg[3]);
+            break;
+
+        case HSM_TRACE_TX_PARAM:
+            printf(" param%u=%08x", arg[0], arg[1]);
+            break;
+
+        case HSM_TRACE_RX_RSP:
+            printf(" MBHDR=%08x CMDHDR=%08x RC=%08x #words=%u",
+                   arg[0], arg[1], arg[2], arg[3]);
+            break;
+
+        case HSM_TRACE_CMD_ERR:
+            printf(" RC=%08x STATUS=%08x", arg[0], arg[1]);
+            break;
+
+        case HSM_TRACE_RSP_CHK:
+            printf(" CMDHDR=%08x RC=%08x STATUS=%08x",
+                   arg[0], arg[1], arg[2]);
+            TracePrintChkMask(arg[3]);
+            break;
+
+        default:
+            printf(" %08x %08x %08x %08x", arg[0], arg[1], arg[2], arg[3]);
+            break;
+    }
+    printf("\n");
+} //End TracePrintRecord()
+
+
+//******************************************************************************
+// Decode the saved HsmTracePrint() console output
+//******************************************************************************
+int main(int argc, char * argv[])
+{
+    static char    line[TRACE_MAX_LINE];
+    static uint8_t rsp[TRACE_MAX_LINE / 2];
+    FILE *   in = stdin;
+    uint32_t lastTs = 0;
+    int      first = 1;
+    int      lineNum = 0;
+    unsigned long totalRecords = 0;
+    unsigned long totalLost = 0;
+
+    if (argc > 2)
+    {
+        fprintf(stderr, "usage: %s [trace.txt]\n", argv[0]);
+        return 2;
+    }
+    if (argc == 2 && (in = fopen(argv[1], "r")) == NULL)
+    {
+        perror(argv[1]);
+        return 2;
+    }
+
+    printf("  seq     cycles      delta  event\n");
+
+    while (fgets(line, sizeof(line), in) != NULL)
+    {
+        int      numBytes;
+        uint32_t numRecords;
+        uint32_t numLost;
+        uint32_t i;
+
+        lineNum++;
+        numBytes = TraceHexToBytes(line, rsp, sizeof(rsp));
+        if (numBytes == 0)
+        {
+            continue;
+        }
+        if (numBytes < (int) TRACE_HDR_BYTES)
+        {
+            fprintf(stderr, "line %d: bad trace line\n", lineNum);
+            continue;
+        }
+
+        numRecords = TraceGet32(&rsp[0]);
+        numLost    = TraceGet32(&rsp[4]);
+        if (numBytes != (int) (TRACE_HDR_BYTES + numRecords * TRACE_REC_BYTES))
+        {
+            fprintf(stderr, "line %d: %d bytes for %u records\n",
+                    lineNum, numBytes, numRecords);
+            continue;
+        }
+
+        //#lost is the running count; show where it grew
+        if (numLost > totalLost)
+        {
+            printf("----- %lu records lost -----\n", numLost - totalLost);
+            totalLost = numLost;
+            first = 1;
+        }
+
+        for (i = 0; i < numRecords; i++)
+        {
+            TracePrintRecord(&rsp[TRACE_HDR_BYTES + i * TRACE_REC_BYTES],
+                             &lastTs, first);
+            first = 0;
+        }
+        totalRecords += numRecords;
+    }
+
+    printf("%lu records, %lu lost\n", totalRecords, totalLost);
+
+    if (in != stdin)
+    {
+        fclose(in);
+    }
+    return 0;
+} //End main()
@@ -9,6 +9,7 @@
 #include "user.h"
 //#include "system/system_module.h"
 #include "hsm_test.h"
+#include "hsm_bank.h"
 
 //Create a global Test Data variable so it can be accessed by the interrupt 
 //handler when (int_mode == true)
@@ -39,6 +40,56 @@ uint8_t ALIGN4 expHashBlockResult[SHA256_NUMBYTES] ={
     0x34, 0xbc, 0x33, 0x4a, 0x37, 0x99, 0xbc, 0x68,
 };
 
+//SHA384/SHA512 of hashMsgBlock (HsmCmdHashBlock())
+uint8_t ALIGN4 expHashBlockSha384Result[HASH_SHA384_RESULT_BYTES] ={
+    0x24, 0x40, 0xd0, 0xe7, 0x51, 0xfe, 0x5b, 0x8b,
+    0x1a, 0xba, 0x06, 0x7e, 0x20, 0xbe, 0x00, 0xb9,
+    0xde, 0xec, 0xc5, 0xe2, 0x18, 0xb0, 0xb4, 0xb3,
+    0x72, 0x02, 0xde, 0x82, 0x4b, 0xcd, 0x04, 0x29,
+    0x4d, 0x67, 0xc8, 0xd0, 0xb7, 0x3e, 0x39, 0x3a,
+    0xfa, 0x84, 0x4f, 0xa9, 0xca, 0x25, 0xfa, 0x51,
+};
+
+uint8_t ALIGN4 expHashBlockSha512Result[HASH_SHA512_RESULT_BYTES] ={
+    0x27, 0x98, 0xfd, 0x00, 0x1e, 0xe8, 0x80, 0x0e,
+    0x3d, 0xa0, 0x9e, 0xe9, 0x9a, 0xe9, 0x60, 0x0d,
+    0xe2, 0xd0, 0xcc, 0xf4, 0x64, 0xab, 0x78, 0x2c,
+    0x92, 0xfc, 0xc0, 0x6c, 0xe3, 0x84, 0x7c, 0xef,
+    0x07, 0x43, 0x36, 0x5f, 0x1d, 0x49, 0xc2, 0xc8,
+    0xb4, 0x42, 0x6d, 0xb1, 0x63, 0x54, 0x33, 0xf9,
+    0x37, 0xd5, 0x08, 0x67, 0x2a, 0x9d, 0x0c, 0xb6,
+    0x73, 0xb8, 0x4f, 0x36, 0x8e, 0xca, 0x1b, 0x23,
+};
+
+#if HSM_HASH_STREAM_ENABLE || HSM_HASH_HMAC_ENABLE
+//Hash stream test message (2 x the FIPS 180-2 448 bit message, 112 bytes)
+char hashMsgStream[] = 
+    "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq"
+    "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+#endif //HSM_HASH_STREAM_ENABLE || HSM_HASH_HMAC_ENABLE
+
+#if HSM_HASH_STREAM_ENABLE
+//SHA256 of hashMsgStream
+uint8_t ALIGN4 expHashStreamResult[SHA256_NUMBYTES] ={
+    0x59, 0xf1, 0x09, 0xd9, 0x53, 0x3b, 0x2b, 0x70,
+    0xe7, 0xc3, 0xb8, 0x14, 0xa2, 0xbd, 0x21, 0x8f,
+    0x78, 0xea, 0x5d, 0x37, 0x14, 0x45, 0x5b, 0xc6,
+    0x79, 0x87, 0xcf, 0x0d, 0x66, 0x43, 0x99, 0xcf,
+};
+#endif //HSM_HASH_STREAM_ENABLE
+
+#if HSM_HASH_HMAC_ENABLE
+//HMAC key ("Jefe", RFC 4231 test case 2) and HMAC-SHA256 of hashMsgStream
+char hmacKey[] = "Jefe";
+
+uint8_t ALIGN4 expHmacSha256Result[HASH_SHA256_RESULT_BYTES] ={
+    0xe3, 0x00, 0xa8, 0x49, 0xa3, 0x93, 0xfb, 0xf5,
+    0xe1, 0xeb, 0xf3, 0xa4, 0xdc, 0x3a, 0x6a, 0x7e,
+    0xe6, 0xdf, 0x36, 0x40, 0x4a, 0x52, 0x3b, 0x51,
+    0xe8, 0x55, 0xe5, 0x32, 0x18, 0xa8, 0x70, 0xa1,
+};
+#endif //HSM_HASH_HMAC_ENABLE
+
 //VSM_INPUT_DATA Test  
 //   Wrapped AES-GSM Key - 48 Bytes (If Used)
 //   Length of VS Data - 4 bytes
@@ -202,6 +253,459 @@ bool TestHsmCmdHashBlockSha256() {
 } //End HsmCmdHashBlockSha256() 
 
 
+//******************************************************************************
+//HASH BLOCK Command Test (SHA384/SHA512, HsmCmdHashBlock())
+//--Returns true on FAIL
+//******************************************************************************
+
+bool TestHsmCmdHashBlockSha384Sha512(void) {
+    CmdHashTypes hashType[] = {CMD_HASH_SHA384, CMD_HASH_SHA512};
+    uint8_t * expResult[] = {expHashBlockSha384Result, expHashBlockSha512Result};
+    RSP_DATA * rsp;
+    uint32_t digestBytes;
+    bool ret_val = false;
+    int i;
+
+    SYS_PRINT("\r\n---------------------------------------------\r\n");
+    SYS_MESSAGE("**HSM HASH BLOCK SHA384/SHA512 TEST**\r\n");
+
+    for (i = 0; i < 2; i++) {
+        digestBytes = HsmHashDigestBytes(hashType[i]);
+        memset(hashBuffer, 0, sizeof (hashBuffer));
+
+        rsp = HsmCmdHashBlock(hashType[i], (uint8_t *) hashMsgBlock,
+                strlen(hashMsgBlock), hashBuffer);
+        if (rsp->rspChksPassed != true) {
+            SYS_PRINT("SHA%d FAIL: RC: %s\r\n", (int) digestBytes * 8,
+                    CmdResultCodeStr(rsp->resultCode));
+            ret_val = true;
+        } else if (memcmp(hashBuffer, expResult[i], digestBytes) != 0) {
+            SYS_PRINT("SHA%d FAIL: !!!CMD_HASH_BLOCK DATA OUT ERROR!!!\r\n",
+                    (int) digestBytes * 8);
+            ret_val = true;
+        } else {
+            SYS_PRINT("SHA%d Pass: CMD_HASH_BLOCK DATA OUT VALID\r\n",
+                    (int) digestBytes * 8);
+        }
+    }
+
+    SYS_MESSAGE("HSM: CMD_HASH_BLOCK SHA384/SHA512 Complete\r\n");
+
+    return ret_val;
+
+} //End TestHsmCmdHashBlockSha384Sha512()
+
+
+//******************************************************************************
+//HSM MB Command Queue Test
+//--SHA256/SHA384/SHA512 HASH BLOCK commands queued back to back (interrupt
+//  mode, sent by the queue dispatcher), then a rejected request (invalid
+//  hash type, completes with E_INVPARAM without being sent).
+//--Each response is checked in its completion callback, in queue order.
+//--Returns true on FAIL
+//******************************************************************************
+
+#define HSM_QUEUE_TEST_CMDS 4
+
+typedef struct
+{
+    int          order[HSM_QUEUE_TEST_CMDS];  //Command index per completion
+    bool         passed[HSM_QUEUE_TEST_CMDS];
+    uint32_t     resultCode[HSM_QUEUE_TEST_CMDS];
+    volatile int numDone;
+} HsmQueueTestResults;
+
+static HsmQueueTestResults queueTestResults;
+static const int queueTestIndex[HSM_QUEUE_TEST_CMDS] = {0, 1, 2, 3};
+
+//Completion callback (RXINT):  context is the command index
+static void TestHsmCmdQueueDone(HsmCmdCtx * ctx, void * context) {
+    HsmQueueTestResults * results = &queueTestResults;
+    int cmd = *(const int *) context;
+
+    if (results->numDone < HSM_QUEUE_TEST_CMDS) {
+        results->order[results->numDone] = cmd;
+    }
+    if (cmd >= 0 && cmd < HSM_QUEUE_TEST_CMDS) {
+        results->passed[cmd] = ctx->rspData.rspChksPassed;
+        results->resultCode[cmd] = ctx->rsp.resultCode;
+    }
+    results->numDone++;
+}
+
+bool TestHsmCmdQueue(void) {
+    static uint8_t ALIGN4 queueHash[HSM_QUEUE_TEST_CMDS][HASH_SHA512_RESULT_BYTES];
+    CmdHashTypes hashType[HSM_QUEUE_TEST_CMDS] = {
+        CMD_HASH_SHA256, CMD_HASH_SHA384, CMD_HASH_SHA512, (CmdHashTypes) 0
+    };
+    uint8_t * expResult[HSM_QUEUE_TEST_CMDS] = {
+        expHashBlockResult, expHashBlockSha384Result, expHashBlockSha512Result,
+        NULL
+    };
+    HsmQueueTestResults * results = &queueTestResults;
+    HsmCmdQueueEntry * entry;
+    bool ret_val = false;
+    int i;
+
+    SYS_PRINT("\r\n---------------------------------------------\r\n");
+    SYS_MESSAGE("**HSM MB COMMAND QUEUE TEST**\r\n");
+
+    memset(results, 0, sizeof (HsmQueueTestResults));
+    memset(queueHash, 0, sizeof (queueHash));
+
+    for (i = 0; i < HSM_QUEUE_TEST_CMDS; i++) {
+        entry = HsmCmdQueueAlloc();
+        if (entry == NULL) {
+            SYS_PRINT("QUEUE FAIL: Queue full at command %d\r\n", i);
+            return true;
+        }
+        HsmCmdHashBlockPrep(&entry->ctx, hashType[i],
+                (uint8_t *) hashMsgBlock, strlen(hashMsgBlock), queueHash[i]);
+        HsmCmdQueueSubmit(entry, TestHsmCmdQueueDone,
+                (void *) &queueTestIndex[i]);
+    }
+
+    HsmCmdQueueFlush();
+
+    for (i = 0; i < HSM_QUEUE_TEST_CMDS; i++) {
+        if (results->numDone != HSM_QUEUE_TEST_CMDS || results->order[i] != i) {
+            SYS_PRINT("QUEUE FAIL: Completion %d out of order\r\n", i);
+            ret_val = true;
+        } else if (expResult[i] == NULL) {
+            if (results->passed[i] || results->resultCode[i] != E_INVPARAM) {
+                SYS_MESSAGE("QUEUE FAIL: !!!Invalid request not rejected!!!\r\n");
+                ret_val = true;
+            }
+        } else if (results->passed[i] != true) {
+            SYS_PRINT("QUEUE FAIL: Command %d RC: %s\r\n", i,
+                    CmdResultCodeStr(results->resultCode[i]));
+            ret_val = true;
+        } else if (memcmp(queueHash[i], expResult[i],
+                HsmHashDigestBytes(hashType[i])) != 0) {
+            SYS_PRINT("QUEUE FAIL: !!!Command %d DATA OUT ERROR!!!\r\n", i);
+            ret_val = true;
+        }
+    }
+
+    if (ret_val == false) {
+        SYS_PRINT("QUEUE Pass: %d queued commands VALID\r\n",
+                HSM_QUEUE_TEST_CMDS);
+    }
+
+    SYS_MESSAGE("HSM: MB COMMAND QUEUE Complete\r\n");
+
+    return ret_val;
+
+} //End TestHsmCmdQueue()
+
+
+//******************************************************************************
+//HSM Command Bank Test
+//--SHA256 HASH BLOCK commands through a command bank, more commands than 
+//  HSM_CMD_BANKS (HsmCmdBankPrepare() collects the earlier ones), checked
+//  in their callbacks.
+//--A command prepared with a SG pool chain and never submitted:  
+//  HsmCmdBankFlush() gives its descriptors back, no callback.
+//--Returns true on FAIL
+//******************************************************************************
+
+#define HSM_BANK_TEST_CMDS (HSM_CMD_BANKS + 1)
+
+static uint8_t ALIGN4 bankTestHash[HSM_BANK_TEST_CMDS][SHA256_NUMBYTES];
+static bool bankTestPassed[HSM_BANK_TEST_CMDS];
+static int bankTestNumDone;
+
+//Bank completion callback (caller context):  context is the digest buffer
+static void TestHsmCmdBankDone(HsmCmdCtx * ctx, void * context) {
+    int cmd = ((uint8_t (*)[SHA256_NUMBYTES]) context) - bankTestHash;
+
+    if (cmd >= 0 && cmd < HSM_BANK_TEST_CMDS) {
+        bankTestPassed[cmd] = ctx->rspData.rspChksPassed &&
+                (memcmp(bankTestHash[cmd], expHashBlockResult,
+                SHA256_NUMBYTES) == 0);
+    }
+    bankTestNumDone++;
+}
+
+bool TestHsmCmdBank(void) {
+    HsmCmdBank bank;
+    HsmCmdCtx * ctx;
+    HsmSGSegment seg;
+    CmdSGDescriptor * sgIn;
+    int numDataInBytes = strlen(hashMsgBlock);
+    int poolAvail;
+    bool ret_val = false;
+    int i;
+
+    SYS_PRINT("\r\n---------------------------------------------\r\n");
+    SYS_MESSAGE("**HSM COMMAND BANK TEST**\r\n");
+
+    memset(bankTestHash, 0, sizeof (bankTestHash));
+    memset(bankTestPassed, 0, sizeof (bankTestPassed));
+    bankTestNumDone = 0;
+    HsmCmdBankInit(&bank);
+
+    for (i = 0; i < HSM_BANK_TEST_CMDS; i++) {
+        ctx = HsmCmdBankPrepare(&bank);
+        HsmCmdHashBlockSha256Prep(ctx, (uint8_t *) hashMsgBlock,
+                numDataInBytes, bankTestHash[i]);
+        if (!HsmCmdBankSubmit(&bank, ctx, TestHsmCmdBankDone,
+                bankTestHash[i])) {
+            SYS_PRINT("BANK FAIL: Command %d not sent\r\n", i);
+            ret_val = true;
+        }
+    }
+    HsmCmdBankFlush(&bank);
+
+    for (i = 0; i < HSM_BANK_TEST_CMDS; i++) {
+        if (bankTestPassed[i] != true) {
+            SYS_PRINT("BANK FAIL: !!!Command %d DATA OUT ERROR!!!\r\n", i);
+            ret_val = true;
+        }
+    }
+    if (bankTestNumDone != HSM_BANK_TEST_CMDS) {
+        SYS_PRINT("BANK FAIL: %d of %d commands collected\r\n",
+                bankTestNumDone, HSM_BANK_TEST_CMDS);
+        ret_val = true;
+    }
+
+    //Prepared, not submitted
+    poolAvail = HsmSGPoolAvail();
+    seg.addr = hashMsgBlock;
+    seg.numBytes = numDataInBytes;
+    sgIn = HsmSGChainAlloc(&seg, 1);
+    if (sgIn == NULL) {
+        SYS_MESSAGE("BANK FAIL: SG pool empty\r\n");
+        return true;
+    }
+    ctx = HsmCmdBankPrepare(&bank);
+    HsmCmdHashBlockSha256Prep(ctx, NULL, numDataInBytes, bankTestHash[0]);
+    HsmSGCtxSet(ctx, sgIn, NULL);
+    HsmCmdBankFlush(&bank);
+
+    if (HsmSGPoolAvail() != poolAvail) {
+        SYS_PRINT("BANK FAIL: !!!SG pool %d of %d descriptors back!!!\r\n",
+                HsmSGPoolAvail(), poolAvail);
+        ret_val = true;
+    }
+    if (bankTestNumDone != HSM_BANK_TEST_CMDS) {
+        SYS_MESSAGE("BANK FAIL: !!!Callback of a command not sent!!!\r\n");
+        ret_val = true;
+    }
+
+    if (ret_val == false) {
+        SYS_PRINT("BANK Pass: %d bank commands VALID\r\n",
+                HSM_BANK_TEST_CMDS);
+    }
+
+    SYS_MESSAGE("HSM: COMMAND BANK Complete\r\n");
+
+    return ret_val;
+
+} //End TestHsmCmdBank()
+
+
+//******************************************************************************
+//HASH BLOCK Command Test (SHA256, fragmented input)
+//--hashMsgBlock in 3 segments (4/3/4 bytes), one SG pool descriptor each
+//  (HsmCmdHashBlockSha256SGCtx())
+//--Returns true on FAIL
+//******************************************************************************
+
+bool TestHsmCmdHashBlockSha256SG(void) {
+    HsmSGSegment seg[3] = {
+        {hashMsgBlock, 4},
+        {hashMsgBlock + 4, 3},
+        {hashMsgBlock + 7, 4},
+    };
+    RSP_DATA * rsp;
+    int poolAvail = HsmSGPoolAvail();
+    bool ret_val = false;
+
+    SYS_PRINT("\r\n---------------------------------------------\r\n");
+    SYS_MESSAGE("**HSM HASH BLOCK SHA256 SG TEST**\r\n");
+
+    memset(hashBuffer, 0, sizeof (hashBuffer));
+    rsp = HsmCmdHashBlockSha256SGCtx(&gHsmCmdCtx, seg, 3, hashBuffer);
+
+    if (rsp->rspChksPassed != true) {
+        SYS_PRINT("SHA256 SG FAIL: RC: %s\r\n",
+                CmdResultCodeStr(rsp->resultCode));
+        ret_val = true;
+    } else if (memcmp(hashBuffer, expHashBlockResult, SHA256_NUMBYTES) != 0) {
+        SYS_MESSAGE("SHA256 SG FAIL: !!!CMD_HASH_BLOCK DATA OUT ERROR!!!\r\n");
+        ret_val = true;
+    } else {
+        SYS_MESSAGE("SHA256 SG Pass: CMD_HASH_BLOCK DATA OUT VALID\r\n");
+    }
+
+    if (HsmSGPoolAvail() != poolAvail) {
+        SYS_MESSAGE("SHA256 SG FAIL: !!!SG chain not freed!!!\r\n");
+        ret_val = true;
+    }
+
+    SYS_MESSAGE("HSM: CMD_HASH_BLOCK SHA256 SG Complete\r\n");
+
+    return ret_val;
+
+} //End TestHsmCmdHashBlockSha256SG()
+
+
+#if HSM_HASH_STREAM_ENABLE
+//******************************************************************************
+//HASH INIT/UPDATE/FINALIZE Command Test (SHA256 stream)
+//--Two streams of the message, interleaved:  A in 3 pieces (10/60/42 bytes),
+//  B in 3 pieces (64/1/47 bytes), i.e. partial and whole blocks held back
+//  over the UPDATE commands.  Each stream has its own state (HsmHashCtx).
+//--Returns true on FAIL
+//******************************************************************************
+
+bool TestHsmCmdHashSha256Stream(void) {
+    RSP_DATA * rsp;
+    HsmHashCtx hashA;
+    HsmHashCtx hashB;
+    uint8_t ALIGN4 digestB[SHA256_NUMBYTES];
+    uint32_t pieceBytesA[] = {10, 60, 42};
+    uint32_t pieceBytesB[] = {64, 1, 47};
+    uint32_t offsetA = 0;
+    uint32_t offsetB = 0;
+    bool ret_val = false;
+    int i;
+
+    SYS_PRINT("\r\n---------------------------------------------\r\n");
+    SYS_MESSAGE("**HSM HASH SHA256 STREAM TEST**\r\n");
+
+    memset(hashBuffer, 0, sizeof (hashBuffer));
+    memset(digestB, 0, sizeof (digestB));
+
+    rsp = HsmCmdHashInitCtx(&gHsmCmdCtx, &hashA, CMD_HASH_SHA256);
+    if (rsp->rspChksPassed == true) {
+        rsp = HsmCmdHashInitCtx(&gHsmCmdCtx, &hashB, CMD_HASH_SHA256);
+    }
+    for (i = 0; i < 3 && rsp->rspChksPassed == true; i++) {
+        rsp = HsmCmdHashUpdateCtx(&gHsmCmdCtx, &hashA,
+                (uint8_t *) &hashMsgStream[offsetA], pieceBytesA[i]);
+        offsetA += pieceBytesA[i];
+        if (rsp->rspChksPassed != true) break;
+        rsp = HsmCmdHashUpdateCtx(&gHsmCmdCtx, &hashB,
+                (uint8_t *) &hashMsgStream[offsetB], pieceBytesB[i]);
+        offsetB += pieceBytesB[i];
+    }
+    if (rsp->rspChksPassed == true) {
+        rsp = HsmCmdHashFinalCtx(&gHsmCmdCtx, &hashA, hashBuffer);
+    }
+    if (rsp->rspChksPassed == true) {
+        rsp = HsmCmdHashFinalCtx(&gHsmCmdCtx, &hashB, digestB);
+    }
+
+    if (rsp->rspChksPassed != true) {
+        SYS_PRINT("SHA256 FAIL: Stream RC: %s\r\n",
+                CmdResultCodeStr(rsp->resultCode));
+        ret_val = true;
+    } else if (memcmp(hashBuffer, expHashStreamResult, SHA256_NUMBYTES) != 0) {
+        SYS_MESSAGE("SHA256 FAIL: !!!Stream A DATA OUT ERROR!!!\r\n");
+        ret_val = true;
+    } else if (memcmp(digestB, expHashStreamResult, SHA256_NUMBYTES) != 0) {
+        SYS_MESSAGE("SHA256 FAIL: !!!Stream B DATA OUT ERROR!!!\r\n");
+        ret_val = true;
+    } else {
+        SYS_MESSAGE("SHA256 Pass: Interleaved Streams DATA OUT VALID\r\n");
+    }
+
+    SYS_MESSAGE("HSM: CMD_HASH SHA256 Stream Complete\r\n");
+
+    return ret_val;
+
+} //End TestHsmCmdHashSha256Stream()
+#endif //HSM_HASH_STREAM_ENABLE
+
+
+#if HSM_HASH_HMAC_ENABLE
+//******************************************************************************
+//HMAC Command Test (HMAC-SHA256, key in a RAW VSM slot)
+//--Generate, verify and bad HMAC verify (one shot).
+//  The slot is deleted at the end.
+//--Returns true on FAIL
+//******************************************************************************
+
+bool TestHsmCmdHmacSha256Slot(int vssSlotNum) {
+    uint32_t ALIGN4 slotInput[VSS_META_WORDS + 1 + 1];
+    uint8_t ALIGN4 mac[HASH_SHA256_RESULT_BYTES];
+    CmdVSMDataSpecificMetaData specMetaData;
+    RSP_DATA * rsp;
+    uint32_t keyBytes = strlen(hmacKey);
+    bool ret_val = false;
+
+    SYS_PRINT("\r\n---------------------------------------------\r\n");
+    SYS_PRINT("**HSM HMAC SHA256 TEST (Key Slot %d)**\r\n", vssSlotNum);
+
+    //RAW slot with the key (one word, the SG length word after it)
+    memset(slotInput, 0, sizeof (slotInput));
+    specMetaData.v = 0;
+    specMetaData.rawMeta.s.length = keyBytes;
+    slotInput[0] = keyBytes + VSS_META_BYTES;
+    slotInput[1] = 0x00000000; //Valid Before
+    slotInput[2] = 0xFFFFFFFF; //Valid After
+    slotInput[3] = specMetaData.v;
+    memcpy(&slotInput[VSS_META_WORDS], hmacKey, keyBytes);
+
+    rsp = HsmCmdVsmInputDataUnencrypted(vssSlotNum, slotInput,
+            VSS_META_WORDS + 1, CMD_VSS_RAW, specMetaData);
+    if (rsp->rspChksPassed != true) {
+        SYS_MESSAGE("HMAC FAIL: !!!Key Slot Input ERROR!!!\r\n");
+        return true;
+    }
+
+    //Generate (one shot)
+    rsp = HsmCmdHmacGenerate(vssSlotNum, CMD_HASH_SHA256,
+            (uint8_t *) hashMsgStream, strlen(hashMsgStream),
+            mac, sizeof (mac));
+    if (rsp->rspChksPassed != true) {
+        SYS_PRINT("HMAC FAIL: Generate RC: %s\r\n",
+                CmdResultCodeStr(rsp->resultCode));
+        ret_val = true;
+    } else if (memcmp(mac, expHmacSha256Result, sizeof (mac)) != 0) {
+        SYS_MESSAGE("HMAC FAIL: !!!HMAC ERROR!!!\r\n");
+        ret_val = true;
+    } else {
+        SYS_MESSAGE("HMAC Pass: Generate VALID\r\n");
+    }
+
+    //Verify (one shot)
+    rsp = HsmCmdHmacVerify(vssSlotNum, CMD_HASH_SHA256,
+            (uint8_t *) hashMsgStream, strlen(hashMsgStream),
+            expHmacSha256Result, sizeof (expHmacSha256Result));
+    if (rsp->rspChksPassed != true) {
+        SYS_PRINT("HMAC FAIL: Verify RC: %s\r\n",
+                CmdResultCodeStr(rsp->resultCode));
+        ret_val = true;
+    } else {
+        SYS_MESSAGE("HMAC Pass: Verify VALID\r\n");
+    }
+
+    //Verify a bad HMAC (must fail)
+    memcpy(mac, expHmacSha256Result, sizeof (mac));
+    mac[7] ^= 0x01;
+    rsp = HsmCmdHmacVerify(vssSlotNum, CMD_HASH_SHA256,
+            (uint8_t *) hashMsgStream, strlen(hashMsgStream),
+            mac, sizeof (mac));
+    if (rsp->rspChksPassed == true || rsp->resultCode != E_INPUTAUTH) {
+        SYS_MESSAGE("HMAC FAIL: !!!Bad HMAC not detected!!!\r\n");
+        ret_val = true;
+    } else {
+        SYS_MESSAGE("HMAC Pass: Bad HMAC detected\r\n");
+    }
+
+    HsmCmdVsmDeleteSlot(vssSlotNum);
+
+    SYS_MESSAGE("HSM: CMD_HASH_HMAC SHA256 Complete\r\n");
+
+    return ret_val;
+
+} //End TestHsmCmdHmacSha256Slot()
+#endif //HSM_HASH_HMAC_ENABLE
+
+
 //******************************************************************************
 //******************************************************************************
 
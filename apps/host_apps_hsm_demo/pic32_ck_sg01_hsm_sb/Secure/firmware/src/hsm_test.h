@@ -60,6 +60,16 @@ extern "C" {
 
     //TEST Cmds
     bool TestHsmCmdHashBlockSha256(void);
+    bool TestHsmCmdHashBlockSha384Sha512(void);
+    bool TestHsmCmdQueue(void);
+    bool TestHsmCmdBank(void);
+    bool TestHsmCmdHashBlockSha256SG(void);
+#if HSM_HASH_STREAM_ENABLE
+    bool TestHsmCmdHashSha256Stream(void);
+#endif //HSM_HASH_STREAM_ENABLE
+#if HSM_HASH_HMAC_ENABLE
+    bool TestHsmCmdHmacSha256Slot(int vssSlotNum);
+#endif //HSM_HASH_HMAC_ENABLE
     bool TestHsmCmdVsmInputDataUnencryptedRaw(int vssSlotNum, VssKeySize keySize);
     bool TestHsmCmdVsmOutputDataUnencryptedRaw(int vssSlotNum, VssKeySize keySize);
     bool TestHsmCmdVsmDeleteSlot(int vssSlotNum); //Slot 1
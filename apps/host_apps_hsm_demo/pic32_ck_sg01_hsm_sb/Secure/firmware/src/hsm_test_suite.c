@@ -56,6 +56,13 @@ int hsm_test_suite(int vsSlotNum, int aesSlotNum) {
 #if 1    
     //HASH Test Suite
     TestHsmCmdHashBlockSha256();
+    TestHsmCmdHashBlockSha384Sha512();
+    TestHsmCmdQueue();
+    TestHsmCmdBank();
+    TestHsmCmdHashBlockSha256SG();
+#if HSM_HASH_STREAM_ENABLE
+    TestHsmCmdHashSha256Stream();
+#endif //HSM_HASH_STREAM_ENABLE
 
     //VSM Raw 256 Bit Key Tests
     TestHsmCmdVsmInputDataUnencryptedRaw(vsSlotNum, VSS_KEY_256);
@@ -84,6 +91,14 @@ int hsm_test_suite(int vsSlotNum, int aesSlotNum) {
     }
 #endif //0
 
+    //VSM Slot Metadata Cache
+    TestHsmCmdVsmSlotCache(vsSlotNum);
+
+#if HSM_HASH_HMAC_ENABLE
+    //HMAC (key in a VSM slot)
+    TestHsmCmdHmacSha256Slot(vsSlotNum);
+#endif //HSM_HASH_HMAC_ENABLE
+
 #if 1
     //AES
     if (aesSlotNum > MINSLOTNUM && aesSlotNum < MAXSLOTNUM) {
@@ -107,6 +122,27 @@ int hsm_test_suite(int vsSlotNum, int aesSlotNum) {
 
     //AES Encryption on Test Data G1 T1
     TestHsmCmdAesEcbG1T1(noSlot);
+
+    //AES CBC (NIST SP 800-38A)
+    TestHsmCmdAes128Cbc();
+
+    //AES CTR (NIST SP 800-38A)
+    TestHsmCmdAes128Ctr();
+
+    //AES ECB Batch
+    TestHsmCmdAes128EcbBatch();
+
+    //AES CBC streams (context save/restore)
+    TestHsmCmdAes128CbcInterleave();
+
+    //AES ECB key pointer promoted to a VM_STORAGE slot
+    TestHsmCmdAes128EcbKeySlot();
+
+    //AES CBC PKCS#7 padding (byte length, in place)
+    TestHsmCmdAes128CbcPad();
+
+    //AES CBC/CTR over several HSM_AES_CHUNK_BYTES commands
+    TestHsmCmdAes128Chunks();
 #endif //0
 
     //    LED1_On();
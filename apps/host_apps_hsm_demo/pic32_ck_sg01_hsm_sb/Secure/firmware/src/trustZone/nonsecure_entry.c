@@ -62,4 +62,8 @@ bool __attribute__((cmse_nonsecure_entry)) HSM_Wait_Secure() {
 
 void __attribute__((cmse_nonsecure_entry)) HSM_command_Secure() {
      HSM_command();
+}
+
+void __attribute__((cmse_nonsecure_entry)) HSM_Tasks_Secure() {
+     HSM_Tasks();
 }
\ No newline at end of file
@@ -341,6 +341,72 @@ bool TestHsmCmdVsmOutputDataUnencryptedAes(int vssSlotNum) {
 } //End TestHsmCmdVsmOutputDataUnencryptedAes())
 
 
+//******************************************************************************
+//VSM Slot Metadata Cache
+//  --The first lookup after CMD_VSM_INPUT_DATA sends CMD_VSM_SLOT_GET_INFO,
+//    the next one is from the cache (no command in the lookup ctx). 
+//  --After CMD_VSM_DELETE_SLOT the slot is empty without a command.
+//******************************************************************************
+
+bool TestHsmCmdVsmSlotCache(int vssSlotNum) {
+    static HsmCmdCtx ctx;
+    VSMetaData vsMetaData;
+    VSMetaData vsCached;
+    uint32_t slotSizeBytes;
+    CmdResultCodes rcode;
+    RSP_DATA * rsp;
+    bool ret_val = false;
+
+    SYS_PRINT("\r\n---------------------------------------------\r\n");
+    SYS_PRINT("**VSM SLOT METADATA CACHE TEST (Slot %d)**\r\n", vssSlotNum);
+
+    if (TestHsmCmdVsmInputDataUnencryptedAes(vssSlotNum)) {
+        SYS_MESSAGE("VSM FAIL: !!!Slot Cache Test ABORT - Slot Input!!!\r\n");
+        return true;
+    }
+
+    //Miss:  Slot info command
+    ctx.req.cmdHeader = 0;
+    rcode = HsmCmdVsmGetSlotInfoCachedCtx(&ctx, vssSlotNum,
+            &vsMetaData, &slotSizeBytes);
+    if (rcode != S_OK || ctx.req.cmdHeader != CMD_VSM_SLOT_GET_INFO_INST ||
+            vsMetaData.vsHeader.s.vsSlotNum != vssSlotNum) {
+        SYS_PRINT("VSM FAIL: Slot Cache Miss (%s)\r\n",
+                CmdResultCodeStr(rcode));
+        ret_val = true;
+    }
+
+    //Hit:  Same metadata, no command
+    ctx.req.cmdHeader = 0;
+    rcode = HsmCmdVsmGetSlotInfoCachedCtx(&ctx, vssSlotNum,
+            &vsCached, &slotSizeBytes);
+    if (rcode != S_OK || ctx.req.cmdHeader != 0 ||
+            memcmp(&vsCached, &vsMetaData, sizeof (vsCached)) != 0) {
+        SYS_MESSAGE("VSM FAIL: Slot Cache Hit\r\n");
+        ret_val = true;
+    }
+
+    //Deleted:  Empty, no command
+    rsp = HsmCmdVsmDeleteSlot(vssSlotNum);
+    ctx.req.cmdHeader = 0;
+    rcode = HsmCmdVsmGetSlotInfoCachedCtx(&ctx, vssSlotNum,
+            &vsCached, &slotSizeBytes);
+    if (rsp->rspChksPassed != true || rcode != E_VSEMPTY ||
+            ctx.req.cmdHeader != 0) {
+        SYS_MESSAGE("VSM FAIL: Slot Cache Delete\r\n");
+        ret_val = true;
+    }
+
+    if (ret_val == false) {
+        SYS_PRINT("VSM Pass: Slot %d Metadata Cache\r\n", vssSlotNum);
+    }
+
+    SYS_PRINT("HSM TEST: VSM SLOT METADATA CACHE Complete\r\n");
+    return ret_val;
+
+} //End TestHsmCmdVsmSlotCache()
+
+
 
 /* *****************************************************************************
  End of File
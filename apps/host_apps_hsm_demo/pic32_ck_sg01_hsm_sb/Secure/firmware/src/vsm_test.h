@@ -40,6 +40,7 @@ extern "C" {
     //TEST Cmds
     bool TestHsmCmdVsmInputDataUnencryptedAes(int vssSlotNum);
     bool TestHsmCmdVsmOutputDataUnencryptedAes(int vssSlotNum);
+    bool TestHsmCmdVsmSlotCache(int vssSlotNum);
 
     //Commands
     //int HsmVsmSlotGetInfo(int vssSlotNum, bool int_mode); 